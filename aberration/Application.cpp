@@ -3,9 +3,11 @@
 #include "utils/Log.h"
 #include "platform/Window.h"
 #include "renderer/Renderer2D.h"
+#include "renderer/StreamBuffer.h"
 #include "platform/Common.h"
 #include "platform/API/OpenGL/OpenGL.h"
 #include "platform/Memory.h"
+#include "AssetManager.h"
 
 namespace AB {
 
@@ -27,7 +29,7 @@ namespace AB {
 		WindowCreate("Aberration", 1280, 720, true, 4);
 		WindowEnableVSync(true);
 		
-
+		GetMemory()->perm_storage.stream_buffer = StreamBufferCreate(STREAM_BUFFER_DEFAULT_FRAME_SIZE);
 		Renderer2DInitialize(1280, 720);
 
 		app->running_time = AB::GetCurrentRawTime();
@@ -44,6 +46,13 @@ namespace AB {
 		}
 
 		while (AB::WindowIsOpen()) {
+			StreamBufferBeginFrame(PermStorage()->stream_buffer);
+
+			AssetManager* asset_mgr = PermStorage()->asset_manager;
+			if (asset_mgr) {
+				AssetProcessCompletions(asset_mgr);
+			}
+
 			if (tick_timer <= 0) {
 				tick_timer = SECOND_INTERVAL;
 				app->ups = updates_since_last_tick;
@@ -68,6 +77,7 @@ namespace AB {
 			}
 			
 			AB::Renderer2DFlush();
+			StreamBufferEndFrame(PermStorage()->stream_buffer);
 			//AB::Window::PollEvents();
 			AB::WindowSwapBuffers();
 
@@ -77,7 +87,13 @@ namespace AB {
 			tick_timer -= app->frame_time;
 			update_timer -= app->frame_time;
 			app->fps = SECOND_INTERVAL / app->frame_time;
+
+			FrameStorageReset();
 		}
+
+		// NOTE: Closing only hides the window, so GL context is still current here
+		StreamBufferDestroy(PermStorage()->stream_buffer);
+		GetMemory()->perm_storage.stream_buffer = nullptr;
 	}
 
 	void AppSetInitCallback(Application* app, InitCallback* proc) {
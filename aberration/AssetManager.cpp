@@ -4,19 +4,250 @@
 #include "platform/API/OpenGL/OpenGL.h"
 #include "platform/Common.h"
 #include "FileFormats.h"
+#include "Compression.h"
 #include <vector>
 #include "utils/ImageLoader.h"
 
 namespace AB {
 
+	static void _AssetStreamerInit(AssetStreamer* streamer, AssetPackTable* packs);
+
 	AssetManager* AssetInitialize() {
 		AssetManager** mgr = &GetMemory()->perm_storage.asset_manager;
 		if (!(*mgr)) {
 			(*mgr) = (AssetManager*)SysAlloc(sizeof(AssetManager));
+			PoolInit(&(*mgr)->mesh_pool, (*mgr)->meshes, sizeof(Mesh), MESH_STORAGE_CAPACITY);
+			PoolInit(&(*mgr)->texture_pool, (*mgr)->textures, sizeof(Texture), TEXTURE_STORAGE_CAPACITY);
+			SizeClassInit(&(*mgr)->asset_heap);
+			_AssetStreamerInit(&(*mgr)->streamer, &(*mgr)->packs);
 		}
 		return (*mgr);
 	}
 
+	inline static bool32 _AssetIsPathSeparator(char c) {
+		return c == '/' || c == '\\';
+	}
+
+	// NOTE: Slashes and backslashes are considered equal.
+	// Returns size of matched prefix or -1
+	static int64 _AssetMatchPathPrefix(const char* path, const char* prefix) {
+		int64 i = 0;
+		for (; prefix[i]; i++) {
+			bool32 equal = path[i] == prefix[i] || (_AssetIsPathSeparator(path[i]) && _AssetIsPathSeparator(prefix[i]));
+			if (!equal) {
+				return -1;
+			}
+		}
+		return i;
+	}
+
+	bool32 AssetMountPack(AssetManager* mgr, const char* pack_path, const char* mount_prefix) {
+		bool32 result = false;
+		AssetPackTable* packs = &mgr->packs;
+		uint64 prefix_size = strlen(mount_prefix);
+		if (packs->count == ASSET_MAX_MOUNTED_PACKS) {
+			AB_CORE_ERROR("Failed to mount asset pack: %s. Too many packs mounted.", pack_path);
+		} else if (prefix_size + 2 > ASSET_PATH_SIZE) {
+			AB_CORE_ERROR("Failed to mount asset pack: %s. Too long mount prefix.", pack_path);
+		} else {
+			MappedFile file = DebugMapFile(pack_path);
+			if (file.data) {
+				byte* begin = (byte*)file.data;
+				ABPackHeader* header = (ABPackHeader*)begin;
+				bool32 valid = file.size >= sizeof(ABPackHeader)
+					&& header->magic_value == ABP_FILE_MAGIC_VALUE
+					&& header->version == ABP_FILE_VERSION
+					&& header->toc_capacity && (header->toc_capacity & (header->toc_capacity - 1)) == 0
+					&& header->toc_offset + header->toc_capacity * sizeof(ABPackEntry) <= file.size
+					&& header->names_offset + header->names_size <= file.size
+					&& header->names_size && begin[header->names_offset + header->names_size - 1] == '\0';
+				if (valid) {
+					ABPackEntry* toc = (ABPackEntry*)(begin + header->toc_offset);
+					for (uint32 i = 0; i < header->toc_capacity; i++) {
+						if (toc[i].name_hash && (toc[i].offset + toc[i].size > file.size || toc[i].name_offset >= header->names_size)) {
+							valid = false;
+							break;
+						}
+					}
+				}
+
+				if (valid) {
+					AssetPack* pack = &packs->packs[packs->count];
+					pack->file = file;
+					pack->header = header;
+					pack->toc = (ABPackEntry*)(begin + header->toc_offset);
+					pack->names = (const char*)(begin + header->names_offset);
+					CopyArray(char, prefix_size + 1, pack->mount_prefix, mount_prefix);
+					if (prefix_size && !_AssetIsPathSeparator(mount_prefix[prefix_size - 1])) {
+						pack->mount_prefix[prefix_size] = '/';
+						prefix_size++;
+						pack->mount_prefix[prefix_size] = '\0';
+					}
+					pack->mount_prefix_size = (uint32)prefix_size;
+					// NOTE: Increment is a full barrier so pack is visible before the count
+					AtomicIncrement32(&packs->count);
+					result = true;
+				} else {
+					AB_CORE_ERROR("Failed to mount asset pack: %s. Invalid pack file.", pack_path);
+					DebugUnmapFile(&file);
+				}
+			} else {
+				AB_CORE_WARN("Failed to mount asset pack: %s. Failed to open file.", pack_path);
+			}
+		}
+		return result;
+	}
+
+	// NOTE: Safe to call from worker threads
+	static MappedFile _AssetFindPackedFile(AssetPackTable* packs, const char* path) {
+		MappedFile result = {};
+		uint32 pack_count = AtomicLoad32(&packs->count);
+		for (uint32 i = pack_count; i > 0; i--) {
+			AssetPack* pack = &packs->packs[i - 1];
+			if (_AssetMatchPathPrefix(path, pack->mount_prefix) < 0) {
+				continue;
+			}
+			const char* name = path + pack->mount_prefix_size;
+			uint64 hash = ABPackHashName(name);
+			uint32 mask = pack->header->toc_capacity - 1;
+			uint32 slot = (uint32)(hash & mask);
+			for (uint32 probe = 0; probe < pack->header->toc_capacity; probe++) {
+				ABPackEntry* entry = &pack->toc[slot];
+				if (!entry->name_hash) {
+					break;
+				}
+				int64 matched = entry->name_hash == hash ? _AssetMatchPathPrefix(name, pack->names + entry->name_offset) : -1;
+				if (matched >= 0 && name[matched] == '\0') {
+					if (entry->compression == ABP_COMPRESSION_NONE) {
+						result.data = (byte*)pack->file.data + entry->offset;
+						result.size = entry->size;
+					} else {
+						AB_CORE_ERROR("Unsupported compression of packed file: %s", path);
+					}
+					return result;
+				}
+				slot = (slot + 1) & mask;
+			}
+		}
+		return result;
+	}
+
+	MappedFile AssetFindPackedFile(AssetManager* mgr, const char* path) {
+		return _AssetFindPackedFile(&mgr->packs, path);
+	}
+
+	// NOTE: Safe to call from worker threads
+	static Image _AssetLoadBMP(AssetPackTable* packs, const char* path) {
+		MappedFile packed = _AssetFindPackedFile(packs, path);
+		if (packed.data) {
+			return LoadBMPFromMemory(packed.data, packed.size, path);
+		}
+		return LoadBMP(path);
+	}
+
+	Image AssetLoadImageBMP(AssetManager* mgr, const char* bmp_path) {
+		return _AssetLoadBMP(&mgr->packs, bmp_path);
+	}
+
+	static bool32 _AssetIsABT(const void* data, uint64 size) {
+		return size >= sizeof(ABTHeader) && ((ABTHeader*)data)->magic_value == ABT_FILE_MAGIC_VALUE;
+	}
+
+	// NOTE: Takes ownership of data. It should be allocated with DebugAllocFileMemory.
+	// Mips stay in place, so header is overwritten by pointer to the block like in BMP decoder
+	static Image _AssetDecodeABT(byte* data, uint64 size, const char* path) {
+		Image image = {};
+		ABTHeader* header = (ABTHeader*)data;
+		uint32 block_size = ABTBlockSize(header->format);
+		bool32 valid = header->version == ABT_FILE_VERSION && block_size
+			&& header->width && header->height && header->width <= 0xffff && header->height <= 0xffff
+			&& header->mip_count && header->mip_count <= ABTFullMipCount(header->width, header->height)
+			&& header->data_offset >= sizeof(ABTHeader) && header->data_offset + header->data_size <= size;
+		if (valid) {
+			uint64 mips_size = 0;
+			for (uint32 level = 0; level < header->mip_count; level++) {
+				mips_size += ABTMipSize(header->format, header->width, header->height, level);
+			}
+			valid = mips_size == header->data_size;
+		}
+		if (valid) {
+			image.width = header->width;
+			image.height = header->height;
+			image.format = header->format == ABT_FORMAT_BC1 ? PixelFormat::BC1 : PixelFormat::BC3;
+			image.bit_per_pixel = block_size / 2;
+			image.mip_count = header->mip_count;
+			image.bitmap = data + header->data_offset;
+			*((uintptr*)image.bitmap - 1) = (uintptr)data;
+		} else {
+			AB_CORE_WARN("Failed to load texture: %s. Invalid ABT file.", path);
+			DebugFreeFileMemory(data);
+		}
+		return image;
+	}
+
+	// NOTE: Detects cooked ABT textures and BMPs by content. Both may be ABZ compressed.
+	// Source data is not modified
+	static Image _AssetDecodeTexture(const void* data, uint64 size, const char* path) {
+		Image image = {};
+		if (ABZIsCompressed(data, size)) {
+			uint64 raw_size = ABZUncompressedSize(data);
+			byte* raw = (byte*)DebugAllocFileMemory(raw_size);
+			if (raw && ABZDecompress(data, size, raw, raw_size)) {
+				if (_AssetIsABT(raw, raw_size)) {
+					image = _AssetDecodeABT(raw, raw_size, path);
+				} else {
+					image = LoadBMPFromMemory(raw, raw_size, path);
+					DebugFreeFileMemory(raw);
+				}
+			} else {
+				DebugFreeFileMemory(raw);
+				AB_CORE_ERROR("Failed to decompress file: %s", path);
+			}
+		} else if (_AssetIsABT(data, size)) {
+			byte* copy = (byte*)DebugAllocFileMemory(size);
+			if (copy) {
+				CopyArray(byte, size, copy, data);
+				image = _AssetDecodeABT(copy, size, path);
+			}
+		} else {
+			image = LoadBMPFromMemory(data, size, path);
+		}
+		return image;
+	}
+
+	// NOTE: Safe to call from worker threads
+	static Image _AssetLoadTexture(AssetPackTable* packs, const char* path) {
+		Image image = {};
+		MappedFile packed = _AssetFindPackedFile(packs, path);
+		if (packed.data) {
+			image = _AssetDecodeTexture(packed.data, packed.size, path);
+		} else {
+			MappedFile file = DebugMapFile(path);
+			if (file.data) {
+				image = _AssetDecodeTexture(file.data, file.size, path);
+				DebugUnmapFile(&file);
+			}
+		}
+		return image;
+	}
+
+	static uint64 _AssetImageSize(const Image* image) {
+		uint64 result = 0;
+		switch (image->format) {
+		case PixelFormat::BC1:
+		case PixelFormat::BC3: {
+			uint32 format = image->format == PixelFormat::BC1 ? ABT_FORMAT_BC1 : ABT_FORMAT_BC3;
+			for (uint32 level = 0; level < image->mip_count; level++) {
+				result += ABTMipSize(format, image->width, image->height, level);
+			}
+		} break;
+		default: {
+			result = (uint64)image->width * image->height * (image->bit_per_pixel / 8);
+		} break;
+		}
+		return result;
+	}
+
 	struct VBufferLayout {
 		hpm::Vector3 vertex;
 		hpm::Vector2 uv;
@@ -52,31 +283,66 @@ namespace AB {
 		return vbo_handle;
 	}
 
-	static uint32 GenAPIIndexBuffer(AssetManager* mgr, uint32* indices, uint64 number_of_indices) {
+	static uint32 GenAPIIndexBuffer(AssetManager* mgr, void* indices, uint64 size) {
 		uint32 ibo_handle;
 		GLCall(glGenBuffers(1, &ibo_handle));
 		GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_handle));
-		uint64 size = number_of_indices* sizeof(uint32);
 		GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW));
 		GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 		return ibo_handle;
 	}
 
+	static void _AssetFillDefaultMaterial(Material* material) {
+		*material = {};
+		material->shininess = 32.0f;
+		material->ambient = { 0.2f, 0.0f, 0.2f };
+		material->diffuse = { 0.8f, 0.0f, 0.8f };
+		material->specular = { 1.0f, 0.0f, 1.0f };
+		material->emission = {};
+		material->diff_map_handle = ASSET_INVALID_HANDLE;
+		material->spec_map_handle = ASSET_INVALID_HANDLE;
+	}
+
+	// NOTE: Fills bounds of AABMeshHeader or Mesh. Sphere is centered at the center of AABB
+	template<typename T>
+	static void _AssetCalculateBounds(T* header, hpm::Vector3* positions, uint32 count) {
+		hpm::Vector3 min = {};
+		hpm::Vector3 max = {};
+		if (count) {
+			min = positions[0];
+			max = positions[0];
+		}
+		for (uint32 i = 1; i < count; i++) {
+			for (uint32 c = 0; c < 3; c++) {
+				if (positions[i].data[c] < min.data[c]) min.data[c] = positions[i].data[c];
+				if (positions[i].data[c] > max.data[c]) max.data[c] = positions[i].data[c];
+			}
+		}
+		hpm::Vector3 center = {};
+		for (uint32 c = 0; c < 3; c++) {
+			center.data[c] = (min.data[c] + max.data[c]) * 0.5f;
+		}
+		float32 radius = 0.0f;
+		for (uint32 i = 0; i < count; i++) {
+			float32 dist = hpm::Length(hpm::Subtract(positions[i], center));
+			radius = dist > radius ? dist : radius;
+		}
+		header->aabb_min = min;
+		header->aabb_max = max;
+		header->bsphere_center = center;
+		header->bsphere_radius = radius;
+	}
+
 	int32 AssetCreateMesh(AssetManager* mgr, uint32 number_of_vertices, hpm::Vector3* positions, hpm::Vector2* uvs, hpm::Vector3* normals, uint32 num_of_indices, uint32* indices, Material* material) {
 		AB_CORE_ASSERT(number_of_vertices, "Mesh should have more than 0 vertices.");
 		AB_CORE_ASSERT(positions, "Cannot create mesh witout vertices.");
 
-		int32 free_index = -1;
-		bool32 found = false;
-		for (uint32 i = 0; i < MESH_STORAGE_CAPACITY; i++) {
-			if (!mgr->mesh_storage_usage[i]) {
-				free_index = i; 
-				found = true;
-				break;
-			}
-		}
+		int32 free_index = ASSET_INVALID_HANDLE;
+		Mesh* slot = (Mesh*)PoolAlloc(&mgr->mesh_pool);
 
-		if (found) {
+		if (slot) {
+			free_index = PoolGetBlockIndex(&mgr->mesh_pool, slot);
+			*slot = {};
 			mgr->mesh_storage_usage[free_index] = true;
 
 			bool32 has_uvs = uvs != nullptr;
@@ -91,11 +357,14 @@ namespace AB {
 			uintptr mat_mem_size = sizeof(Material);
 
 			uintptr mem_size = vert_mem_size + uv_mem_size + norm_mem_size + ind_mem_size + mat_mem_size;
-			mgr->meshes[free_index].mem_begin = (byte*)malloc(mem_size);
+			mgr->meshes[free_index].mem_begin = (byte*)SizeClassAlloc(&mgr->asset_heap, mem_size);
+			AB_CORE_ASSERT(mgr->meshes[free_index].mem_begin, "Failed to allocate mesh memory.");
 			mgr->meshes[free_index].mem_size = mem_size;
 
 			mgr->meshes[free_index].num_vertices = number_of_vertices;
 			mgr->meshes[free_index].num_indices = num_of_indices;
+			mgr->meshes[free_index].num_lods = 1;
+			mgr->meshes[free_index].lods[0] = { 0, num_of_indices, 0.0f };
 
 			mgr->meshes[free_index].positions = (hpm::Vector3*)mgr->meshes[free_index].mem_begin;
 
@@ -104,26 +373,29 @@ namespace AB {
 			byte* ind_beg = has_indices ? (mgr->meshes[free_index].mem_begin + vert_mem_size + uv_mem_size + norm_mem_size) : nullptr;
 			byte* mat_beg = mgr->meshes[free_index].mem_begin + vert_mem_size + uv_mem_size + norm_mem_size + ind_mem_size;
 			
+			mgr->meshes[free_index].state = AssetState::Resident;
+			mgr->meshes[free_index].vertex_format.position_format = AAB_VERTEX_ATTRIB_FLOAT32;
+			mgr->meshes[free_index].vertex_format.position_components = 3;
+			mgr->meshes[free_index].vertex_format.normal_format = has_hormals ? AAB_VERTEX_ATTRIB_FLOAT32 : AAB_VERTEX_ATTRIB_NONE;
+			mgr->meshes[free_index].vertex_format.normal_components = has_hormals ? 3 : 0;
+			mgr->meshes[free_index].vertex_format.uv_format = has_uvs ? AAB_VERTEX_ATTRIB_FLOAT32 : AAB_VERTEX_ATTRIB_NONE;
+			mgr->meshes[free_index].vertex_format.uv_components = has_uvs ? 2 : 0;
+			mgr->meshes[free_index].vertex_format.index_format = has_indices ? AAB_INDEX_FORMAT_UINT32 : AAB_INDEX_FORMAT_NONE;
+			mgr->meshes[free_index].vb_uv_offset = has_uvs ? vert_mem_size : 0;
+			mgr->meshes[free_index].vb_normal_offset = has_hormals ? vert_mem_size + uv_mem_size : 0;
+
 			mgr->meshes[free_index].uvs	= (hpm::Vector2*)uv_beg;
 			mgr->meshes[free_index].normals = (hpm::Vector3*)norm_beg;
 			mgr->meshes[free_index].indices = (uint32*)ind_beg;
 			mgr->meshes[free_index].material = (Material*)mat_beg;
 
 			CopyArray(hpm::Vector3, number_of_vertices, mgr->meshes[free_index].positions, positions);
+			_AssetCalculateBounds(&mgr->meshes[free_index], positions, number_of_vertices);
 
 			if (has_material) {
 				CopyScalar(Material, mgr->meshes[free_index].material, material);
 			} else {
-				Material dummy = {};
-				dummy.shininess = 32.0f;
-				dummy.ambient = { 0.2f, 0.0f, 0.2f };
-				dummy.diffuse = { 0.8f, 0.0f, 0.8f };
-				dummy.specular = { 1.0f, 0.0f, 1.0f };
-				dummy.emission = {};
-				dummy.diff_map_handle = ASSET_INVALID_HANDLE;
-				dummy.spec_map_handle = ASSET_INVALID_HANDLE;
-
-				CopyScalar(Material, mgr->meshes[free_index].material, &dummy);
+				_AssetFillDefaultMaterial(mgr->meshes[free_index].material);
 			}
 			
 			if (has_uvs) {
@@ -141,7 +413,7 @@ namespace AB {
 			AB_CORE_ASSERT(mgr->meshes[free_index].api_vb_handle, "Failed to create vertex buffer");
 
 			if (has_indices) {
-				mgr->meshes[free_index].api_ib_handle = GenAPIIndexBuffer(mgr, mgr->meshes[free_index].indices, num_of_indices);
+				mgr->meshes[free_index].api_ib_handle = GenAPIIndexBuffer(mgr, mgr->meshes[free_index].indices, num_of_indices * sizeof(uint32));
 				AB_CORE_ASSERT(mgr->meshes[free_index].api_ib_handle, "Failed to create index buffer");
 			} else {
 				mgr->meshes[free_index].api_ib_handle = 0;
@@ -154,202 +426,794 @@ namespace AB {
 		return free_index;
 	}
 
-	int32 AssetCreateMeshAAB(AssetManager * mgr, const char * aab_path) {
+	// NOTE: Compressed images are uploaded with all their mips.
+	// Mips of uncompressed images are generated by the driver
+	static uint32 APICreateTexture(const Image* image, const byte* bitmap) {
+		uint32 handle = 0;
+
+		uint32 format = 0;
+		uint32 in_format = 0;
+		bool32 compressed = false;
+		switch (image->format) {
+		case PixelFormat::RGB: {
+			format = GL_RGB;
+			in_format = GL_RGB8;
+		} break;
+		case PixelFormat::RGBA: {
+			format = GL_RGBA;
+			in_format = GL_RGBA8;
+		} break;
+		case PixelFormat::BC1: {
+			in_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			compressed = true;
+		} break;
+		case PixelFormat::BC3: {
+			in_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			compressed = true;
+		} break;
+		default: {
+			AB_CORE_ERROR("Wrong image format");
+		} break;
+		}
+
+		if (in_format) {
+			GLCall(glGenTextures(1, &handle));
+			GLCall(glBindTexture(GL_TEXTURE_2D, handle));
+
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+			if (compressed) {
+				uint32 abt_format = image->format == PixelFormat::BC1 ? ABT_FORMAT_BC1 : ABT_FORMAT_BC3;
+				uint32 mip_count = image->mip_count ? image->mip_count : 1;
+				GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mip_count - 1));
+				const byte* at = bitmap;
+				for (uint32 level = 0; level < mip_count; level++) {
+					uint64 size = ABTMipSize(abt_format, image->width, image->height, level);
+					GLCall(glCompressedTexImage2D(
+						GL_TEXTURE_2D,
+						level,
+						in_format,
+						ABTMipDimension(image->width, level),
+						ABTMipDimension(image->height, level),
+						0,
+						(GLsizei)size,
+						at
+					));
+					at += size;
+				}
+			} else {
+				GLCall(glTexImage2D(
+					GL_TEXTURE_2D,
+					0,
+					in_format,
+					image->width,
+					image->height,
+					0,
+					format,
+					GL_UNSIGNED_BYTE,
+					bitmap
+				));
+				GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+			}
+
+			GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+		}
+		return handle;
+	}
+
+	static bool32 _AssetFillTexture(AssetManager* mgr, Texture* tx, const Image* image, const char* name) {
+		bool32 result = false;
+		uint64 bitmap_size = _AssetImageSize(image);
+		uint64 name_size = strlen(name) + 1;
+		uint64 mem_size = bitmap_size + name_size;
+		void* mem_ptr = SizeClassAlloc(&mgr->asset_heap, mem_size);
+		if (mem_ptr) {
+			*tx = {};
+			tx->mem_size = mem_size;
+			// TODO: strict aliasing might create problems here?
+			tx->mem_begin = (byte*)mem_ptr;
+			tx->bitmap = (byte*)mem_ptr;
+			tx->name = (char*)(tx->mem_begin + bitmap_size);
+
+			CopyArray(byte, bitmap_size, tx->bitmap, image->bitmap);
+			CopyArray(char, name_size , tx->name, name);
+
+			tx->api_handle = APICreateTexture(image, tx->bitmap);
+			if (!tx->api_handle) {
+				AB_CORE_ERROR("Texture loading error. OpenGL API Error. Texture: %s", name);
+			}
+			tx->state = AssetState::Resident;
+			result = true;
+		} else {
+			AB_CORE_ERROR("Failed to allocate block with size: %u64", mem_size);
+		}
+		return result;
+	}
+
+	int32 AssetCreateTexture(AssetManager* mgr, byte* bitmap, uint16 w, uint16 h, uint32 bits_per_pixel, const char* name) {
 		int32 result_handle = ASSET_INVALID_HANDLE;
+		Texture* slot = (Texture*)PoolAlloc(&mgr->texture_pool);
 
-		auto[_header, header_read] = DebugReadFileOffset(aab_path, 0, sizeof(AABMeshHeader));
-		if (_header) {
-			AABMeshHeader* header = (AABMeshHeader*)_header;
-			if (header->magic_value == AAB_FILE_MAGIC_VALUE && header->version == AAB_FILE_VERSION) {
-				uint32 asset_type = header->asset_type;
-				if (asset_type == AAB_FILE_TYPE_MESH) {
-					uint32 vertices_count = header->vertices_count;
-					uint32 normals_count = header->normals_count;
-					uint32 uvs_count = header->uvs_count;
-					uint32 indices_count = header->indices_count;
-
-					uint64 vertices_offset = header->vertices_offset;
-					uint64 normals_offset = header->normals_offset;
-					uint64 uvs_offset = header->uvs_offset;
-					uint64 indices_offset = header->indices_offset;
-					uint64 material_name_offset = header->material_name_offset;
-					uint64 material_properties_offset = header->material_properties_offset;
-					uint64 material_diff_map_name_offset = header->material_diff_bitmap_name_offset;
-					uint64 material_spec_map_name_offset = header->material_spec_bitmap_name_offset;
-					
-					bool32 has_uv = header->uvs_count;
-					bool32 has_material = header->material_name_offset != 0;
-
-
-					uint64 asset_size = header->asset_size;
-					DebugFreeFileMemory(_header);
-
-#pragma warning(push)
-#pragma warning(disable:4244) // uint64 to uint32 conversion. Asset will do his job if bad things happens.
-					AB_CORE_ASSERT(asset_size <= 0xffffffff, "Can't read >4GB files.");
-					auto[asset_data, asset_read] = DebugReadFileOffset(aab_path, vertices_offset, (uint32)asset_size);
-#pragma warning(pop)
-					if (asset_data) {
-						// NOTE: Assume that all data properly alligned
-						hpm::Vector3* vertices = (hpm::Vector3*)((byte*)asset_data);
-						hpm::Vector3* normals = (hpm::Vector3*)((byte*)asset_data + (normals_offset - vertices_offset));
-						hpm::Vector2* uvs = has_uv ? (hpm::Vector2*)((byte*)asset_data + (uvs_offset - vertices_offset) ) : nullptr;
-						uint32* indices = (uint32*)((byte*)asset_data + (indices_offset - vertices_offset));
-						AABMeshMaterialProperties* material_props = has_material ? (AABMeshMaterialProperties*)((byte*)asset_data + (material_properties_offset - vertices_offset)) : nullptr;
-
-						if (has_material) {
-							Material material = {};
-							if (material_diff_map_name_offset) {
-								char* diff_name_ptr = (char*)((byte*)asset_data + (material_diff_map_name_offset - vertices_offset));
-								// TODO: This is all temporary
-								char path_buff[512];
-								auto[result, written] = GetDirectory(aab_path, path_buff, 256);
-								AB_CORE_ASSERT(result, "Too long path.");
-								strcat(path_buff, diff_name_ptr);
-								material.diff_map_handle = AssetCreateTextureBMP(mgr, path_buff);
-							} else {
-								material.diff_map_handle = ASSET_INVALID_HANDLE;
-							}
-							if (material_spec_map_name_offset) {
-								char* spec_name_ptr = (char*)((byte*)asset_data + (material_spec_map_name_offset- vertices_offset));
-								// TODO: This is all temporary
-								char path_buff[512];
-								auto[result, written] = GetDirectory(aab_path, path_buff, 256);
-								AB_CORE_ASSERT(result, "Too long path.");
-								strcat(path_buff, spec_name_ptr);
-								material.spec_map_handle = AssetCreateTextureBMP(mgr, path_buff);
-							}
-							else {
-								material.spec_map_handle = ASSET_INVALID_HANDLE;
-							}
-
-							material.ambient = material_props->k_a;
-							material.diffuse = material_props->k_d;
-							material.specular = material_props->k_s;
-							material.emission = material_props->k_e;
-							material.shininess = material_props->shininess;
-							
-							result_handle = AssetCreateMesh(mgr, vertices_count, vertices, uvs, normals, indices_count, indices, &material);
-						} else {
-							result_handle = AssetCreateMesh(mgr, vertices_count, vertices, uvs, normals, indices_count, indices, nullptr);
-						}
+		if (slot) {
+			int32 free_index = PoolGetBlockIndex(&mgr->texture_pool, slot);
+			Image image = {};
+			image.width = w;
+			image.height = h;
+			image.bit_per_pixel = bits_per_pixel;
+			image.format = bits_per_pixel == 32 ? PixelFormat::RGBA : (bits_per_pixel == 24 ? PixelFormat::RGB : PixelFormat::RED);
+			image.mip_count = 1;
+			image.bitmap = bitmap;
+			if (_AssetFillTexture(mgr, slot, &image, name)) {
+				mgr->texture_storage_usage[free_index] = true;
+				result_handle = free_index;
+			} else {
+				PoolFree(&mgr->texture_pool, slot);
+			}
+		} else {
+			AB_CORE_ERROR("Failed to create texture. Storage is full");
+		}
+		return result_handle;
+	}
 
-					} else {
-						AB_CORE_ERROR("Failed to read seet data");
-					}
+	static bool32 _AssetFillTextureFromImage(AssetManager* mgr, Texture* tx, Image* image, const char* bmp_path) {
+		char name_buf[256];
+		auto[result, written] = GetFilenameFromPath(bmp_path, name_buf, 256);
+		// TODO: this in only test code
+		AB_CORE_ASSERT(result, "Too long filename: %s", bmp_path);
+		bool32 filled = _AssetFillTexture(mgr, tx, image, name_buf);
+		DeleteBitmap(image->bitmap);
+		*image = {};
+		return filled;
+	}
+
+	static int32 _AssetCreateTextureFromImage(AssetManager* mgr, Image* image, const char* bmp_path) {
+		int32 result_handle = ASSET_INVALID_HANDLE;
+		Texture* slot = (Texture*)PoolAlloc(&mgr->texture_pool);
+		if (slot) {
+			int32 free_index = PoolGetBlockIndex(&mgr->texture_pool, slot);
+			if (_AssetFillTextureFromImage(mgr, slot, image, bmp_path)) {
+				mgr->texture_storage_usage[free_index] = true;
+				result_handle = free_index;
+			} else {
+				PoolFree(&mgr->texture_pool, slot);
+			}
+		} else {
+			DeleteBitmap(image->bitmap);
+			*image = {};
+			AB_CORE_ERROR("Failed to create texture. Storage is full");
+		}
+		return result_handle;
+	}
+
+	int32 AssetCreateTextureBMP(AssetManager* mgr, const char* bmp_path) {
+		Image bmp = _AssetLoadTexture(&mgr->packs, bmp_path);
+		if (bmp.bitmap) {
+			return _AssetCreateTextureFromImage(mgr, &bmp, bmp_path);
+		} else {
+			AB_CORE_ERROR("Faied to create texture forom file: %s", bmp_path);
+			return ASSET_INVALID_HANDLE;
+		}
+	}
+
+	// NOTE: Safe to call from worker threads
+	static Image _AssetLoadMaterialMap(AssetPackTable* packs, const char* aab_path, const char* map_name) {
+		// TODO: This is all temporary
+		char path_buff[512];
+		auto[result, written] = GetDirectory(aab_path, path_buff, 256);
+		AB_CORE_ASSERT(result, "Too long path.");
+		strcat(path_buff, map_name);
+		Image image = _AssetLoadTexture(packs, path_buff);
+		if (!image.bitmap) {
+			AB_CORE_ERROR("Faied to create texture forom file: %s", path_buff);
+		}
+		return image;
+	}
+
+	static uint64 _AssetPositionStride(AABVertexFormat* format) {
+		return AABVertexAttribFormatSize(format->position_format) * format->position_components;
+	}
+
+	static uint64 _AssetNormalStride(AABVertexFormat* format) {
+		return AABVertexAttribFormatSize(format->normal_format) * format->normal_components;
+	}
+
+	static uint64 _AssetUVStride(AABVertexFormat* format) {
+		return AABVertexAttribFormatSize(format->uv_format) * format->uv_components;
+	}
+
+	static bool32 _AssetIsVertexFormatSupported(AABVertexFormat* format, bool32 has_uvs) {
+		bool32 positions = (format->position_format == AAB_VERTEX_ATTRIB_FLOAT32 && format->position_components == 3)
+			|| (format->position_format == AAB_VERTEX_ATTRIB_UNORM16 && format->position_components == 4);
+		bool32 normals = (format->normal_format == AAB_VERTEX_ATTRIB_FLOAT32 && format->normal_components == 3)
+			|| (format->normal_format == AAB_VERTEX_ATTRIB_OCT_SNORM16 && format->normal_components == 2);
+		bool32 uvs = !has_uvs
+			|| (format->uv_format == AAB_VERTEX_ATTRIB_FLOAT32 && format->uv_components == 2)
+			|| (format->uv_format == AAB_VERTEX_ATTRIB_FLOAT16 && format->uv_components == 2);
+		bool32 indices = format->index_format == AAB_INDEX_FORMAT_UINT32 || format->index_format == AAB_INDEX_FORMAT_UINT16;
+		return positions && normals && uvs && indices;
+	}
+
+	static bool32 _AssetAreLODsValid(AABMeshHeader* header, byte* file_begin, uint64 file_size) {
+		bool32 result = header->lods_count <= AAB_MAX_LODS
+			&& header->lods_offset + header->lods_count * sizeof(AABMeshLOD) <= file_size;
+		for (uint32 i = 0; result && i < header->lods_count; i++) {
+			AABMeshLOD lod;
+			memcpy(&lod, file_begin + header->lods_offset + i * sizeof(AABMeshLOD), sizeof(AABMeshLOD));
+			result = (uint64)lod.indices_offset + lod.indices_count <= header->indices_count && lod.indices_count % 3 == 0;
+		}
+		return result;
+	}
+
+	// NOTE: Zero lods in header means single lod with all indices
+	static uint32 _AssetReadLODs(AABMeshHeader* header, byte* file_begin, AABMeshLOD* lods) {
+		uint32 result;
+		if (header->lods_count) {
+			memcpy(lods, file_begin + header->lods_offset, header->lods_count * sizeof(AABMeshLOD));
+			result = header->lods_count;
+		} else {
+			lods[0] = { 0, header->indices_count, 0.0f };
+			result = 1;
+		}
+		return result;
+	}
+
+	// NOTE: Checks that meshlets of every lod cover its index range without gaps
+	// and fills ranges of meshlets for lods. Meshlets are sorted, so they are matched to lods in one pass
+	static bool32 _AssetMapMeshletsToLODs(AABMeshHeader* header, byte* file_begin, AABMeshLOD* lods, uint32 lods_count, uint32* lod_first_meshlet) {
+		bool32 result = true;
+		uint32 m = 0;
+		for (uint32 i = 0; result && i < lods_count; i++) {
+			lod_first_meshlet[i] = m;
+			uint32 at = lods[i].indices_offset;
+			uint32 end = lods[i].indices_offset + lods[i].indices_count;
+			while (at < end && m < header->meshlets_count) {
+				AABMeshlet meshlet;
+				memcpy(&meshlet, file_begin + header->meshlets_offset + m * sizeof(AABMeshlet), sizeof(AABMeshlet));
+				if (meshlet.indices_offset != at) {
+					break;
 				}
-				else {
-					AB_CORE_ERROR("Asset : %s is not a mesh.", aab_path);
+				if (!meshlet.indices_count || meshlet.indices_count % 3 || (uint64)at + meshlet.indices_count > end) {
+					result = false;
+					break;
 				}
+				at += meshlet.indices_count;
+				m++;
+			}
+			result = result && (m == lod_first_meshlet[i] || at == end);
+		}
+		for (uint32 i = lods_count; i <= AAB_MAX_LODS; i++) {
+			lod_first_meshlet[i] = m;
+		}
+		return result && m == header->meshlets_count;
+	}
+
+	static bool32 _AssetAreMeshletsValid(AABMeshHeader* header, byte* file_begin, uint64 file_size) {
+		bool32 result = true;
+		if (header->meshlets_count) {
+			AABMeshLOD lods[AAB_MAX_LODS];
+			uint32 lod_first_meshlet[AAB_MAX_LODS + 1];
+			uint32 lods_count = _AssetReadLODs(header, file_begin, lods);
+			result = header->meshlets_count <= header->indices_count / 3
+				&& header->meshlets_offset + (uint64)header->meshlets_count * sizeof(AABMeshlet) <= file_size
+				&& _AssetMapMeshletsToLODs(header, file_begin, lods, lods_count, lod_first_meshlet);
+		}
+		return result;
+	}
+
+	// NOTE: Converts header of any supported version to current one.
+	// v0 has no bounds and vertex format, so they are calculated here.
+	static bool32 _AssetReadAABMeshHeader(AssetLoadJob* job) {
+		bool32 result = false;
+		byte* file_begin = (byte*)job->file.data;
+		uint64 file_size = job->file.size;
+		AABMeshHeader* header = &job->header;
+		AABMeshHeaderV0* header_v0 = (AABMeshHeaderV0*)file_begin;
+
+		if (file_size >= sizeof(AABMeshHeaderV0) && header_v0->magic_value == AAB_FILE_MAGIC_VALUE) {
+			bool32 current = header_v0->version == AAB_FILE_VERSION && file_size >= sizeof(AABMeshHeader);
+			bool32 v2 = header_v0->version == AAB_FILE_VERSION_2 && file_size >= AAB_MESH_HEADER_V2_SIZE;
+			bool32 v1 = header_v0->version == AAB_FILE_VERSION_1 && file_size >= AAB_MESH_HEADER_V1_SIZE;
+			if (current || v2 || v1) {
+				// NOTE: v2 header is the prefix of current one without meshlets, v1 is v2 without lods
+				*header = {};
+				memcpy(header, file_begin, current ? sizeof(AABMeshHeader) : (v2 ? AAB_MESH_HEADER_V2_SIZE : AAB_MESH_HEADER_V1_SIZE));
+				bool32 aligned = header->vertices_offset % AAB_FIRST_STREAM_ALIGMENT == 0
+					&& header->normals_offset % AAB_SECTION_ALIGMENT == 0
+					&& header->uvs_offset % AAB_SECTION_ALIGMENT == 0
+					&& header->indices_offset % AAB_SECTION_ALIGMENT == 0;
+				if (aligned) {
+					result = true;
+				} else {
+					AB_CORE_ERROR("Misaligned streams in file: %s", job->path);
+				}
+			} else if (header_v0->version == AAB_FILE_VERSION_0) {
+				*header = {};
+				header->magic_value = header_v0->magic_value;
+				header->version = header_v0->version;
+				header->asset_size = header_v0->asset_size;
+				header->asset_type = header_v0->asset_type;
+				header->vertices_count = header_v0->vertices_count;
+				header->normals_count = header_v0->normals_count;
+				header->uvs_count = header_v0->uvs_count;
+				header->indices_count = header_v0->indices_count;
+				header->vertex_format.position_format = AAB_VERTEX_ATTRIB_FLOAT32;
+				header->vertex_format.position_components = 3;
+				header->vertex_format.normal_format = AAB_VERTEX_ATTRIB_FLOAT32;
+				header->vertex_format.normal_components = 3;
+				header->vertex_format.uv_format = header_v0->uvs_count ? AAB_VERTEX_ATTRIB_FLOAT32 : AAB_VERTEX_ATTRIB_NONE;
+				header->vertex_format.uv_components = header_v0->uvs_count ? 2 : 0;
+				header->vertex_format.index_format = AAB_INDEX_FORMAT_UINT32;
+				header->vertices_offset = header_v0->vertices_offset;
+				header->normals_offset = header_v0->normals_offset;
+				header->uvs_offset = header_v0->uvs_count ? header_v0->uvs_offset : 0;
+				header->indices_offset = header_v0->indices_offset;
+				header->material_properties_offset = header_v0->material_properties_offset;
+				header->material_name_offset = header_v0->material_name_offset;
+				header->material_diff_bitmap_name_offset = header_v0->material_diff_bitmap_name_offset;
+				header->material_spec_bitmap_name_offset = header_v0->material_spec_bitmap_name_offset;
+				result = true;
+			} else {
+				AB_CORE_ERROR("Unsupported AAB version %u32 in file: %s", header_v0->version, job->path);
+			}
+		} else {
+			AB_CORE_ERROR("Unknown file format in file: %s", job->path);
+		}
+
+		if (result) {
+			AABVertexFormat* format = &header->vertex_format;
+			uint64 vertices_end = header->vertices_offset + header->vertices_count * _AssetPositionStride(format);
+			uint64 normals_end = header->normals_offset + header->normals_count * _AssetNormalStride(format);
+			uint64 uvs_end = header->uvs_offset + header->uvs_count * _AssetUVStride(format);
+			uint64 indices_end = header->indices_offset + header->indices_count * AABIndexFormatSize(format->index_format);
+			// NOTE: Vertex buffer is uploaded as one range from vertices_offset to indices_offset,
+			// so streams have to follow each other in that order without overlapping
+			uint64 normals_next = header->uvs_count ? header->uvs_offset : header->indices_offset;
+			bool32 ordered = header->vertices_offset <= vertices_end && vertices_end <= header->normals_offset
+				&& header->normals_offset <= normals_end && normals_end <= normals_next
+				&& (!header->uvs_count || (header->uvs_offset <= uvs_end && uvs_end <= header->indices_offset))
+				&& header->indices_offset <= indices_end;
+			if (header->asset_type != AAB_FILE_TYPE_MESH) {
+				AB_CORE_ERROR("Asset : %s is not a mesh.", job->path);
+				result = false;
+			} else if (!_AssetIsVertexFormatSupported(format, header->uvs_count != 0)) {
+				AB_CORE_ERROR("Unsupported vertex format in file: %s", job->path);
+				result = false;
+			} else if (header->normals_count != header->vertices_count || (header->uvs_count && header->uvs_count != header->vertices_count)) {
+				// NOTE: Decoding and vertex attributes read vertices_count elements of every stream
+				AB_CORE_ERROR("Vertex stream sizes do not match in file: %s", job->path);
+				result = false;
+			} else if (header->vertices_offset + header->asset_size > file_size || vertices_end > file_size || normals_end > file_size || uvs_end > file_size || indices_end > file_size || !header->normals_count) {
+				AB_CORE_ERROR("Asset data is out of file bounds: %s", job->path);
+				result = false;
+			} else if (!ordered) {
+				AB_CORE_ERROR("Vertex streams are out of order in file: %s", job->path);
+				result = false;
+			} else if (!_AssetAreLODsValid(header, file_begin, file_size)) {
+				AB_CORE_ERROR("Invalid lods in file: %s", job->path);
+				result = false;
+			} else if (!_AssetAreMeshletsValid(header, file_begin, file_size)) {
+				AB_CORE_ERROR("Invalid meshlets in file: %s", job->path);
+				result = false;
+			} else if (header->version == AAB_FILE_VERSION_0) {
+				_AssetCalculateBounds(header, (hpm::Vector3*)(file_begin + header->vertices_offset), header->vertices_count);
+			}
+		}
+
+		return result;
+	}
+
+	static void _AssetReleaseJobFile(AssetLoadJob* job) {
+		if (job->file_decompressed) {
+			DebugFreeFileMemory(job->file.data);
+		} else if (!job->file_packed) {
+			DebugUnmapFile(&job->file);
+		}
+		job->file = {};
+		job->file_packed = false;
+		job->file_decompressed = false;
+	}
+
+	// NOTE: Replaces compressed job file with decompressed copy. Runs on the thread which loads the job,
+	// so streamed assets are decompressed on worker threads
+	static bool32 _AssetDecompressJobFile(AssetLoadJob* job) {
+		bool32 result = true;
+		if (ABZIsCompressed(job->file.data, job->file.size)) {
+			uint64 size = ABZUncompressedSize(job->file.data);
+			void* data = DebugAllocFileMemory(size);
+			result = data && ABZDecompress(job->file.data, job->file.size, data, size);
+			_AssetReleaseJobFile(job);
+			if (result) {
+				job->file.data = data;
+				job->file.size = size;
+				job->file_decompressed = true;
+			} else {
+				DebugFreeFileMemory(data);
+				AB_CORE_ERROR("Failed to decompress file: %s", job->path);
 			}
-			else {
-				AB_CORE_ERROR("Unknown file format in file: %s", aab_path);
+		}
+		return result;
+	}
+
+	// NOTE: Does all file io and decoding for AAB mesh. Safe to call from worker threads.
+	// Mapping stays alive until the job is finalized.
+	static bool32 _AssetLoadMeshAAB(AssetPackTable* packs, AssetLoadJob* job) {
+		bool32 result = false;
+		const char* aab_path = job->path;
+
+		job->file = _AssetFindPackedFile(packs, aab_path);
+		job->file_packed = job->file.data != nullptr;
+		if (!job->file_packed) {
+			job->file = DebugMapFile(aab_path);
+		}
+		if (job->file.data) {
+			if (_AssetDecompressJobFile(job) && _AssetReadAABMeshHeader(job)) {
+				byte* file_begin = (byte*)job->file.data;
+				AABMeshHeader* header = &job->header;
+				if (header->material_name_offset != 0) {
+					if (header->material_diff_bitmap_name_offset) {
+						job->diff_map = _AssetLoadMaterialMap(packs, aab_path, (char*)(file_begin + header->material_diff_bitmap_name_offset));
+					}
+					if (header->material_spec_bitmap_name_offset) {
+						job->spec_map = _AssetLoadMaterialMap(packs, aab_path, (char*)(file_begin + header->material_spec_bitmap_name_offset));
+					}
+				}
+				result = true;
+			} else {
+				_AssetReleaseJobFile(job);
 			}
 		} else {
 			AB_CORE_ERROR("Failed to read file: %s", aab_path);
 		}
-		
-		return result_handle;
+
+		return result;
 	}
 
-	Mesh* AssetGetMeshData(AssetManager* mgr, int32 mesh_handle) {
-		if (mesh_handle != ASSET_INVALID_HANDLE && mesh_handle < MESH_STORAGE_CAPACITY) {
-			return &mgr->meshes[mesh_handle];
+	// NOTE: Decodes streams of any supported format to float32 positions, normals, uvs and uint32 indices.
+	// Layout is positions | normals | uvs | indices
+	static void _AssetDecodeCPUStreams(Mesh* mesh, byte* file_begin, AABMeshHeader* header) {
+		AABVertexFormat* format = &header->vertex_format;
+		uint32 num_vertices = header->vertices_count;
+		bool32 has_uvs = header->uvs_count != 0;
+
+		mesh->positions = (hpm::Vector3*)mesh->mem_begin;
+		mesh->normals = (hpm::Vector3*)(mesh->mem_begin + num_vertices * sizeof(hpm::Vector3));
+		byte* uvs_begin = (byte*)mesh->normals + num_vertices * sizeof(hpm::Vector3);
+		mesh->uvs = has_uvs ? (hpm::Vector2*)uvs_begin : nullptr;
+		byte* indices_begin = uvs_begin + (has_uvs ? num_vertices * sizeof(hpm::Vector2) : 0);
+		mesh->indices = header->indices_count ? (uint32*)indices_begin : nullptr;
+
+		byte* src_positions = file_begin + header->vertices_offset;
+		if (format->position_format == AAB_VERTEX_ATTRIB_FLOAT32) {
+			CopyArray(hpm::Vector3, num_vertices, mesh->positions, (hpm::Vector3*)src_positions);
 		} else {
-			return nullptr;
+			hpm::Vector3 extent = hpm::Subtract(header->aabb_max, header->aabb_min);
+			uint16* q = (uint16*)src_positions;
+			for (uint32 i = 0; i < num_vertices; i++) {
+				mesh->positions[i].x = header->aabb_min.x + (q[i * 4 + 0] / 65535.0f) * extent.x;
+				mesh->positions[i].y = header->aabb_min.y + (q[i * 4 + 1] / 65535.0f) * extent.y;
+				mesh->positions[i].z = header->aabb_min.z + (q[i * 4 + 2] / 65535.0f) * extent.z;
+			}
+		}
+
+		byte* src_normals = file_begin + header->normals_offset;
+		if (format->normal_format == AAB_VERTEX_ATTRIB_FLOAT32) {
+			CopyArray(hpm::Vector3, num_vertices, mesh->normals, (hpm::Vector3*)src_normals);
+		} else {
+			int16* oct = (int16*)src_normals;
+			for (uint32 i = 0; i < num_vertices; i++) {
+				mesh->normals[i] = AABOctDecode(oct + i * 2);
+			}
+		}
+
+		if (has_uvs) {
+			byte* src_uvs = file_begin + header->uvs_offset;
+			if (format->uv_format == AAB_VERTEX_ATTRIB_FLOAT32) {
+				CopyArray(hpm::Vector2, num_vertices, mesh->uvs, (hpm::Vector2*)src_uvs);
+			} else {
+				uint16* half = (uint16*)src_uvs;
+				for (uint32 i = 0; i < num_vertices; i++) {
+					mesh->uvs[i].x = AABHalfToFloat(half[i * 2 + 0]);
+					mesh->uvs[i].y = AABHalfToFloat(half[i * 2 + 1]);
+				}
+			}
+		}
+
+		if (header->indices_count) {
+			byte* src_indices = file_begin + header->indices_offset;
+			if (format->index_format == AAB_INDEX_FORMAT_UINT32) {
+				CopyArray(uint32, header->indices_count, mesh->indices, (uint32*)src_indices);
+			} else {
+				uint16* indices16 = (uint16*)src_indices;
+				for (uint32 i = 0; i < header->indices_count; i++) {
+					mesh->indices[i] = indices16[i];
+				}
+			}
 		}
 	}
 
-	Texture* AssetGetTextureData(AssetManager* mgr, int32 texture_handle) {
-		if (texture_handle != ASSET_INVALID_HANDLE && texture_handle < TEXTURE_STORAGE_CAPACITY) {
-			return &mgr->textures[texture_handle];
+	// NOTE: Uploads vertex and index streams directly from mapped file.
+	// File layout is vertices | normals | uvs | indices, so vertex streams
+	// form one contiguous range (including v1 padding) that goes to the vertex buffer as is.
+	// Quantized streams are uploaded packed and decoded by the renderer.
+	static void _AssetFillMeshFromMappedAAB(AssetManager* mgr, Mesh* slot, byte* file_begin, AABMeshHeader* header, Material* material, bool32 retain_cpu_data) {
+		*slot = {};
+
+		bool32 has_uvs = header->uvs_count != 0;
+		bool32 has_indices = header->indices_count != 0;
+		uint32 num_vertices = header->vertices_count;
+
+		uintptr vb_size = header->indices_offset - header->vertices_offset;
+		uintptr index_size = AABIndexFormatSize(header->vertex_format.index_format);
+		uintptr stream_mem_size = 0;
+		if (retain_cpu_data) {
+			stream_mem_size = num_vertices * sizeof(hpm::Vector3) * 2
+				+ (has_uvs ? num_vertices * sizeof(hpm::Vector2) : 0)
+				+ header->indices_count * sizeof(uint32);
+		}
+		uintptr meshlets_mem_size = header->meshlets_count * sizeof(AABMeshlet);
+		uintptr mem_size = stream_mem_size + sizeof(Material) + meshlets_mem_size;
+
+		slot->mem_begin = (byte*)SizeClassAlloc(&mgr->asset_heap, mem_size);
+		AB_CORE_ASSERT(slot->mem_begin, "Failed to allocate mesh memory.");
+		slot->mem_size = mem_size;
+
+		slot->num_vertices = num_vertices;
+		slot->num_lods = _AssetReadLODs(header, file_begin, slot->lods);
+		slot->num_indices = slot->lods[0].indices_count;
+		slot->vertex_format = header->vertex_format;
+		slot->vb_normal_offset = header->normals_offset - header->vertices_offset;
+		slot->vb_uv_offset = has_uvs ? header->uvs_offset - header->vertices_offset : 0;
+		slot->aabb_min = header->aabb_min;
+		slot->aabb_max = header->aabb_max;
+		slot->bsphere_center = header->bsphere_center;
+		slot->bsphere_radius = header->bsphere_radius;
+
+		slot->material = (Material*)(slot->mem_begin + stream_mem_size);
+		CopyScalar(Material, slot->material, material);
+
+		// NOTE: Meshlets are validated when header is read
+		slot->num_meshlets = header->meshlets_count;
+		if (slot->num_meshlets) {
+			slot->meshlets = (AABMeshlet*)(slot->mem_begin + stream_mem_size + sizeof(Material));
+			memcpy(slot->meshlets, file_begin + header->meshlets_offset, meshlets_mem_size);
+		}
+		_AssetMapMeshletsToLODs(header, file_begin, slot->lods, slot->num_lods, slot->lod_first_meshlet);
+
+		if (retain_cpu_data) {
+			_AssetDecodeCPUStreams(slot, file_begin, header);
+		}
+
+		byte* vb_data = file_begin + header->vertices_offset;
+		byte* ind_data = file_begin + header->indices_offset;
+
+		slot->api_vb_handle = GenAPIVertexBuffer(mgr, vb_data, vb_size, num_vertices);
+		AB_CORE_ASSERT(slot->api_vb_handle, "Failed to create vertex buffer");
+
+		if (has_indices) {
+			slot->api_ib_handle = GenAPIIndexBuffer(mgr, ind_data, header->indices_count * index_size);
+			AB_CORE_ASSERT(slot->api_ib_handle, "Failed to create index buffer");
 		} else {
-			return nullptr;
+			slot->api_ib_handle = 0;
 		}
+
+		slot->state = AssetState::Resident;
 	}
 
-	static uint32 APICreateTexture(uint16 w, uint16 h, uint32 bits_per_pixel, void* bitmap) {
-		uint32 handle;
+	// NOTE: Main thread only. Creates textures and GL buffers for loaded job and releases the mapping
+	static void _AssetFinalizeMeshAAB(AssetManager* mgr, Mesh* slot, AssetLoadJob* job) {
+		byte* file_begin = (byte*)job->file.data;
+		AABMeshHeader* header = &job->header;
 
-		uint32 format = 0;
-		uint32 in_format = 0;
-		switch (bits_per_pixel) {
-		case 24: {
-			format = GL_RGB;
-			in_format = GL_RGB8;
+		Material material;
+		if (header->material_name_offset != 0) {
+			AABMeshMaterialProperties* material_props = (AABMeshMaterialProperties*)(file_begin + header->material_properties_offset);
+			material = {};
+			if (job->diff_map.bitmap) {
+				material.diff_map_handle = _AssetCreateTextureFromImage(mgr, &job->diff_map, job->path);
+			} else {
+				material.diff_map_handle = ASSET_INVALID_HANDLE;
+			}
+			if (job->spec_map.bitmap) {
+				material.spec_map_handle = _AssetCreateTextureFromImage(mgr, &job->spec_map, job->path);
+			} else {
+				material.spec_map_handle = ASSET_INVALID_HANDLE;
+			}
+
+			material.ambient = material_props->k_a;
+			material.diffuse = material_props->k_d;
+			material.specular = material_props->k_s;
+			material.emission = material_props->k_e;
+			material.shininess = material_props->shininess;
+		} else {
+			_AssetFillDefaultMaterial(&material);
+		}
+
+		_AssetFillMeshFromMappedAAB(mgr, slot, file_begin, header, &material, job->retain_cpu_data);
+		_AssetReleaseJobFile(job);
+	}
+
+	static bool32 _AssetInitLoadJob(AssetLoadJob* job, AssetLoadType type, const char* path, bool32 retain_cpu_data) {
+		bool32 result = false;
+		uint64 path_size = strlen(path) + 1;
+		if (path_size <= ASSET_PATH_SIZE) {
+			*job = {};
+			job->type = type;
+			job->handle = ASSET_INVALID_HANDLE;
+			job->retain_cpu_data = retain_cpu_data;
+			CopyArray(char, path_size, job->path, path);
+			result = true;
+		} else {
+			AB_CORE_ERROR("Too long asset path: %s", path);
+		}
+		return result;
+	}
+
+	int32 AssetCreateMeshAAB(AssetManager * mgr, const char * aab_path, bool32 retain_cpu_data) {
+		int32 result_handle = ASSET_INVALID_HANDLE;
+		AssetLoadJob job;
+		if (_AssetInitLoadJob(&job, AssetLoadType::Mesh, aab_path, retain_cpu_data)) {
+			if (_AssetLoadMeshAAB(&mgr->packs, &job)) {
+				Mesh* slot = (Mesh*)PoolAlloc(&mgr->mesh_pool);
+				if (slot) {
+					result_handle = PoolGetBlockIndex(&mgr->mesh_pool, slot);
+					mgr->mesh_storage_usage[result_handle] = true;
+					_AssetFinalizeMeshAAB(mgr, slot, &job);
+				} else {
+					_AssetReleaseJobFile(&job);
+					if (job.diff_map.bitmap) DeleteBitmap(job.diff_map.bitmap);
+					if (job.spec_map.bitmap) DeleteBitmap(job.spec_map.bitmap);
+					AB_CORE_ERROR("Failed to load mesh. Storage is full.");
+				}
+			}
+		}
+		return result_handle;
+	}
+
+	static void _AssetRunLoadJob(AssetPackTable* packs, AssetLoadJob* job) {
+		switch (job->type) {
+		case AssetLoadType::Mesh: {
+			job->succeeded = _AssetLoadMeshAAB(packs, job);
 		} break;
-		case 32: {
-			format = GL_RGBA;
-			in_format = GL_RGBA8;
+		case AssetLoadType::Texture: {
+			job->diff_map = _AssetLoadTexture(packs, job->path);
+			job->succeeded = job->diff_map.bitmap != nullptr;
+			if (!job->succeeded) {
+				AB_CORE_ERROR("Faied to create texture forom file: %s", job->path);
+			}
+		} break;
+		case AssetLoadType::CubemapFace: {
+			job->diff_map = DecodeBMPInto(job->file.data, &job->bmp_info, job->staging);
+			job->succeeded = true;
 		} break;
 		default: {
-			AB_CORE_ERROR("Wrong image format");
+			AB_CORE_ERROR("Unknown asset load type");
 		} break;
 		}
+	}
 
-		if (format) {
-			GLCall(glGenTextures(1, &handle));
-			GLCall(glBindTexture(GL_TEXTURE_2D, handle));
+	static void _AssetCompleteLoadJob(AssetStreamer* streamer, uint32 job_index) {
+		AssetLoadJob* job = &streamer->jobs[job_index];
+		if (job->type == AssetLoadType::CubemapFace) {
+			AtomicIncrement32(job->batch_done);
+		} else {
+			uint32 slot = AtomicIncrement32(&streamer->completion_reserve) - 1;
+			AtomicExchange32(&streamer->completions[slot & (ASSET_LOAD_QUEUE_SIZE - 1)], job_index + 1);
+		}
+	}
 
-			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-			GLCall(glTexImage2D(
-				GL_TEXTURE_2D,
-				0,
-				in_format,
-				w,
-				h,
-				0,
-				format,
-				GL_UNSIGNED_BYTE,
-				bitmap
-			));
+	// NOTE: Returns false if request queue is empty
+	static bool32 _AssetTryRunRequest(AssetStreamer* streamer) {
+		bool32 result = false;
+		uint32 read = AtomicLoad32(&streamer->request_read);
+		if (read != AtomicLoad32(&streamer->request_write)) {
+			result = true;
+			if (AtomicCompareExchange32(&streamer->request_read, read + 1, read) == read) {
+				uint32 job_index = streamer->requests[read & (ASSET_LOAD_QUEUE_SIZE - 1)];
+				_AssetRunLoadJob(streamer->packs, &streamer->jobs[job_index]);
+				_AssetCompleteLoadJob(streamer, job_index);
+			}
+		}
+		return result;
+	}
 
-			GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	static void _AssetWorkerProc(void* data) {
+		AssetStreamer* streamer = (AssetStreamer*)data;
+		while (true) {
+			if (!_AssetTryRunRequest(streamer)) {
+				SemaphoreWait(streamer->semaphore);
+			}
 		}
-		return handle;
 	}
 
-	int32 AssetCreateTexture(AssetManager* mgr, byte* bitmap, uint16 w, uint16 h, uint32 bits_per_pixel, const char* name) {
-		int32 result_handle = ASSET_INVALID_HANDLE;
-		int32 free_index = ASSET_INVALID_HANDLE;
-		bool32 found = false;
-		for (uint32 i = 0; i < TEXTURE_STORAGE_CAPACITY; i++) {
-			if (!mgr->texture_storage_usage[i]) {
-				free_index = i;
-				found = true;
-				break;
+	static void _AssetStreamerInit(AssetStreamer* streamer, AssetPackTable* packs) {
+		static_assert((ASSET_LOAD_QUEUE_SIZE & (ASSET_LOAD_QUEUE_SIZE - 1)) == 0, "Load queue size should be power of two");
+		*streamer = {};
+		streamer->packs = packs;
+		streamer->free_jobs_count = ASSET_LOAD_QUEUE_SIZE;
+		for (uint32 i = 0; i < ASSET_LOAD_QUEUE_SIZE; i++) {
+			// NOTE: Reversed so jobs are taken from the beginning of array
+			streamer->free_jobs[i] = ASSET_LOAD_QUEUE_SIZE - 1 - i;
+		}
+
+		streamer->semaphore = SemaphoreCreate(0);
+		if (streamer->semaphore) {
+			uint32 cpu_count = GetLogicalProcessorCount();
+			uint32 wanted_count = cpu_count > 1 ? cpu_count - 1 : 1;
+			wanted_count = wanted_count > ASSET_MAX_WORKER_THREADS ? ASSET_MAX_WORKER_THREADS : wanted_count;
+			for (uint32 i = 0; i < wanted_count; i++) {
+				if (CreateWorkerThread(_AssetWorkerProc, streamer)) {
+					streamer->worker_count++;
+				}
 			}
 		}
 
-		if (found) {
-			uint64 bitmap_size = w * h * (bits_per_pixel / 8);
-			uint64 name_size = strlen(name) + 1;
-			uint64 mem_size = bitmap_size + name_size;
-			void* mem_ptr = malloc(mem_size);
-			if (mem_ptr) {
-				auto* tx = &mgr->textures[free_index];
-				tx->mem_size = mem_size;
-				// TODO: strict aliasing might create problems here?
-				tx->mem_begin = (byte*)mem_ptr;
-				tx->bitmap = (byte*)mem_ptr;
-				tx->name = (char*)(tx->mem_begin + bitmap_size);
+		if (!streamer->worker_count) {
+			AB_CORE_WARN("Failed to start asset streaming threads. Async loads will run synchronously.");
+		}
+	}
 
-				CopyArray(byte, bitmap_size, tx->bitmap, bitmap);
-				CopyArray(char, name_size , tx->name, name);
+	static void _AssetSubmitLoadJob(AssetStreamer* streamer, uint32 job_index) {
+		if (streamer->worker_count) {
+			streamer->requests[streamer->request_write & (ASSET_LOAD_QUEUE_SIZE - 1)] = job_index;
+			// NOTE: Increment is a full barrier, so entry is visible before counter
+			AtomicIncrement32(&streamer->request_write);
+			SemaphoreSignal(streamer->semaphore);
+		} else {
+			_AssetRunLoadJob(streamer->packs, &streamer->jobs[job_index]);
+			_AssetCompleteLoadJob(streamer, job_index);
+		}
+	}
 
-				tx->api_handle = APICreateTexture(w, h, bits_per_pixel, tx->bitmap);
-				if (!tx->api_handle) {
-					AB_CORE_ERROR("Texture loading error. OpenGL API Error. Texture: %s", name);
-				}
+	static int32 _AssetPushLoadJob(AssetStreamer* streamer, AssetLoadType type, const char* path, bool32 retain_cpu_data, int32 handle) {
+		int32 result = ASSET_INVALID_HANDLE;
+		if (streamer->free_jobs_count) {
+			uint32 job_index = streamer->free_jobs[streamer->free_jobs_count - 1];
+			AssetLoadJob* job = &streamer->jobs[job_index];
+			if (_AssetInitLoadJob(job, type, path, retain_cpu_data)) {
+				streamer->free_jobs_count--;
+				job->handle = handle;
+				result = handle;
+				_AssetSubmitLoadJob(streamer, job_index);
+			}
+		} else {
+			AB_CORE_ERROR("Failed to queue asset load. Too many loads in flight: %s", path);
+		}
+		return result;
+	}
 
-				mgr->texture_storage_usage[free_index] = true;
-				result_handle = free_index;
+	int32 AssetCreateMeshAABAsync(AssetManager* mgr, const char* aab_path, bool32 retain_cpu_data) {
+		int32 result_handle = ASSET_INVALID_HANDLE;
+		Mesh* slot = (Mesh*)PoolAlloc(&mgr->mesh_pool);
+		if (slot) {
+			int32 index = PoolGetBlockIndex(&mgr->mesh_pool, slot);
+			*slot = {};
+			slot->state = AssetState::Pending;
+			result_handle = _AssetPushLoadJob(&mgr->streamer, AssetLoadType::Mesh, aab_path, retain_cpu_data, index);
+			if (result_handle != ASSET_INVALID_HANDLE) {
+				mgr->mesh_storage_usage[index] = true;
+			} else {
+				PoolFree(&mgr->mesh_pool, slot);
 			}
-			else {
-				AB_CORE_ERROR("Failed to allocate block with size: %u64", mem_size);
+		} else {
+			AB_CORE_ERROR("Failed to load mesh. Storage is full.");
+		}
+		return result_handle;
+	}
+
+	int32 AssetCreateTextureBMPAsync(AssetManager* mgr, const char* bmp_path) {
+		int32 result_handle = ASSET_INVALID_HANDLE;
+		Texture* slot = (Texture*)PoolAlloc(&mgr->texture_pool);
+		if (slot) {
+			int32 index = PoolGetBlockIndex(&mgr->texture_pool, slot);
+			*slot = {};
+			slot->state = AssetState::Pending;
+			result_handle = _AssetPushLoadJob(&mgr->streamer, AssetLoadType::Texture, bmp_path, false, index);
+			if (result_handle != ASSET_INVALID_HANDLE) {
+				mgr->texture_storage_usage[index] = true;
+			} else {
+				PoolFree(&mgr->texture_pool, slot);
 			}
 		} else {
 			AB_CORE_ERROR("Failed to create texture. Storage is full");
@@ -357,18 +1221,208 @@ namespace AB {
 		return result_handle;
 	}
 
-	int32 AssetCreateTextureBMP(AssetManager* mgr, const char* bmp_path) {
-		Image bmp = LoadBMP(bmp_path);
-		if (bmp.bitmap) {
-			char name_buf[256];
-			auto[result, written] = GetFilenameFromPath(bmp_path, name_buf, 256);
-			// TODO: this in only test code
-			AB_CORE_ASSERT(result, "Too long filename: %s", bmp_path);
-			return AssetCreateTexture(mgr, bmp.bitmap, bmp.width, bmp.height, bmp.bit_per_pixel, name_buf);
+	// NOTE: Main thread only. Maps and parses all faces first, so they can be decoded into single staging block.
+	// Returns staging block which should be freed with DebugFreeFileMemory or null if failed
+	static byte* _AssetDecodeCubemapFaces(AssetStreamer* streamer, const char* const face_paths[API::CUBEMAP_FACE_COUNT], Image faces[API::CUBEMAP_FACE_COUNT]) {
+		constexpr uint32 face_count = API::CUBEMAP_FACE_COUNT;
+		if (streamer->free_jobs_count < face_count) {
+			AB_CORE_ERROR("Failed to load cubemap. Too many loads in flight: %s", face_paths[0]);
+			return nullptr;
+		}
+
+		uint32 job_indices[face_count];
+		uint64 staging_offsets[face_count];
+		uint64 staging_size = 0;
+		uint32 jobs_taken = 0;
+		bool32 valid = true;
+		for (uint32 i = 0; i < face_count; i++) {
+			uint32 job_index = streamer->free_jobs[streamer->free_jobs_count - 1];
+			AssetLoadJob* job = &streamer->jobs[job_index];
+			if (!_AssetInitLoadJob(job, AssetLoadType::CubemapFace, face_paths[i], false)) {
+				valid = false;
+				break;
+			}
+			streamer->free_jobs_count--;
+			job_indices[i] = job_index;
+			jobs_taken++;
+
+			job->file = _AssetFindPackedFile(streamer->packs, job->path);
+			job->file_packed = job->file.data != nullptr;
+			if (!job->file_packed) {
+				job->file = DebugMapFile(job->path);
+			}
+			if (!job->file.data) {
+				AB_CORE_ERROR("Failed to load cubemap face: %s. Failed to open file.", job->path);
+				valid = false;
+				break;
+			}
+			if (!ReadBMPInfo(job->file.data, job->file.size, job->path, &job->bmp_info)) {
+				valid = false;
+				break;
+			}
+			BMPInfo* first = &streamer->jobs[job_indices[0]].bmp_info;
+			if (job->bmp_info.width != job->bmp_info.height || job->bmp_info.width != first->width
+				|| job->bmp_info.bits_per_pixel != first->bits_per_pixel) {
+				AB_CORE_ERROR("Failed to load cubemap face: %s. Faces should be square and have the same size and format.", job->path);
+				valid = false;
+				break;
+			}
+			// NOTE: Faces are aligned to cache lines, so workers never write to the same line
+			staging_offsets[i] = staging_size;
+			staging_size += (job->bmp_info.stride * job->bmp_info.height + 63) & ~63ull;
+		}
+
+		byte* staging = valid ? (byte*)DebugAllocFileMemory(staging_size) : nullptr;
+		if (staging) {
+			volatile uint32 faces_done = 0;
+			for (uint32 i = 0; i < face_count; i++) {
+				AssetLoadJob* job = &streamer->jobs[job_indices[i]];
+				job->staging = staging + staging_offsets[i];
+				job->batch_done = &faces_done;
+				_AssetSubmitLoadJob(streamer, job_indices[i]);
+			}
+			// NOTE: Main thread takes requests too instead of idling. It may also run earlier queued loads,
+			// they are completed as usual
+			while (AtomicLoad32(&faces_done) < face_count) {
+				_AssetTryRunRequest(streamer);
+			}
+			for (uint32 i = 0; i < face_count; i++) {
+				faces[i] = streamer->jobs[job_indices[i]].diff_map;
+			}
+		} else if (valid) {
+			AB_CORE_ERROR("Failed to load cubemap. Failed to allocate staging memory: %u64 bytes", staging_size);
+		}
+
+		for (uint32 i = 0; i < jobs_taken; i++) {
+			_AssetReleaseJobFile(&streamer->jobs[job_indices[i]]);
+			streamer->free_jobs[streamer->free_jobs_count] = job_indices[i];
+			streamer->free_jobs_count++;
+		}
+		return staging;
+	}
+
+	uint32 AssetCreateCubemapBMP(AssetManager* mgr, const char* const face_paths[API::CUBEMAP_FACE_COUNT], API::TextureParameters params) {
+		uint32 result = 0;
+		Image faces[API::CUBEMAP_FACE_COUNT];
+		byte* staging = _AssetDecodeCubemapFaces(&mgr->streamer, face_paths, faces);
+		if (staging) {
+			result = API::CreateCubemap(params, faces);
+			DebugFreeFileMemory(staging);
+		}
+		return result;
+	}
+
+	void AssetProcessCompletions(AssetManager* mgr) {
+		AssetStreamer* streamer = &mgr->streamer;
+		for (uint32 i = 0; i < ASSET_MAX_FINALIZE_PER_FRAME; i++) {
+			volatile uint32* entry = &streamer->completions[streamer->completion_read & (ASSET_LOAD_QUEUE_SIZE - 1)];
+			uint32 value = AtomicLoad32(entry);
+			if (!value) {
+				break;
+			}
+			AtomicExchange32(entry, 0);
+			streamer->completion_read++;
+
+			uint32 job_index = value - 1;
+			AssetLoadJob* job = &streamer->jobs[job_index];
+			switch (job->type) {
+			case AssetLoadType::Mesh: {
+				Mesh* slot = &mgr->meshes[job->handle];
+				if (job->succeeded) {
+					_AssetFinalizeMeshAAB(mgr, slot, job);
+				} else {
+					slot->state = AssetState::Failed;
+				}
+			} break;
+			case AssetLoadType::Texture: {
+				Texture* slot = &mgr->textures[job->handle];
+				if (!(job->succeeded && _AssetFillTextureFromImage(mgr, slot, &job->diff_map, job->path))) {
+					slot->state = AssetState::Failed;
+				}
+			} break;
+			default: {} break;
+			}
+
+			streamer->free_jobs[streamer->free_jobs_count] = job_index;
+			streamer->free_jobs_count++;
+		}
+	}
+
+	AssetState AssetGetMeshState(AssetManager* mgr, int32 mesh_handle) {
+		if (mesh_handle >= 0 && (uint32)mesh_handle < MESH_STORAGE_CAPACITY && mgr->mesh_storage_usage[mesh_handle]) {
+			return mgr->meshes[mesh_handle].state;
 		} else {
-			AB_CORE_ERROR("Faied to create texture forom file: %s", bmp_path);
-			return ASSET_INVALID_HANDLE;
+			return AssetState::Unloaded;
+		}
+	}
+
+	AssetState AssetGetTextureState(AssetManager* mgr, int32 texture_handle) {
+		if (texture_handle >= 0 && (uint32)texture_handle < TEXTURE_STORAGE_CAPACITY && mgr->texture_storage_usage[texture_handle]) {
+			return mgr->textures[texture_handle].state;
+		} else {
+			return AssetState::Unloaded;
 		}
 	}
 
+	Mesh* AssetGetMeshData(AssetManager* mgr, int32 mesh_handle) {
+		if (AssetGetMeshState(mgr, mesh_handle) == AssetState::Resident) {
+			return &mgr->meshes[mesh_handle];
+		} else {
+			return nullptr;
+		}
+	}
+
+	Texture* AssetGetTextureData(AssetManager* mgr, int32 texture_handle) {
+		if (AssetGetTextureState(mgr, texture_handle) == AssetState::Resident) {
+			return &mgr->textures[texture_handle];
+		} else {
+			return nullptr;
+		}
+	}
+
+	void AssetDestroyMesh(AssetManager* mgr, int32 mesh_handle) {
+		AssetState state = AssetGetMeshState(mgr, mesh_handle);
+		if (state == AssetState::Pending) {
+			// TODO: Cancellation of in-flight loads
+			AB_CORE_WARN("Can not destroy mesh while it is loading. Handle: %i32", mesh_handle);
+		} else if (state != AssetState::Unloaded) {
+			Mesh* mesh = &mgr->meshes[mesh_handle];
+			if (state == AssetState::Resident) {
+				GLCall(glDeleteBuffers(1, &mesh->api_vb_handle));
+				if (mesh->api_ib_handle) {
+					GLCall(glDeleteBuffers(1, &mesh->api_ib_handle));
+				}
+				SizeClassFree(&mgr->asset_heap, mesh->mem_begin, mesh->mem_size);
+			}
+			mgr->mesh_storage_usage[mesh_handle] = false;
+			PoolFree(&mgr->mesh_pool, mesh);
+		}
+	}
+
+	void AssetDestroyTexture(AssetManager* mgr, int32 texture_handle) {
+		AssetState state = AssetGetTextureState(mgr, texture_handle);
+		if (state == AssetState::Pending) {
+			// TODO: Cancellation of in-flight loads
+			AB_CORE_WARN("Can not destroy texture while it is loading. Handle: %i32", texture_handle);
+		} else if (state != AssetState::Unloaded) {
+			Texture* texture = &mgr->textures[texture_handle];
+			if (state == AssetState::Resident) {
+				GLCall(glDeleteTextures(1, &texture->api_handle));
+				SizeClassFree(&mgr->asset_heap, texture->mem_begin, texture->mem_size);
+			}
+			mgr->texture_storage_usage[texture_handle] = false;
+			PoolFree(&mgr->texture_pool, texture);
+		}
+	}
+
+	AssetStorageStats AssetGetStorageStats(AssetManager* mgr) {
+		AssetStorageStats stats = {};
+		stats.meshes_used = mgr->mesh_pool.used;
+		stats.meshes_peak = mgr->mesh_pool.peak_used;
+		stats.textures_used = mgr->texture_pool.used;
+		stats.textures_peak = mgr->texture_pool.peak_used;
+		stats.loads_in_flight = ASSET_LOAD_QUEUE_SIZE - mgr->streamer.free_jobs_count;
+		stats.heap = SizeClassGetStats(&mgr->asset_heap);
+		return stats;
+	}
 }
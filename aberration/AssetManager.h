@@ -1,11 +1,30 @@
 #pragma once
 #include "AB.h"
+#include "platform/Memory.h"
+#include "platform/Common.h"
+#include "utils/ImageLoader.h"
+#include "FileFormats.h"
+#include "platform/API/GraphicsAPI.h"
 #include <hypermath.h>
 
 namespace AB {
 	constexpr uint32 MESH_STORAGE_CAPACITY = 128;
 	constexpr uint32 TEXTURE_STORAGE_CAPACITY = 128;
 	constexpr int32 ASSET_INVALID_HANDLE = -1;
+	// NOTE: Should be power of two
+	constexpr uint32 ASSET_LOAD_QUEUE_SIZE = 64;
+	constexpr uint32 ASSET_MAX_WORKER_THREADS = 4;
+	// Limits amount of GL uploads per frame
+	constexpr uint32 ASSET_MAX_FINALIZE_PER_FRAME = 8;
+	constexpr uint32 ASSET_PATH_SIZE = 256;
+	constexpr uint32 ASSET_MAX_MOUNTED_PACKS = 4;
+
+	enum class AssetState : uint32 {
+		Unloaded = 0,
+		Pending,
+		Resident,
+		Failed
+	};
 
 	struct Material {
 		hpm::Vector3 ambient;
@@ -18,12 +37,32 @@ namespace AB {
 	};
 
 	struct Mesh {
+		AssetState state;
 		uint32 api_vb_handle;
 		uint32 api_ib_handle;
 		uint32 num_vertices;
+		// NOTE: Index count of lod 0. Index buffer and CPU copy of indices contain all lods
 		uint32 num_indices;
+		uint32 num_lods;
+		AABMeshLOD lods[AAB_MAX_LODS];
+		// NOTE: Meshlets of lod i are [lod_first_meshlet[i], lod_first_meshlet[i + 1]).
+		// Lods without meshlets have empty range and are drawn as a whole
+		uint32 num_meshlets;
+		uint32 lod_first_meshlet[AAB_MAX_LODS + 1];
+		AABMeshlet* meshlets;
+		// NOTE: Format of data in GPU buffers. CPU copies are always float32 and uint32
+		AABVertexFormat vertex_format;
+		// NOTE: Offsets of attribute streams in vertex buffer.
+		// Positions always start at 0, so 0 means that stream is absent.
+		uint64 vb_uv_offset;
+		uint64 vb_normal_offset;
+		hpm::Vector3 aabb_min;
+		hpm::Vector3 aabb_max;
+		hpm::Vector3 bsphere_center;
+		float32 bsphere_radius;
 		uint64 mem_size;
 		byte* mem_begin;
+		// NOTE: CPU side copies of mesh data. Null if mesh was loaded without retaining them.
 		hpm::Vector3* positions;
 		hpm::Vector2* uvs;
 		hpm::Vector3* normals;
@@ -34,6 +73,7 @@ namespace AB {
 	// TODO: Hash map for associating texture names and handles
 
 	struct Texture {
+		AssetState state;
 		uint32 api_handle;
 		uint64 mem_size;
 		byte* mem_begin;
@@ -41,11 +81,93 @@ namespace AB {
 		char* name;
 	};
 
+	enum class AssetLoadType : uint32 {
+		Mesh,
+		Texture,
+		// NOTE: Decodes BMP into preallocated staging memory. Completion is reported
+		// to the batch counter instead of completion queue
+		CubemapFace
+	};
+
+	struct AssetPack {
+		MappedFile file;
+		ABPackHeader* header;
+		ABPackEntry* toc;
+		const char* names;
+		// NOTE: Asset paths starting with this prefix are resolved in the pack
+		char mount_prefix[ASSET_PATH_SIZE];
+		uint32 mount_prefix_size;
+	};
+
+	// NOTE: Packs are never modified after mounting, so workers read them without locks
+	struct AssetPackTable {
+		uint32 count;
+		AssetPack packs[ASSET_MAX_MOUNTED_PACKS];
+	};
+
+	// NOTE: Job is filled by worker thread and finalized on the main thread.
+	// Texture and cubemap face jobs use diff_map for the image.
+	struct AssetLoadJob {
+		AssetLoadType type;
+		int32 handle;
+		bool32 retain_cpu_data;
+		bool32 succeeded;
+		MappedFile file;
+		// NOTE: Packed files point into pack mapping and are not unmapped
+		bool32 file_packed;
+		// NOTE: Compressed files are decompressed to memory allocated with DebugAllocFileMemory
+		bool32 file_decompressed;
+		// NOTE: Older versions are converted to current header on load
+		AABMeshHeader header;
+		Image diff_map;
+		Image spec_map;
+		// NOTE: Cubemap faces only. File is mapped and parsed by the main thread
+		BMPInfo bmp_info;
+		byte* staging;
+		volatile uint32* batch_done;
+		char path[ASSET_PATH_SIZE];
+	};
+
+	struct AssetStreamer {
+		SemaphoreHandle semaphore;
+		AssetPackTable* packs;
+		uint32 worker_count;
+		// NOTE: Jobs are allocated and freed only on the main thread
+		uint32 free_jobs_count;
+		uint32 free_jobs[ASSET_LOAD_QUEUE_SIZE];
+		AssetLoadJob jobs[ASSET_LOAD_QUEUE_SIZE];
+		// Main thread -> workers. Single producer, workers claim entries with CAS
+		volatile uint32 request_write;
+		volatile uint32 request_read;
+		uint32 requests[ASSET_LOAD_QUEUE_SIZE];
+		// Workers -> main thread. Producers reserve a slot and publish job index + 1.
+		// Never overflows because there is no more than ASSET_LOAD_QUEUE_SIZE jobs in flight
+		volatile uint32 completion_reserve;
+		uint32 completion_read;
+		volatile uint32 completions[ASSET_LOAD_QUEUE_SIZE];
+	};
+
 	struct AssetManager {
 		byte mesh_storage_usage[MESH_STORAGE_CAPACITY];
 		byte texture_storage_usage[TEXTURE_STORAGE_CAPACITY];
+		// Slot pools over meshes and textures arrays. Handle is an index of a slot
+		PoolAllocator mesh_pool;
+		PoolAllocator texture_pool;
+		// Mesh and texture payloads
+		SizeClassAllocator asset_heap;
 		Mesh meshes[MESH_STORAGE_CAPACITY];
 		Texture textures[TEXTURE_STORAGE_CAPACITY];
+		AssetPackTable packs;
+		AssetStreamer streamer;
+	};
+
+	struct AssetStorageStats {
+		uint32 meshes_used;
+		uint32 meshes_peak;
+		uint32 textures_used;
+		uint32 textures_peak;
+		uint32 loads_in_flight;
+		SizeClassStats heap;
 	};
 
 	enum class TextureFormat : byte {
@@ -55,10 +177,37 @@ namespace AB {
 	};
 
 	AB_API AssetManager* AssetInitialize();
+	// NOTE: Maps pack file once. Later loads of paths starting with mount_prefix are resolved
+	// by name hash in the pack and fall back to loose files if there is no such entry.
+	// Packs mounted later take precedence. Mount packs before issuing loads that should use them
+	AB_API bool32 AssetMountPack(AssetManager* mgr, const char* pack_path, const char* mount_prefix);
+	// Returns view of packed file data or zeroed struct if path is not in mounted packs.
+	// Data stays valid for the whole lifetime of asset manager
+	AB_API MappedFile AssetFindPackedFile(AssetManager* mgr, const char* path);
+	// Loads BMP from mounted packs or from loose file
+	AB_API Image AssetLoadImageBMP(AssetManager* mgr, const char* bmp_path);
 	AB_API int32 AssetCreateTexture(AssetManager* mgr, byte* bitmap, uint16 w, uint16 h, uint32 bits_per_pixel, const char* name);
+	// NOTE: Texture loads accept BMPs and cooked ABT textures with mips (see FileFormats.h).
+	// Format is detected by file content
 	AB_API int32 AssetCreateTextureBMP(AssetManager* mgr, const char* bmp_path);
 	AB_API int32 AssetCreateMesh(AssetManager* mgr, uint32 number_of_vertices, hpm::Vector3* positions, hpm::Vector2* uvs, hpm::Vector3* normals, uint32 num_of_indices, uint32* indices, Material* material);
-	AB_API int32 AssetCreateMeshAAB(AssetManager* mgr, const char* aab_path);
+	AB_API int32 AssetCreateMeshAAB(AssetManager* mgr, const char* aab_path, bool32 retain_cpu_data = true);
+	// NOTE: Async loads return handle immediately. Asset becomes available
+	// after AssetProcessCompletions finalizes it on the main thread.
+	// Until then AssetGetMeshData and AssetGetTextureData return null.
+	AB_API int32 AssetCreateMeshAABAsync(AssetManager* mgr, const char* aab_path, bool32 retain_cpu_data = true);
+	AB_API int32 AssetCreateTextureBMPAsync(AssetManager* mgr, const char* bmp_path);
+	// NOTE: Faces are BMPs in +X, -X, +Y, -Y, +Z, -Z order. They are decoded concurrently by streaming workers
+	// into single staging block and uploaded at once. Blocks until cubemap is created.
+	// Returns API texture handle or 0 if failed
+	AB_API uint32 AssetCreateCubemapBMP(AssetManager* mgr, const char* const face_paths[API::CUBEMAP_FACE_COUNT], API::TextureParameters params);
+	// Creates GL objects for finished loads. Called once per frame from main thread
+	AB_API void AssetProcessCompletions(AssetManager* mgr);
+	AB_API AssetState AssetGetMeshState(AssetManager* mgr, int32 mesh_handle);
+	AB_API AssetState AssetGetTextureState(AssetManager* mgr, int32 texture_handle);
+	AB_API void AssetDestroyMesh(AssetManager* mgr, int32 mesh_handle);
+	AB_API void AssetDestroyTexture(AssetManager* mgr, int32 texture_handle);
 	Mesh* AssetGetMeshData(AssetManager* mgr, int32 mesh_handle);
 	Texture* AssetGetTextureData(AssetManager* mgr, int32 texture_handle);
+	AB_API AssetStorageStats AssetGetStorageStats(AssetManager* mgr);
 }
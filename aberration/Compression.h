@@ -0,0 +1,358 @@
+#pragma once
+
+#include "AB.h"
+#include <cstring>
+
+// NOTE: LZ4-style block compression. Used by tools to compress assets and by the engine
+// to decompress them on load. Everything is inline so tools can use it without linking the engine.
+// Block format is the same as LZ4 block format:
+// token (literal length << 4 | match length - 4), literal length extension bytes, literals,
+// 2 byte little endian offset, match length extension bytes. Length extensions are 255 terminated.
+// Last sequence has literals only. Offsets never cross block boundaries.
+namespace AB {
+	constexpr uint32 ABZ_FILE_MAGIC_VALUE = 0xab2c0b1c;
+	constexpr uint32 ABZ_FILE_VERSION = 0;
+	constexpr uint32 ABZ_DEFAULT_BLOCK_SIZE = 256 * 1024;
+	constexpr uint32 ABZ_MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+	// NOTE: Set in block size table if block is stored without compression
+	constexpr uint32 ABZ_BLOCK_STORED_BIT = 0x80000000;
+
+	constexpr uint32 ABZ_MIN_MATCH = 4;
+	constexpr uint32 ABZ_MAX_OFFSET = 65535;
+	// NOTE: Last 5 bytes are always literals and last match starts at least 12 bytes before block end
+	constexpr uint32 ABZ_LAST_LITERALS = 5;
+	constexpr uint32 ABZ_MATCH_FIND_LIMIT = 12;
+	constexpr uint32 ABZ_HASH_LOG = 14;
+	constexpr uint32 ABZ_SKIP_TRIGGER = 6;
+
+#pragma pack(push, 1)
+	// NOTE: Layout is header | uint32 compressed block sizes [block_count] | blocks
+	// Every block except last one decompresses to block_size bytes
+	struct ABZHeader {
+		uint32 magic_value;
+		uint32 version;
+		uint64 uncompressed_size;
+		uint32 block_size;
+		uint32 block_count;
+	};
+#pragma pack(pop)
+
+	inline uint32 _ABZRead32(const byte* at) {
+		uint32 result;
+		memcpy(&result, at, sizeof(uint32));
+		return result;
+	}
+
+	inline uint32 _ABZHash(uint32 sequence) {
+		return (sequence * 2654435761u) >> (32 - ABZ_HASH_LOG);
+	}
+
+	inline byte* _ABZWriteLength(byte* at, uint32 length) {
+		while (length >= 255) {
+			*at++ = 255;
+			length -= 255;
+		}
+		*at++ = (byte)length;
+		return at;
+	}
+
+	// Worst case size of compressed block
+	inline uint32 ABZCompressBlockBound(uint32 size) {
+		return size + size / 255 + 16;
+	}
+
+	// Returns compressed size or 0 if output doesn't fit into dst_capacity
+	inline uint32 ABZCompressBlock(const byte* src, uint32 src_size, byte* dst, uint32 dst_capacity) {
+		// NOTE: Table stores positions relative to src. Zeroed entries point to the block beginning
+		// and are rejected by the match check
+		uint32 table[1 << ABZ_HASH_LOG];
+		memset(table, 0, sizeof(table));
+
+		const byte* ip = src;
+		const byte* anchor = src;
+		const byte* iend = src + src_size;
+		byte* op = dst;
+		byte* oend = dst + dst_capacity;
+
+		if (src_size > ABZ_MATCH_FIND_LIMIT) {
+			const byte* mflimit = iend - ABZ_MATCH_FIND_LIMIT;
+			const byte* matchlimit = iend - ABZ_LAST_LITERALS;
+			uint32 search_count = 1 << ABZ_SKIP_TRIGGER;
+			while (ip < mflimit) {
+				uint32 sequence = _ABZRead32(ip);
+				uint32 hash = _ABZHash(sequence);
+				const byte* ref = src + table[hash];
+				table[hash] = (uint32)(ip - src);
+				if (ref >= ip || (uint32)(ip - ref) > ABZ_MAX_OFFSET || _ABZRead32(ref) != sequence) {
+					// NOTE: Stepping faster through data which doesn't compress
+					ip += search_count++ >> ABZ_SKIP_TRIGGER;
+					continue;
+				}
+				search_count = 1 << ABZ_SKIP_TRIGGER;
+
+				while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+					ip--;
+					ref--;
+				}
+				uint32 match_length = ABZ_MIN_MATCH;
+				while (ip + match_length < matchlimit && ip[match_length] == ref[match_length]) {
+					match_length++;
+				}
+
+				uint32 literal_length = (uint32)(ip - anchor);
+				uint64 sequence_bound = 1 + literal_length + literal_length / 255 + 1 + 2 + (match_length - ABZ_MIN_MATCH) / 255 + 1;
+				if (sequence_bound > (uint64)(oend - op)) {
+					return 0;
+				}
+
+				byte* token = op++;
+				if (literal_length >= 15) {
+					*token = 15 << 4;
+					op = _ABZWriteLength(op, literal_length - 15);
+				} else {
+					*token = (byte)(literal_length << 4);
+				}
+				memcpy(op, anchor, literal_length);
+				op += literal_length;
+
+				uint32 offset = (uint32)(ip - ref);
+				op[0] = (byte)(offset & 0xff);
+				op[1] = (byte)(offset >> 8);
+				op += 2;
+
+				uint32 match_extra = match_length - ABZ_MIN_MATCH;
+				if (match_extra >= 15) {
+					*token |= 15;
+					op = _ABZWriteLength(op, match_extra - 15);
+				} else {
+					*token |= (byte)match_extra;
+				}
+
+				ip += match_length;
+				anchor = ip;
+				if (ip < mflimit) {
+					table[_ABZHash(_ABZRead32(ip - 2))] = (uint32)(ip - 2 - src);
+				}
+			}
+		}
+
+		uint32 literal_length = (uint32)(iend - anchor);
+		if ((uint64)1 + literal_length + literal_length / 255 + 1 > (uint64)(oend - op)) {
+			return 0;
+		}
+		byte* token = op++;
+		if (literal_length >= 15) {
+			*token = 15 << 4;
+			op = _ABZWriteLength(op, literal_length - 15);
+		} else {
+			*token = (byte)(literal_length << 4);
+		}
+		memcpy(op, anchor, literal_length);
+		op += literal_length;
+
+		return (uint32)(op - dst);
+	}
+
+	// NOTE: Safe for malformed input. Returns decompressed size or -1 if block is corrupted
+	// or doesn't fit into dst_size
+	inline int64 ABZDecompressBlock(const byte* src, uint32 src_size, byte* dst, uint32 dst_size) {
+		const byte* ip = src;
+		const byte* iend = src + src_size;
+		byte* op = dst;
+		byte* oend = dst + dst_size;
+
+		while (ip < iend) {
+			uint32 token = *ip++;
+
+			uint64 literal_length = token >> 4;
+			if (literal_length == 15) {
+				byte s;
+				do {
+					if (ip >= iend) return -1;
+					s = *ip++;
+					literal_length += s;
+				} while (s == 255);
+			}
+			if (literal_length > (uint64)(iend - ip) || literal_length > (uint64)(oend - op)) {
+				return -1;
+			}
+			// NOTE: Short literal runs are copied with one wide copy when there is space on both sides
+			if (literal_length <= 32 && iend - ip >= 32 && oend - op >= 32) {
+				memcpy(op, ip, 16);
+				memcpy(op + 16, ip + 16, 16);
+			} else {
+				memcpy(op, ip, literal_length);
+			}
+			op += literal_length;
+			ip += literal_length;
+
+			if (ip == iend) {
+				break;
+			}
+
+			if (iend - ip < 2) return -1;
+			uint32 offset = (uint32)ip[0] | ((uint32)ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > (uint64)(op - dst)) {
+				return -1;
+			}
+
+			uint64 match_length = token & 15;
+			if (match_length == 15) {
+				byte s;
+				do {
+					if (ip >= iend) return -1;
+					s = *ip++;
+					match_length += s;
+				} while (s == 255);
+			}
+			match_length += ABZ_MIN_MATCH;
+			if (match_length > (uint64)(oend - op)) {
+				return -1;
+			}
+
+			const byte* match = op - offset;
+			if (offset >= 16 && match_length + 16 <= (uint64)(oend - op)) {
+				// NOTE: Chunks never overlap when offset >= chunk size. May write up to chunk size - 1 bytes past the match
+				byte* end = op + match_length;
+				do {
+					memcpy(op, match, 16);
+					op += 16;
+					match += 16;
+				} while (op < end);
+				op = end;
+			} else if (offset >= 8 && match_length + 8 <= (uint64)(oend - op)) {
+				byte* end = op + match_length;
+				do {
+					memcpy(op, match, 8);
+					op += 8;
+					match += 8;
+				} while (op < end);
+				op = end;
+			} else {
+				for (uint64 i = 0; i < match_length; i++) {
+					op[i] = match[i];
+				}
+				op += match_length;
+			}
+		}
+
+		return (int64)(op - dst);
+	}
+
+	inline uint32 ABZBlockCount(uint64 size, uint32 block_size) {
+		return (uint32)((size + block_size - 1) / block_size);
+	}
+
+	inline uint64 ABZCompressBound(uint64 size, uint32 block_size = ABZ_DEFAULT_BLOCK_SIZE) {
+		uint64 block_count = ABZBlockCount(size, block_size);
+		return sizeof(ABZHeader) + block_count * sizeof(uint32) + size + block_count * (block_size / 255 + 16);
+	}
+
+	// Returns compressed size or 0 if failed. Blocks which don't compress are stored as is
+	inline uint64 ABZCompress(const void* src, uint64 src_size, void* dst, uint64 dst_capacity, uint32 block_size = ABZ_DEFAULT_BLOCK_SIZE) {
+		if (block_size == 0 || block_size > ABZ_MAX_BLOCK_SIZE) {
+			return 0;
+		}
+		uint64 block_count = ABZBlockCount(src_size, block_size);
+		uint64 table_end = sizeof(ABZHeader) + block_count * sizeof(uint32);
+		if (block_count > 0xffffffff || table_end > dst_capacity) {
+			return 0;
+		}
+
+		byte* out = (byte*)dst;
+		ABZHeader header = {};
+		header.magic_value = ABZ_FILE_MAGIC_VALUE;
+		header.version = ABZ_FILE_VERSION;
+		header.uncompressed_size = src_size;
+		header.block_size = block_size;
+		header.block_count = (uint32)block_count;
+		memcpy(out, &header, sizeof(ABZHeader));
+
+		uint32* block_sizes = (uint32*)(out + sizeof(ABZHeader));
+		uint64 at = table_end;
+		for (uint64 i = 0; i < block_count; i++) {
+			const byte* block = (const byte*)src + i * block_size;
+			uint32 size = (uint32)(i + 1 == block_count ? src_size - i * block_size : block_size);
+			uint64 available = dst_capacity - at;
+			uint32 capacity = available < size ? (uint32)available : size - 1;
+			uint32 compressed = size > 1 ? ABZCompressBlock(block, size, out + at, capacity) : 0;
+			if (compressed) {
+				block_sizes[i] = compressed;
+			} else if (available >= size) {
+				memcpy(out + at, block, size);
+				compressed = size;
+				block_sizes[i] = size | ABZ_BLOCK_STORED_BIT;
+			} else {
+				return 0;
+			}
+			at += compressed;
+		}
+		return at;
+	}
+
+	// Returns true if data starts with valid ABZ header
+	inline bool32 ABZIsCompressed(const void* data, uint64 size) {
+		bool32 result = false;
+		if (size >= sizeof(ABZHeader)) {
+			ABZHeader header;
+			memcpy(&header, data, sizeof(ABZHeader));
+			result = header.magic_value == ABZ_FILE_MAGIC_VALUE
+				&& header.version == ABZ_FILE_VERSION
+				&& header.block_size && header.block_size <= ABZ_MAX_BLOCK_SIZE
+				&& header.block_count == ABZBlockCount(header.uncompressed_size, header.block_size)
+				&& sizeof(ABZHeader) + (uint64)header.block_count * sizeof(uint32) <= size;
+		}
+		return result;
+	}
+
+	// Data should be checked with ABZIsCompressed first
+	inline uint64 ABZUncompressedSize(const void* data) {
+		ABZHeader header;
+		memcpy(&header, data, sizeof(ABZHeader));
+		return header.uncompressed_size;
+	}
+
+	// NOTE: Blocks are independent so ranges can be decompressed in parallel.
+	// dst points to the beginning of whole uncompressed data. Returns false if data is corrupted
+	inline bool32 ABZDecompressBlocks(const void* data, uint64 size, void* dst, uint64 dst_size, uint32 first_block, uint32 end_block) {
+		ABZHeader header;
+		memcpy(&header, data, sizeof(ABZHeader));
+		if (dst_size < header.uncompressed_size || end_block > header.block_count || first_block > end_block) {
+			return false;
+		}
+
+		const byte* begin = (const byte*)data;
+		const uint32* block_sizes = (const uint32*)(begin + sizeof(ABZHeader));
+		uint64 at = sizeof(ABZHeader) + (uint64)header.block_count * sizeof(uint32);
+		for (uint32 i = 0; i < first_block; i++) {
+			at += block_sizes[i] & ~ABZ_BLOCK_STORED_BIT;
+		}
+
+		for (uint32 i = first_block; i < end_block; i++) {
+			uint32 compressed = block_sizes[i] & ~ABZ_BLOCK_STORED_BIT;
+			uint64 block_offset = (uint64)i * header.block_size;
+			uint32 block_size = (uint32)(i + 1 == header.block_count ? header.uncompressed_size - block_offset : header.block_size);
+			if (at + compressed > size) {
+				return false;
+			}
+			byte* out = (byte*)dst + block_offset;
+			if (block_sizes[i] & ABZ_BLOCK_STORED_BIT) {
+				if (compressed != block_size) {
+					return false;
+				}
+				memcpy(out, begin + at, block_size);
+			} else if (ABZDecompressBlock(begin + at, compressed, out, block_size) != (int64)block_size) {
+				return false;
+			}
+			at += compressed;
+		}
+		return true;
+	}
+
+	inline bool32 ABZDecompress(const void* data, uint64 size, void* dst, uint64 dst_size) {
+		ABZHeader header;
+		memcpy(&header, data, sizeof(ABZHeader));
+		return ABZDecompressBlocks(data, size, dst, dst_size, 0, header.block_count);
+	}
+}
@@ -2,13 +2,230 @@
 
 #include "AB.h"
 #include <hypermath.h>
+#include <cstring>
+#include <cstddef>
 
 namespace AB {
 	enum AABFileType : uint32 {
 		AAB_FILE_TYPE_MESH = 0x01020304
 	};
 	constexpr uint32 AAB_FILE_MAGIC_VALUE = 0xaabaabaa;
-	constexpr uint32 AAB_FILE_VERSION = 0;
+	constexpr uint32 AAB_FILE_VERSION_0 = 0;
+	constexpr uint32 AAB_FILE_VERSION_1 = 1;
+	constexpr uint32 AAB_FILE_VERSION_2 = 2;
+	constexpr uint32 AAB_FILE_VERSION = 3;
+	// NOTE: v3 layout is header | vertices | normals | uvs | indices | lods | meshlets | material properties | strings
+	// First stream starts at 64 byte boundary, every next section at 16 byte boundary.
+	// Strings are packed at the end of file so they never break aligment.
+	// v2 is the same without meshlets section and meshlet fields in the header,
+	// v1 is v2 without lods
+	constexpr uint64 AAB_FIRST_STREAM_ALIGMENT = 64;
+	constexpr uint64 AAB_SECTION_ALIGMENT = 16;
+	constexpr uint32 AAB_MAX_LODS = 8;
+	constexpr uint32 AAB_MESHLET_MAX_VERTICES = 64;
+	constexpr uint32 AAB_MESHLET_MAX_TRIANGLES = 124;
+
+	enum AABVertexAttribFormat : byte {
+		AAB_VERTEX_ATTRIB_NONE = 0,
+		AAB_VERTEX_ATTRIB_FLOAT32,
+		// Quantized relative to mesh AABB: p = aabb_min + (q / 65535) * (aabb_max - aabb_min)
+		AAB_VERTEX_ATTRIB_UNORM16,
+		// Octahedral encoded unit vector. Two components
+		AAB_VERTEX_ATTRIB_OCT_SNORM16,
+		AAB_VERTEX_ATTRIB_FLOAT16
+	};
+
+	enum AABIndexFormat : byte {
+		AAB_INDEX_FORMAT_NONE = 0,
+		AAB_INDEX_FORMAT_UINT32,
+		AAB_INDEX_FORMAT_UINT16
+	};
+
+	inline uint32 AABVertexAttribFormatSize(byte format) {
+		switch (format) {
+		case AAB_VERTEX_ATTRIB_FLOAT32: { return 4; }
+		case AAB_VERTEX_ATTRIB_UNORM16: { return 2; }
+		case AAB_VERTEX_ATTRIB_OCT_SNORM16: { return 2; }
+		case AAB_VERTEX_ATTRIB_FLOAT16: { return 2; }
+		default: { return 0; }
+		}
+	}
+
+	inline uint32 AABIndexFormatSize(byte format) {
+		switch (format) {
+		case AAB_INDEX_FORMAT_UINT32: { return 4; }
+		case AAB_INDEX_FORMAT_UINT16: { return 2; }
+		default: { return 0; }
+		}
+	}
+
+	// NOTE: Round to nearest even. Overflow goes to infinity
+	inline uint16 AABFloatToHalf(float32 value) {
+		uint32 bits;
+		memcpy(&bits, &value, sizeof(uint32));
+		uint32 sign = (bits >> 16) & 0x8000;
+		uint32 float_exponent = (bits >> 23) & 0xff;
+		int32 exponent = (int32)float_exponent - 127 + 15;
+		uint32 mantissa = bits & 0x7fffff;
+		uint32 result;
+		if (float_exponent == 0xff) {
+			result = sign | 0x7c00 | (mantissa ? 0x200 : 0);
+		} else if (exponent >= 31) {
+			result = sign | 0x7c00;
+		} else if (exponent <= 0) {
+			if (exponent < -10) {
+				result = sign;
+			} else {
+				mantissa |= 0x800000;
+				uint32 shift = (uint32)(14 - exponent);
+				uint32 half_mantissa = mantissa >> shift;
+				uint32 remainder = mantissa & ((1u << shift) - 1);
+				uint32 halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+					half_mantissa++;
+				}
+				result = sign | half_mantissa;
+			}
+		} else {
+			result = sign | ((uint32)exponent << 10) | (mantissa >> 13);
+			uint32 remainder = mantissa & 0x1fff;
+			// NOTE: Carry into exponent is correct here
+			if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1))) {
+				result++;
+			}
+		}
+		return (uint16)result;
+	}
+
+	inline float32 AABHalfToFloat(uint16 value) {
+		uint32 sign = (uint32)(value & 0x8000) << 16;
+		int32 exponent = (value >> 10) & 0x1f;
+		uint32 mantissa = value & 0x3ff;
+		uint32 bits;
+		if (exponent == 0) {
+			if (mantissa == 0) {
+				bits = sign;
+			} else {
+				exponent = 1;
+				while (!(mantissa & 0x400)) {
+					mantissa <<= 1;
+					exponent--;
+				}
+				mantissa &= 0x3ff;
+				bits = sign | ((uint32)(exponent + 127 - 15) << 23) | (mantissa << 13);
+			}
+		} else if (exponent == 31) {
+			bits = sign | 0x7f800000 | (mantissa << 13);
+		} else {
+			bits = sign | ((uint32)(exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+		float32 result;
+		memcpy(&result, &bits, sizeof(float32));
+		return result;
+	}
+
+	inline void AABOctEncode(hpm::Vector3 n, int16* out) {
+		float32 l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+		float32 x = l1 > 0.0f ? n.x / l1 : 0.0f;
+		float32 y = l1 > 0.0f ? n.y / l1 : 0.0f;
+		if (n.z < 0.0f) {
+			float32 folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float32 folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = folded_x;
+			y = folded_y;
+		}
+		x = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+		y = y < -1.0f ? -1.0f : (y > 1.0f ? 1.0f : y);
+		out[0] = (int16)roundf(x * 32767.0f);
+		out[1] = (int16)roundf(y * 32767.0f);
+	}
+
+	inline hpm::Vector3 AABOctDecode(const int16* in) {
+		float32 x = in[0] / 32767.0f;
+		float32 y = in[1] / 32767.0f;
+		x = x < -1.0f ? -1.0f : x;
+		y = y < -1.0f ? -1.0f : y;
+		float32 z = 1.0f - fabsf(x) - fabsf(y);
+		float32 t = z < 0.0f ? -z : 0.0f;
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+		float32 len = sqrtf(x * x + y * y + z * z);
+		return { x / len, y / len, z / len };
+	}
+
+	// NOTE: Asset pack. Layout is header | entries data | toc | names
+	// Every entry starts at ABP_ENTRY_ALIGMENT boundary so AAB streams stay aligned in mapped pack.
+	// TOC is an open addressing hash table over name hashes with linear probing.
+	// Empty slots have zero hash. Names are relative paths with '/' separators
+	constexpr uint32 ABP_FILE_MAGIC_VALUE = 0xaabbacca;
+	constexpr uint32 ABP_FILE_VERSION = 0;
+	constexpr uint64 ABP_ENTRY_ALIGMENT = 64;
+
+	enum ABPCompression : uint32 {
+		ABP_COMPRESSION_NONE = 0
+	};
+
+	// FNV-1a. Backslashes are hashed as slashes. Never returns 0
+	inline uint64 ABPackHashName(const char* name) {
+		uint64 hash = 14695981039346656037ull;
+		for (const char* at = name; *at; at++) {
+			char c = *at == '\\' ? '/' : *at;
+			hash ^= (byte)c;
+			hash *= 1099511628211ull;
+		}
+		return hash ? hash : 1;
+	}
+
+	// NOTE: Cooked texture. Layout is header | mip 0 | mip 1 | ...
+	// Mips are block compressed and stored one after another without padding starting at data_offset.
+	// Rows of blocks go in the same order as rows of source bitmap, so it is uploaded as is.
+	// Mips which are smaller than a block still take a whole block
+	constexpr uint32 ABT_FILE_MAGIC_VALUE = 0xaabbadda;
+	constexpr uint32 ABT_FILE_VERSION = 0;
+	constexpr uint64 ABT_DATA_ALIGMENT = 64;
+	constexpr uint32 ABT_MAX_MIPS = 16;
+
+	enum ABTFormat : uint32 {
+		// 8 bytes per 4x4 block. Opaque RGB
+		ABT_FORMAT_BC1 = 1,
+		// 16 bytes per 4x4 block. RGB with interpolated alpha
+		ABT_FORMAT_BC3
+	};
+
+	enum ABTFlags : uint32 {
+		// Color is sRGB encoded and mips were filtered in linear space
+		ABT_FLAG_SRGB = 1
+	};
+
+	inline uint32 ABTBlockSize(uint32 format) {
+		switch (format) {
+		case ABT_FORMAT_BC1: { return 8; }
+		case ABT_FORMAT_BC3: { return 16; }
+		default: { return 0; }
+		}
+	}
+
+	inline uint32 ABTMipDimension(uint32 size, uint32 level) {
+		uint32 result = size >> level;
+		return result ? result : 1;
+	}
+
+	inline uint64 ABTMipSize(uint32 format, uint32 width, uint32 height, uint32 level) {
+		uint64 blocks_x = (ABTMipDimension(width, level) + 3) / 4;
+		uint64 blocks_y = (ABTMipDimension(height, level) + 3) / 4;
+		return blocks_x * blocks_y * ABTBlockSize(format);
+	}
+
+	// Number of mips in full chain down to 1x1
+	inline uint32 ABTFullMipCount(uint32 width, uint32 height) {
+		uint32 size = width > height ? width : height;
+		uint32 result = 1;
+		while (size > 1) {
+			size >>= 1;
+			result++;
+		}
+		return result;
+	}
 
 #pragma pack(push, 1)
 	struct AABMeshMaterialProperties {
@@ -19,7 +236,76 @@ namespace AB {
 		float32 shininess;
 	};
 
+	// Describes how vertex streams are stored. Streams are not interleaved
+	struct AABVertexFormat {
+		byte position_format;
+		byte position_components;
+		byte normal_format;
+		byte normal_components;
+		byte uv_format;
+		byte uv_components;
+		byte index_format;
+		byte reserved;
+	};
+
 	struct AABMeshHeader {
+		uint32 magic_value;
+		uint32 version;
+		uint64 asset_size;	// Size of data starting from vertices_offset
+		uint32 asset_type;
+		uint32 vertices_count;
+		uint32 normals_count;
+		uint32 uvs_count;
+		uint32 indices_count;
+		AABVertexFormat vertex_format;
+		uint64 vertices_offset;
+		uint64 normals_offset;
+		uint64 uvs_offset;		// Zero if there is no uvs
+		uint64 indices_offset;
+		uint64 material_properties_offset;	// All material offsets are zero if there is no material
+		uint64 material_name_offset;
+		uint64 material_diff_bitmap_name_offset;
+		uint64 material_spec_bitmap_name_offset;
+		hpm::Vector3 aabb_min;
+		hpm::Vector3 aabb_max;
+		hpm::Vector3 bsphere_center;
+		float32 bsphere_radius;
+		// NOTE: v2. Zero lods means that whole index stream is a single lod
+		uint32 lods_count;
+		uint64 lods_offset;
+		// NOTE: v3. Zero meshlets means that mesh is drawn by whole lods
+		uint32 meshlets_count;
+		uint64 meshlets_offset;
+	};
+
+	// NOTE: All lods share vertex streams. Index stream is lod 0 followed by coarser lods.
+	// Lods are sorted by increasing error
+	struct AABMeshLOD {
+		uint32 indices_offset;	// In indices, not bytes
+		uint32 indices_count;
+		// Simplification error in mesh units. Zero for lod 0
+		float32 error;
+	};
+
+	// NOTE: Meshlet is a cluster of at most AAB_MESHLET_MAX_VERTICES vertices and AAB_MESHLET_MAX_TRIANGLES triangles.
+	// Meshlets are sorted by indices_offset and meshlets of a lod cover its index range without gaps.
+	// Lods may have no meshlets at all.
+	// Cluster is backfacing for every viewer position p which satisfies
+	// dot(center - p, cone_axis) >= cone_cutoff * length(center - p) + radius
+	struct AABMeshlet {
+		uint32 indices_offset;	// In indices, not bytes
+		uint32 indices_count;
+		hpm::Vector3 center;
+		float32 radius;
+		hpm::Vector3 cone_axis;
+		// Sine of the normal cone half angle. 1 if cluster can't be culled by the cone
+		float32 cone_cutoff;
+	};
+
+	constexpr uint64 AAB_MESH_HEADER_V1_SIZE = offsetof(AABMeshHeader, lods_count);
+	constexpr uint64 AAB_MESH_HEADER_V2_SIZE = offsetof(AABMeshHeader, meshlets_count);
+
+	struct AABMeshHeaderV0 {
 		uint32 magic_value;
 		uint32 version;
 		uint64 asset_size;
@@ -37,5 +323,37 @@ namespace AB {
 		uint64 material_spec_bitmap_name_offset;
 		uint64 material_properties_offset;
 	};
+
+	struct ABPackHeader {
+		uint32 magic_value;
+		uint32 version;
+		uint32 entry_count;
+		uint32 toc_capacity;	// Power of two
+		uint64 toc_offset;
+		uint64 names_offset;
+		uint64 names_size;
+	};
+
+	struct ABPackEntry {
+		uint64 name_hash;
+		uint64 offset;
+		uint64 size;	// Stored size
+		uint64 uncompressed_size;
+		uint32 compression;
+		uint32 name_offset;		// Offset of null terminated name in names section
+	};
+
+	struct ABTHeader {
+		uint32 magic_value;
+		uint32 version;
+		uint32 format;	// ABTFormat
+		uint32 flags;	// ABTFlags
+		uint32 width;
+		uint32 height;
+		uint32 mip_count;
+		uint32 reserved;
+		uint64 data_offset;
+		uint64 data_size;	// Size of all mips
+	};
 #pragma pack (pop)
 }
@@ -62,87 +62,27 @@ namespace AB::API {
 		return {filter, wrap};
 	}
 	
-	uint32 CreateCubemap(TextureParameters params,
-						 Image px, Image nx,
-						 Image py, Image ny,
-						 Image pz, Image nz) {
-		uint32 resultHandle;
-		GLuint texHandle;
+	uint32 CreateCubemap(TextureParameters params, const Image faces[CUBEMAP_FACE_COUNT]) {
+		uint32 resultHandle = 0;
+		GLuint texHandle = 0;
 		GLCall(glGenTextures(1, &texHandle));
 		if (texHandle) {
 			GLCall(glBindTexture(GL_TEXTURE_CUBE_MAP, texHandle));
 
-			OpenglTextureFormat f = OpenglResolveTexFormat(px.format);	
-			GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X,
-								0,
-								f.internalFormat,
-								px.width,
-								px.height,
-								0,
-								f.format,
-								GL_UNSIGNED_BYTE,
-								px.bitmap
-								));
-			
-			f = OpenglResolveTexFormat(nx.format);
-			GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
-								0,
-								f.internalFormat,
-								nx.width,
-								nx.height,
-								0,
-								f.format,
-								GL_UNSIGNED_BYTE,
-								nx.bitmap
-								));
-
-			f = OpenglResolveTexFormat(py.format);
-			GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
-								0,
-								f.internalFormat,
-								py.width,
-								py.height,
-								0,
-								f.format,
-								GL_UNSIGNED_BYTE,
-								py.bitmap
-								));
-
-			f = OpenglResolveTexFormat(ny.format);
-			GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
-								0,
-								f.internalFormat,
-								ny.width,
-								ny.height,
-								0,
-								f.format,
-								GL_UNSIGNED_BYTE,
-								ny.bitmap
-								));
-
-			f = OpenglResolveTexFormat(pz.format);
-			GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
-								0,
-								f.internalFormat,
-								pz.width,
-								pz.height,
-								0,
-								f.format,
-								GL_UNSIGNED_BYTE,
-								pz.bitmap
-								));
-
-			f = OpenglResolveTexFormat(nz.format);
-			GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
-								0,
-								f.internalFormat,
-								nz.width,
-								nz.height,
-								0,
-								f.format,
-								GL_UNSIGNED_BYTE,
-								nz.bitmap
-								));
+			// NOTE: Face targets are consecutive in +X, -X, +Y, -Y, +Z, -Z order
+			for (uint32 i = 0; i < CUBEMAP_FACE_COUNT; i++) {
+				OpenglTextureFormat f = OpenglResolveTexFormat(faces[i].format);
+				GLCall(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+									0,
+									f.internalFormat,
+									faces[i].width,
+									faces[i].height,
+									0,
+									f.format,
+									GL_UNSIGNED_BYTE,
+									faces[i].bitmap
+									));
+			}
 
 			OpenglTextureParams p = OpenglResolveTexParams(params);
 			GLCall(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
@@ -161,6 +101,13 @@ namespace AB::API {
 			AB_CORE_ERROR("Failed to create cubemap texture: OpenGL API error");
 		}
 		return resultHandle;
+	}
 
+	uint32 CreateCubemap(TextureParameters params,
+						 Image px, Image nx,
+						 Image py, Image ny,
+						 Image pz, Image nz) {
+		Image faces[CUBEMAP_FACE_COUNT] = {px, nx, py, ny, pz, nz};
+		return CreateCubemap(params, faces);
 	}
 }
@@ -21,6 +21,10 @@ namespace AB::API
 		TextureWrapMode wrapMode;
 	};
 	
+	constexpr uint32 CUBEMAP_FACE_COUNT = 6;
+
+	// NOTE: Faces are in +X, -X, +Y, -Y, +Z, -Z order. Returns 0 if failed
+	AB_API uint32 CreateCubemap(TextureParameters params, const Image faces[CUBEMAP_FACE_COUNT]);
 	AB_API uint32 CreateCubemap(TextureParameters params,
 						 Image px, Image nx,
 						 Image py, Image ny,
@@ -363,6 +363,7 @@ static const char* procNames[AB_OPENGL_FUNCTIONS_COUNT] = {
 };
 
 ABGLExtensionsProcs _ABOpenGLExtProcs = {};
+ABGLOptionalProcs _ABOpenGLOptProcs = {};
 
 static const char* EXTprocNames[AB_OPENGL_EXTENSIONS_FUNCTIONS_COUNT] = {
 	"glGetSubroutineUniformLocation",
@@ -422,6 +423,9 @@ bool32 AB::GL::LoadExtensions() {
 		if (strcmp((const char*)extensionsString, "GL_ARB_shader_subroutine") == 0) {
 			shader_subroutine_supported = true;
 		}
+		if (strcmp((const char*)extensionsString, "GL_ARB_buffer_storage") == 0) {
+			_ABOpenGLOptProcs._glBufferStorage = (PFNGLBUFFERSTORAGEPROC)wglGetProcAddress("glBufferStorage");
+		}
 	}	
 
 	// NOTE: This retrieves pointers from wglGetProcAddress 
@@ -515,6 +519,18 @@ bool32 AB::GL::LoadExtensions() {
 			result = false;
 		}
 	}
+
+	// NOTE: glXGetProcAddress returns non null pointers for unsupported procedures,
+	// so optional ones are loaded only if extension is listed
+	GLint numExtensions;
+	GLCall(glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions));
+	for (int32 i = 0; i < numExtensions; i++) {
+		const GLubyte* extensionsString;
+		GLCall(extensionsString = glGetStringi(GL_EXTENSIONS, i));
+		if (strcmp((const char*)extensionsString, "GL_ARB_buffer_storage") == 0) {
+			_ABOpenGLOptProcs._glBufferStorage = (PFNGLBUFFERSTORAGEPROC)_glXGetProcAddress((const uchar*)"glBufferStorage");
+		}
+	}
 	return result;
 }
 
@@ -981,6 +981,9 @@ typedef void(*PROC)(void);
 #define GL_COMPRESSED_SIGNED_RED_RGTC1                   0x8DBC
 #define GL_COMPRESSED_RG_RGTC2                           0x8DBD
 #define GL_COMPRESSED_SIGNED_RG_RGTC2                    0x8DBE
+// EXT_texture_compression_s3tc
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT                  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT                 0x83F3
 #define GL_RG                                            0x8227
 #define GL_RG_INTEGER                                    0x8228
 #define GL_R8                                            0x8229
@@ -1532,6 +1535,14 @@ typedef GLvoid (APIENTRYP PFNGLUNIFORMSUBROUTINESUIVPROC) (GLenum shadertype, GL
 typedef GLvoid (APIENTRYP PFNGLGETUNIFORMSUBROUTINEUIVPROC) (GLenum shadertype, GLint location,	GLuint *params);
 typedef GLvoid (APIENTRYP PFNGLGETPROGRAMSTAGEIVPROC) (GLuint program, GLenum shadertype, GLenum pname, GLint *values);
 
+// GL_ARB_buffer_storage
+#define GL_MAP_PERSISTENT_BIT                            0x0040
+#define GL_MAP_COHERENT_BIT                              0x0080
+#define GL_DYNAMIC_STORAGE_BIT                           0x0100
+#define GL_CLIENT_STORAGE_BIT                            0x0200
+
+typedef void   (APIENTRYP PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
 
 #define AB_OPENGL_FUNCTIONS_COUNT 345
 #define AB_OPENGL_EXTENSIONS_FUNCTIONS_COUNT 8
@@ -1550,6 +1561,11 @@ union ABGLExtensionsProcs {
 	};
 };
 
+// NOTE: Procedures of optional extensions. Null if extension isn't supported
+struct ABGLOptionalProcs {
+	PFNGLBUFFERSTORAGEPROC _glBufferStorage;
+};
+
 union ABGLProcs {
 	AB_GLFUNCPTR procs[AB_OPENGL_FUNCTIONS_COUNT];
 	struct {
@@ -1915,6 +1931,7 @@ union ABGLProcs {
 
 extern AB_API ABGLProcs _ABOpenGLProcs;
 extern AB_API ABGLExtensionsProcs _ABOpenGLExtProcs;
+extern AB_API ABGLOptionalProcs _ABOpenGLOptProcs;
 
 // GL_ARB_shader_subroutine
 #define glGetSubroutineUniformLocationARB          _ABOpenGLExtProcs._glGetSubroutineUniformLocationARB
@@ -1926,6 +1943,9 @@ extern AB_API ABGLExtensionsProcs _ABOpenGLExtProcs;
 #define glGetUniformSubroutineuivARB			   _ABOpenGLExtProcs._glGetUniformSubroutineuivARB
 #define glGetProgramStageivARB					   _ABOpenGLExtProcs._glGetProgramStageivARB
 
+// GL_ARB_buffer_storage
+#define glBufferStorage							   _ABOpenGLOptProcs._glBufferStorage
+
 // OpenGL 1.0
 #define glCullFace					_ABOpenGLProcs._glCullFace
 #define glFrontFace					_ABOpenGLProcs._glFrontFace
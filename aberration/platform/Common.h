@@ -34,6 +34,32 @@ namespace AB {
 
 	AB_API void GetLocalTime(DateTime& datetime);
 
+	// Reserves address space without backing it with physical memory
+	void* ReserveVirtualMemory(uint64 size);
+	// Makes reserved pages usable. Committed memory is zeroed
+	bool32 CommitVirtualMemory(void* address, uint64 size);
+	// Hint for the system to back the region with huge pages. Returns false if not supported
+	bool32 AdviseHugePages(void* address, uint64 size);
+
+	typedef void(ThreadProc)(void* data);
+	typedef void* SemaphoreHandle;
+
+	uint32 GetLogicalProcessorCount();
+	// Starts detached thread. Returns false if failed
+	bool32 CreateWorkerThread(ThreadProc* proc, void* data);
+	SemaphoreHandle SemaphoreCreate(uint32 initial_count);
+	void SemaphoreWait(SemaphoreHandle semaphore);
+	void SemaphoreSignal(SemaphoreHandle semaphore);
+
+	// NOTE: All atomic operations act as full memory barriers
+	// Returns initial value of dest
+	uint32 AtomicCompareExchange32(volatile uint32* dest, uint32 exchange, uint32 comparand);
+	// Returns initial value of dest
+	uint32 AtomicExchange32(volatile uint32* dest, uint32 value);
+	// Returns incremented value
+	uint32 AtomicIncrement32(volatile uint32* dest);
+	uint32 AtomicLoad32(volatile uint32* src);
+
 	struct DebugReadTextFileRet {
 		char* data;
 		uint32 size;
@@ -50,6 +76,17 @@ namespace AB {
 	
 	AB_API DebugReadFileOffsetRet DebugReadFileOffset(const char* filename, uint32 offset, uint32 size);
 
+	struct MappedFile {
+		void* data;
+		uint64 size;
+	};
+
+	// Maps whole file into memory for reading. Returns zeroed struct if failed
+	AB_API MappedFile DebugMapFile(const char* filename);
+	AB_API void DebugUnmapFile(MappedFile* file);
+
+	// Allocates memory which can be released with DebugFreeFileMemory
+	AB_API void* DebugAllocFileMemory(uint64 size);
 	AB_API void DebugFreeFileMemory(void* memory);
 	AB_API bool32 DebugWriteFile(const char* filename,  void* data, uint32 dataSize);
 }
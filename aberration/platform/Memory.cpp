@@ -1,4 +1,5 @@
 #include "Memory.h"
+#include "Common.h"
 #include "utils/Log.h"
 
 #include <cstdlib>
@@ -19,16 +20,32 @@ namespace AB {
 		return padding;
 	}
 
-	Memory* CreateMemoryContext() {
+	Memory* CreateMemoryContext(bool32 huge_pages) {
 		if (!g_MemoryContext) {
 			g_MemoryContext = (Memory*)malloc(sizeof(Memory));
 			AB_CORE_ASSERT(g_MemoryContext, "Failed to allocate game memory.");
 			memset(g_MemoryContext, 0, sizeof(Memory));
 
-			uint64 sys_chunk_pad = CalculatePadding(g_MemoryContext->sys_storage._raw[0], DEFAULT_ALIGMENT);
-			AB_CORE_ASSERT((g_MemoryContext->sys_storage._raw[0] + sys_chunk_pad) % DEFAULT_ALIGMENT == 0, "Aligment error");
-			g_MemoryContext->sys_storage._internal.begin = g_MemoryContext->sys_storage._raw + sys_chunk_pad;
-			g_MemoryContext->sys_storage._internal.free = SYS_STORAGE_TOTAL_SIZE - sys_chunk_pad - sizeof(_SysAllocatorData);
+			// Reserving one granule more to align beginning of the storage to the granularity.
+			// Huge pages can only back 2MB aligned regions
+			_SysAllocatorData* sys = &g_MemoryContext->sys_storage._internal;
+			uint64 reserve_size = SYS_STORAGE_RESERVE_SIZE + SYS_STORAGE_COMMIT_GRANULARITY;
+			void* reserved = ReserveVirtualMemory(reserve_size);
+			AB_CORE_ASSERT(reserved, "Failed to reserve system storage.");
+			uint64 sys_chunk_pad = CalculatePadding((uintptr)reserved, SYS_STORAGE_COMMIT_GRANULARITY);
+			sys->begin = (byte*)reserved + sys_chunk_pad;
+			sys->reserved = SYS_STORAGE_RESERVE_SIZE;
+			if (huge_pages) {
+				sys->huge_pages = AdviseHugePages(sys->begin, sys->reserved);
+				if (!sys->huge_pages) {
+					AB_CORE_WARN("Huge pages are not supported. Using regular pages for system storage.");
+				}
+			}
+
+			_FrameAllocatorData* frame = &g_MemoryContext->frame_storage._internal;
+			uint64 frame_chunk_pad = CalculatePadding((uintptr)g_MemoryContext->frame_storage._raw, DEFAULT_ALIGMENT);
+			frame->begin = g_MemoryContext->frame_storage._raw + frame_chunk_pad;
+			frame->size = FRAME_STORAGE_TOTAL_SIZE - frame_chunk_pad;
 		}
 		return g_MemoryContext;
 	}
@@ -37,39 +54,376 @@ namespace AB {
 		return g_MemoryContext;
 	}
 
-	void* SysStorageAlloc(uint64 size, uint64 aligment) {
-		uint64 padding = 0;
-		uint64 use_aligment = 0;
-		uint64 current_offset = g_MemoryContext->sys_storage._internal.offset;
-		uintptr current_address = (uintptr)g_MemoryContext->sys_storage._internal.begin + current_offset;
-		if (aligment == 0) {
-			use_aligment = DEFAULT_ALIGMENT;
-		} else {
-			use_aligment = aligment;
+	static bool32 SysStorageCommit(_SysAllocatorData* sys, uint64 required) {
+		bool32 result = true;
+		if (required > sys->committed) {
+			uint64 commit_end = required + CalculatePadding(required, SYS_STORAGE_COMMIT_GRANULARITY);
+			if (commit_end <= sys->reserved) {
+				result = CommitVirtualMemory((byte*)sys->begin + sys->committed, commit_end - sys->committed);
+				if (result) {
+					sys->committed = commit_end;
+				}
+			} else {
+				result = false;
+			}
 		}
+		return result;
+	}
 
-		if (g_MemoryContext->sys_storage._internal.offset % use_aligment != 0) {
-			padding = CalculatePadding(current_address, use_aligment);
-		}
+	void* SysStorageAlloc(uint64 size, uint64 aligment) {
+		_SysAllocatorData* sys = &g_MemoryContext->sys_storage._internal;
+		uint64 use_aligment = aligment ? aligment : DEFAULT_ALIGMENT;
 
-		AB_CORE_ASSERT(size + padding < g_MemoryContext->sys_storage._internal.free, "Not enough system memory.");
+		uintptr current_address = (uintptr)sys->begin + sys->offset;
+		uint64 padding = CalculatePadding(current_address, use_aligment);
+		uint64 new_offset = sys->offset + padding + size;
 
-		g_MemoryContext->sys_storage._internal.offset += size + padding + 1;
-		g_MemoryContext->sys_storage._internal.free -= size + padding + 1;
+		bool32 committed = SysStorageCommit(sys, new_offset);
+		AB_CORE_ASSERT(committed, "Not enough system memory.");
+
+		sys->offset = new_offset;
+		sys->padding += padding;
 		uintptr next_address = current_address + padding;
 
 		AB_CORE_ASSERT(next_address % use_aligment == 0, "Wrong aligment");
-		//PrintString("Allocation: size: %u64, at address %u64, free: %u64, at: %u64, before: %u64, padding: %u64\n", size, next_address, g_MemoryContext->sys_storage._internal.free, next_address, current_address, next_address - current_address);
 
 		return (void*)next_address;
 	}
 
+	struct _SubsystemFileTag {
+		const char* tag;
+		MemorySubsystem subsystem;
+	};
+
+	// Matched against __FILE__ of the allocation site. Order matters
+	static const _SubsystemFileTag SUBSYSTEM_FILE_TAGS[] = {
+		{ "Renderer2D", MemorySubsystem::Renderer2D },
+		{ "Renderer3D", MemorySubsystem::Renderer },
+		{ "StreamBuffer", MemorySubsystem::Renderer },
+		{ "InputManager", MemorySubsystem::Input },
+		{ "AssetManager", MemorySubsystem::Assets },
+		{ "DebugTools", MemorySubsystem::Debug },
+		{ "Application", MemorySubsystem::Application },
+		{ "Window", MemorySubsystem::Platform },
+		{ "platform", MemorySubsystem::Platform },
+	};
+
+	static MemorySubsystem ClassifyAllocSite(const char* file) {
+		MemorySubsystem result = MemorySubsystem::Unknown;
+		for (uint32 i = 0; i < sizeof(SUBSYSTEM_FILE_TAGS) / sizeof(_SubsystemFileTag); i++) {
+			if (strstr(file, SUBSYSTEM_FILE_TAGS[i].tag)) {
+				result = SUBSYSTEM_FILE_TAGS[i].subsystem;
+				break;
+			}
+		}
+		return result;
+	}
+
 	void* SysStorageAllocDebug(uint64 size, const char* file, const char* func, uint32 line, uint64 aligment) {
-		//AB_CORE_INFO("Allocation in system storage: size: %u64; file: %s; func: %s; line: %u32", size, file, func, line);
-		return SysStorageAlloc(size, aligment);
+		_SysAllocTracker* tracker = &g_MemoryContext->sys_storage._tracker;
+		uint64 padding_before = g_MemoryContext->sys_storage._internal.padding;
+
+		void* result = SysStorageAlloc(size, aligment);
+
+		uint64 padding = g_MemoryContext->sys_storage._internal.padding - padding_before;
+		_SysAllocSite* site = nullptr;
+		// NOTE: __FILE__ and __func__ are string literals so comparing pointers is enough
+		for (uint32 i = 0; i < tracker->sites_count; i++) {
+			if (tracker->sites[i].line == line && tracker->sites[i].file == file) {
+				site = &tracker->sites[i];
+				break;
+			}
+		}
+
+		if (!site && tracker->sites_count < SYS_ALLOC_SITES_CAPACITY) {
+			site = &tracker->sites[tracker->sites_count];
+			tracker->sites_count++;
+			site->file = file;
+			site->func = func;
+			site->line = line;
+			site->subsystem = ClassifyAllocSite(file);
+		}
+
+		if (site) {
+			site->count++;
+			site->bytes += size;
+			site->padding += padding;
+		} else {
+			tracker->dropped_count++;
+			tracker->dropped_bytes += size;
+		}
+
+		return result;
+	}
+
+	const char* MemorySubsystemName(MemorySubsystem subsystem) {
+		switch (subsystem) {
+		case MemorySubsystem::Platform: { return "platform"; } break;
+		case MemorySubsystem::Application: { return "application"; } break;
+		case MemorySubsystem::Renderer: { return "renderer"; } break;
+		case MemorySubsystem::Renderer2D: { return "renderer2d"; } break;
+		case MemorySubsystem::Input: { return "input"; } break;
+		case MemorySubsystem::Assets: { return "assets"; } break;
+		case MemorySubsystem::Debug: { return "debug"; } break;
+		default: { return "unknown"; } break;
+		}
+	}
+
+	SysStorageStats SysStorageGetStats() {
+		_SysAllocatorData* sys = &g_MemoryContext->sys_storage._internal;
+		_SysAllocTracker* tracker = &g_MemoryContext->sys_storage._tracker;
+		SysStorageStats stats = {};
+		stats.used = sys->offset;
+		stats.committed = sys->committed;
+		stats.reserved = sys->reserved;
+		stats.padding = sys->padding;
+		stats.sites = tracker->sites_count;
+
+		uint64 tracked = 0;
+		for (uint32 i = 0; i < tracker->sites_count; i++) {
+			_SysAllocSite* site = &tracker->sites[i];
+			stats.subsystem_bytes[(uint32)site->subsystem] += site->bytes;
+			tracked += site->bytes + site->padding;
+		}
+		stats.subsystem_bytes[(uint32)MemorySubsystem::Unknown] += tracker->dropped_bytes;
+		stats.untracked = sys->offset - tracked - tracker->dropped_bytes;
+		return stats;
+	}
+
+	void SysStorageReport(const char* filename) {
+		// Enough for any line of the report except file and function names
+		static constexpr uint32 LINE_SIZE = 256;
+		_SysAllocTracker* tracker = &g_MemoryContext->sys_storage._tracker;
+		SysStorageStats stats = SysStorageGetStats();
+		FrameStorageStats frame = FrameStorageGetStats();
+
+		FrameScope scope = FrameStorageBeginScope();
+		uint64 buffer_size = LINE_SIZE * (tracker->sites_count + (uint32)MemorySubsystem::_Count + 8);
+		for (uint32 i = 0; i < tracker->sites_count; i++) {
+			buffer_size += strlen(tracker->sites[i].file) + strlen(tracker->sites[i].func);
+		}
+		char* buffer = (char*)FrameAlloc(buffer_size);
+		uint32 at = 0;
+
+		at += FormatString(buffer + at, (uint32)(buffer_size - at), "System storage: used %u64, committed %u64, reserved %u64, padding %u64, untracked %u64\n",
+						   stats.used, stats.committed, stats.reserved, stats.padding, stats.untracked);
+		at += FormatString(buffer + at, (uint32)(buffer_size - at), "Frame storage: high water mark %u64 of %u64\n",
+						   frame.high_water_mark, frame.capacity);
+		at += FormatString(buffer + at, (uint32)(buffer_size - at), "Subsystems:\n");
+		for (uint32 i = 0; i < (uint32)MemorySubsystem::_Count; i++) {
+			at += FormatString(buffer + at, (uint32)(buffer_size - at), "  %-12s %12u64\n", MemorySubsystemName((MemorySubsystem)i), stats.subsystem_bytes[i]);
+		}
+		at += FormatString(buffer + at, (uint32)(buffer_size - at), "Sites (%u32, dropped allocations: %u32):\n", tracker->sites_count, tracker->dropped_count);
+		for (uint32 i = 0; i < tracker->sites_count; i++) {
+			_SysAllocSite* site = &tracker->sites[i];
+			at += FormatString(buffer + at, (uint32)(buffer_size - at), "  %12u64 bytes %6u32 allocs %6u64 padding  %s:%u32 (%s)\n",
+							   site->bytes, site->count, site->padding, site->file, site->line, site->func);
+		}
+
+		if (filename) {
+			if (!DebugWriteFile(filename, buffer, at)) {
+				AB_CORE_ERROR("Failed to write memory report: %s", filename);
+			}
+		} else {
+			ConsolePrint(buffer, at);
+		}
+		FrameStorageEndScope(scope);
 	}
 
 	const PermanentStorage* PermStorage() {
 		return &g_MemoryContext->perm_storage;
 	}
+
+	void* FrameStorageAlloc(uint64 size, uint64 aligment) {
+		_FrameAllocatorData* frame = &g_MemoryContext->frame_storage._internal;
+		uint64 use_aligment = aligment ? aligment : DEFAULT_ALIGMENT;
+
+		uintptr current_address = (uintptr)frame->begin + frame->offset;
+		uint64 padding = CalculatePadding(current_address, use_aligment);
+
+		AB_CORE_ASSERT(frame->offset + padding + size <= frame->size, "Not enough frame memory.");
+
+		uintptr next_address = current_address + padding;
+		frame->offset += padding + size;
+
+		if (frame->offset > frame->frame_peak) {
+			frame->frame_peak = frame->offset;
+		}
+		return (void*)next_address;
+	}
+
+	FrameScope FrameStorageBeginScope() {
+		_FrameAllocatorData* frame = &g_MemoryContext->frame_storage._internal;
+		frame->scope_depth++;
+		return { frame->offset, frame->scope_depth };
+	}
+
+	void FrameStorageEndScope(FrameScope scope) {
+		_FrameAllocatorData* frame = &g_MemoryContext->frame_storage._internal;
+		AB_CORE_ASSERT(scope.depth == frame->scope_depth, "Frame scopes should be closed in reverse order.");
+		AB_CORE_ASSERT(scope.offset <= frame->offset, "Frame scope is already released.");
+		frame->offset = scope.offset;
+		frame->scope_depth--;
+	}
+
+	void FrameStorageReset() {
+		_FrameAllocatorData* frame = &g_MemoryContext->frame_storage._internal;
+		AB_CORE_ASSERT(frame->scope_depth == 0, "Frame storage reset inside of an open scope.");
+		if (frame->frame_peak > frame->high_water_mark) {
+			frame->high_water_mark = frame->frame_peak;
+		}
+		frame->offset = 0;
+		frame->frame_peak = 0;
+	}
+
+	FrameStorageStats FrameStorageGetStats() {
+		_FrameAllocatorData* frame = &g_MemoryContext->frame_storage._internal;
+		FrameStorageStats stats = {};
+		stats.capacity = frame->size;
+		stats.used = frame->offset;
+		stats.frame_peak = frame->frame_peak;
+		stats.high_water_mark = frame->frame_peak > frame->high_water_mark ? frame->frame_peak : frame->high_water_mark;
+		return stats;
+	}
+
+	void PoolInit(PoolAllocator* pool, void* memory, uint64 block_size, uint32 capacity) {
+		AB_CORE_ASSERT(block_size >= sizeof(void*), "Pool block is too small.");
+		AB_CORE_ASSERT(block_size % sizeof(void*) == 0, "Pool block size breaks aligment.");
+		pool->begin = (byte*)memory;
+		pool->block_size = block_size;
+		pool->capacity = capacity;
+		pool->used = 0;
+		pool->peak_used = 0;
+		pool->free_list = nullptr;
+		// Linking in reverse order so blocks are handed out from the beginning
+		for (uint32 i = capacity; i > 0; i--) {
+			void** block = (void**)(pool->begin + (i - 1) * block_size);
+			*block = pool->free_list;
+			pool->free_list = block;
+		}
+	}
+
+	void* PoolAlloc(PoolAllocator* pool) {
+		void* result = nullptr;
+		if (pool->free_list) {
+			result = pool->free_list;
+			pool->free_list = *((void**)result);
+			pool->used++;
+			if (pool->used > pool->peak_used) {
+				pool->peak_used = pool->used;
+			}
+		}
+		return result;
+	}
+
+	void PoolFree(PoolAllocator* pool, void* block) {
+		AB_CORE_ASSERT((byte*)block >= pool->begin && (byte*)block < pool->begin + pool->block_size * pool->capacity, "Block does not belong to the pool.");
+		AB_CORE_ASSERT(pool->used, "Pool is empty.");
+		*((void**)block) = pool->free_list;
+		pool->free_list = block;
+		pool->used--;
+	}
+
+	uint32 PoolGetBlockIndex(const PoolAllocator* pool, const void* block) {
+		uint64 offset = (uint64)((byte*)block - pool->begin);
+		AB_CORE_ASSERT(offset % pool->block_size == 0, "Pointer is not at the beginning of a block.");
+		return (uint32)(offset / pool->block_size);
+	}
+
+	void SizeClassInit(SizeClassAllocator* allocator) {
+		memset(allocator, 0, sizeof(SizeClassAllocator));
+		for (uint32 i = 0; i < SIZE_CLASS_COUNT; i++) {
+			allocator->classes[i].block_size = SIZE_CLASS_MIN_BLOCK_SIZE << i;
+		}
+	}
+
+	static int32 SizeClassIndex(uint64 size) {
+		int32 result = -1;
+		for (uint32 i = 0; i < SIZE_CLASS_COUNT; i++) {
+			if (size <= (SIZE_CLASS_MIN_BLOCK_SIZE << i)) {
+				result = i;
+				break;
+			}
+		}
+		return result;
+	}
+
+	static bool32 SizeClassGrow(SizeClassAllocator* allocator, _SizeClass* size_class) {
+		byte* chunk = (byte*)malloc(SIZE_CLASS_CHUNK_SIZE);
+		if (chunk) {
+			uint64 block_count = SIZE_CLASS_CHUNK_SIZE / size_class->block_size;
+			for (uint64 i = block_count; i > 0; i--) {
+				void** block = (void**)(chunk + (i - 1) * size_class->block_size);
+				*block = size_class->free_list;
+				size_class->free_list = block;
+			}
+			size_class->free_blocks += (uint32)block_count;
+			allocator->chunk_bytes += SIZE_CLASS_CHUNK_SIZE;
+			allocator->chunk_count++;
+			return true;
+		}
+		return false;
+	}
+
+	void* SizeClassAlloc(SizeClassAllocator* allocator, uint64 size) {
+		void* result = nullptr;
+		int32 index = SizeClassIndex(size);
+		if (index != -1) {
+			_SizeClass* size_class = &allocator->classes[index];
+			if (size_class->free_list || SizeClassGrow(allocator, size_class)) {
+				result = size_class->free_list;
+				size_class->free_list = *((void**)result);
+				size_class->free_blocks--;
+				size_class->used_blocks++;
+				allocator->requested_bytes += size;
+			} else {
+				AB_CORE_ERROR("Failed to allocate pool chunk. Size: %u64", SIZE_CLASS_CHUNK_SIZE);
+			}
+		} else {
+			result = malloc(size);
+			if (result) {
+				allocator->oversized_count++;
+				allocator->oversized_bytes += size;
+				allocator->requested_bytes += size;
+			}
+		}
+		return result;
+	}
+
+	void SizeClassFree(SizeClassAllocator* allocator, void* ptr, uint64 size) {
+		if (ptr) {
+			int32 index = SizeClassIndex(size);
+			if (index != -1) {
+				_SizeClass* size_class = &allocator->classes[index];
+				AB_CORE_ASSERT(size_class->used_blocks, "Size class is empty.");
+				*((void**)ptr) = size_class->free_list;
+				size_class->free_list = ptr;
+				size_class->used_blocks--;
+				size_class->free_blocks++;
+			} else {
+				free(ptr);
+				allocator->oversized_count--;
+				allocator->oversized_bytes -= size;
+			}
+			allocator->requested_bytes -= size;
+		}
+	}
+
+	SizeClassStats SizeClassGetStats(const SizeClassAllocator* allocator) {
+		SizeClassStats stats = {};
+		uint32 live_blocks = 0;
+		for (uint32 i = 0; i < SIZE_CLASS_COUNT; i++) {
+			const _SizeClass* size_class = &allocator->classes[i];
+			stats.in_use += size_class->block_size * size_class->used_blocks;
+			stats.free += size_class->block_size * size_class->free_blocks;
+			live_blocks += size_class->used_blocks;
+		}
+		stats.in_use += allocator->oversized_bytes;
+		stats.reserved = allocator->chunk_bytes + allocator->oversized_bytes;
+		stats.requested = allocator->requested_bytes;
+		stats.internal_waste = stats.in_use - stats.requested;
+		stats.live_allocations = live_blocks + allocator->oversized_count;
+		stats.oversized = allocator->oversized_count;
+		return stats;
+	}
 }
@@ -4,6 +4,7 @@
 
 #define KILOBYTES(kb) ((kb) * 1024)
 #define MEGABYTES(mb) ((mb) * 1024 * 1024)
+#define GIGABYTES(gb) ((gb) * 1024ull * 1024 * 1024)
 
 #define CopyArray(type, elem_count, dest, src) memcpy(dest, src, sizeof(type) * elem_count)
 #define CopyScalar(type, dest, src) memcpy(dest, src, sizeof(type))
@@ -18,11 +19,22 @@ namespace AB {
 	struct InputMgr;
 	struct Application;
 	struct AssetManager;
+	struct StreamBuffer;
 }
 
 namespace AB {
 
-	constexpr uint64 SYS_STORAGE_TOTAL_SIZE = MEGABYTES(6);
+	// System storage reserves address space up front and commits it on demand
+	constexpr uint64 SYS_STORAGE_RESERVE_SIZE = GIGABYTES(1);
+	constexpr uint64 SYS_STORAGE_COMMIT_GRANULARITY = MEGABYTES(2);
+	constexpr uint64 FRAME_STORAGE_TOTAL_SIZE = MEGABYTES(2);
+
+	constexpr uint32 SYS_ALLOC_SITES_CAPACITY = 256;
+
+	// Size classes are powers of two: 1KB, 2KB ... 2MB
+	constexpr uint32 SIZE_CLASS_COUNT = 12;
+	constexpr uint64 SIZE_CLASS_MIN_BLOCK_SIZE = KILOBYTES(1);
+	constexpr uint64 SIZE_CLASS_CHUNK_SIZE = MEGABYTES(4);
 
 	struct PermanentStorage {
 		Renderer* forward_renderer;
@@ -32,34 +44,178 @@ namespace AB {
 		InputMgr* input_manager;
 		Application* application;
 		AssetManager* asset_manager;
+		StreamBuffer* stream_buffer;
+	};
+
+	enum class MemorySubsystem : uint32 {
+		Unknown = 0,
+		Platform,
+		Application,
+		Renderer,
+		Renderer2D,
+		Input,
+		Assets,
+		Debug,
+		_Count
 	};
 
 	struct _SysAllocatorData {
 		void* begin;
 		uint64 offset;
-		uint64 free;
+		uint64 committed;
+		uint64 reserved;
+		uint64 padding;
+		bool32 huge_pages;
+	};
+
+	// One entry per SysAlloc call site. Filled by SysStorageAllocDebug
+	struct _SysAllocSite {
+		const char* file;
+		const char* func;
+		uint32 line;
+		MemorySubsystem subsystem;
+		uint32 count;
+		uint64 bytes;
+		uint64 padding;
+	};
+
+	struct _SysAllocTracker {
+		uint32 sites_count;
+		// Allocations which didn't fit in the sites table
+		uint32 dropped_count;
+		uint64 dropped_bytes;
+		_SysAllocSite sites[SYS_ALLOC_SITES_CAPACITY];
 	};
 
 	struct SystemStorage {
 		_SysAllocatorData _internal;
-		byte _raw[SYS_STORAGE_TOTAL_SIZE];
+		_SysAllocTracker _tracker;
+	};
+
+	// System storage never frees so used bytes are also the peak usage
+	struct SysStorageStats {
+		uint64 used;
+		uint64 committed;
+		uint64 reserved;
+		uint64 padding;
+		uint64 untracked;
+		uint64 subsystem_bytes[(uint32)MemorySubsystem::_Count];
+		uint32 sites;
+	};
+
+	struct _FrameAllocatorData {
+		void* begin;
+		uint64 offset;
+		uint64 size;
+		uint32 scope_depth;
+		uint64 frame_peak;
+		uint64 high_water_mark;
+	};
+
+	// Linear arena for transient data. Everything allocated here
+	// dies at the end of the frame (or at the end of the enclosing scope)
+	struct FrameStorage {
+		_FrameAllocatorData _internal;
+		byte _raw[FRAME_STORAGE_TOTAL_SIZE];
+	};
+
+	// Fixed-size block pool over caller provided memory.
+	// Free blocks are linked through their first bytes, so allocation
+	// and free are O(1) and the pool needs no extra bookkeeping memory.
+	struct PoolAllocator {
+		byte* begin;
+		uint64 block_size;
+		uint32 capacity;
+		uint32 used;
+		uint32 peak_used;
+		void* free_list;
+	};
+
+	struct _SizeClass {
+		uint64 block_size;
+		void* free_list;
+		uint32 used_blocks;
+		uint32 free_blocks;
+	};
+
+	// Set of block pools, one per size class. Pools grow by SIZE_CLASS_CHUNK_SIZE
+	// chunks which are never returned to the system. Requests bigger than
+	// the largest class go straight to malloc and are counted as oversized.
+	struct SizeClassAllocator {
+		_SizeClass classes[SIZE_CLASS_COUNT];
+		uint64 requested_bytes;
+		uint64 chunk_bytes;
+		uint32 chunk_count;
+		uint32 oversized_count;
+		uint64 oversized_bytes;
+	};
+
+	struct SizeClassStats {
+		uint64 reserved;		// Bytes taken from the system
+		uint64 in_use;			// Bytes of blocks handed out
+		uint64 requested;		// Bytes actually requested by users
+		uint64 internal_waste;	// in_use - requested
+		uint64 free;			// Bytes sitting in free lists
+		uint32 live_allocations;
+		uint32 oversized;
 	};
 
 	struct Memory {
 		PermanentStorage perm_storage;
 		SystemStorage sys_storage;
+		FrameStorage frame_storage;
 	};
 
-	AB_API Memory* CreateMemoryContext();
+	struct FrameScope {
+		uint64 offset;
+		uint32 depth;
+	};
+
+	struct FrameStorageStats {
+		uint64 capacity;
+		uint64 used;
+		uint64 frame_peak;
+		uint64 high_water_mark;
+	};
+
+	// huge_pages is only a hint. Ignored where transparent huge pages are not supported
+	AB_API Memory* CreateMemoryContext(bool32 huge_pages = false);
 	Memory* GetMemory();
 	AB_API void* SysStorageAlloc(uint64 size, uint64 aligment = 0);
 	AB_API void* SysStorageAllocDebug(uint64 size, const char* file, const char* func, uint32 line, uint64 aligment = 0);
 
 	AB_API const PermanentStorage* PermStorage();
 
+	AB_API const char* MemorySubsystemName(MemorySubsystem subsystem);
+	AB_API SysStorageStats SysStorageGetStats();
+	// Writes a memory report to the file. Prints it to the console if filename is nullptr
+	AB_API void SysStorageReport(const char* filename = nullptr);
+
+	AB_API void* FrameStorageAlloc(uint64 size, uint64 aligment = 0);
+	// Scopes are nestable and should be closed in reverse order
+	AB_API FrameScope FrameStorageBeginScope();
+	AB_API void FrameStorageEndScope(FrameScope scope);
+	// Called by AppRun at the end of every frame
+	AB_API void FrameStorageReset();
+	AB_API FrameStorageStats FrameStorageGetStats();
+
 #if defined(AB_CONFIG_DEBUG)
 #define SysAlloc(size) SysStorageAllocDebug(size, __FILE__, __func__, __LINE__)
 #else
 #define SysAlloc(size) SysStorageAlloc(size)
 #endif
+
+#define FrameAlloc(size) FrameStorageAlloc(size)
+
+	AB_API void PoolInit(PoolAllocator* pool, void* memory, uint64 block_size, uint32 capacity);
+	// Returns nullptr if pool is full
+	AB_API void* PoolAlloc(PoolAllocator* pool);
+	AB_API void PoolFree(PoolAllocator* pool, void* block);
+	AB_API uint32 PoolGetBlockIndex(const PoolAllocator* pool, const void* block);
+
+	AB_API void SizeClassInit(SizeClassAllocator* allocator);
+	AB_API void* SizeClassAlloc(SizeClassAllocator* allocator, uint64 size);
+	// Size should be the same as passed to SizeClassAlloc
+	AB_API void SizeClassFree(SizeClassAllocator* allocator, void* ptr, uint64 size);
+	AB_API SizeClassStats SizeClassGetStats(const SizeClassAllocator* allocator);
 }
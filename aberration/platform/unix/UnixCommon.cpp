@@ -4,7 +4,11 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <cstdlib>
 
 namespace AB {
 
@@ -70,6 +74,101 @@ namespace AB {
 		datetime.milliseconds = 0;
 	}
 
+	void* ReserveVirtualMemory(uint64 size) {
+		void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (ptr == MAP_FAILED) {
+			AB_CORE_ERROR("Failed to reserve %u64 bytes of address space.", size);
+			ptr = nullptr;
+		}
+		return ptr;
+	}
+
+	bool32 CommitVirtualMemory(void* address, uint64 size) {
+		bool32 result = mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+		if (!result) {
+			AB_CORE_ERROR("Failed to commit %u64 bytes of memory.", size);
+		}
+		return result;
+	}
+
+	bool32 AdviseHugePages(void* address, uint64 size) {
+#if defined(MADV_HUGEPAGE)
+		return madvise(address, size, MADV_HUGEPAGE) == 0;
+#else
+		return false;
+#endif
+	}
+
+	uint32 GetLogicalProcessorCount() {
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? (uint32)count : 1;
+	}
+
+	struct _UnixThreadStartInfo {
+		ThreadProc* proc;
+		void* data;
+	};
+
+	static void* _UnixThreadStart(void* info_ptr) {
+		_UnixThreadStartInfo info = *(_UnixThreadStartInfo*)info_ptr;
+		std::free(info_ptr);
+		info.proc(info.data);
+		return nullptr;
+	}
+
+	bool32 CreateWorkerThread(ThreadProc* proc, void* data) {
+		bool32 result = false;
+		_UnixThreadStartInfo* info = (_UnixThreadStartInfo*)std::malloc(sizeof(_UnixThreadStartInfo));
+		if (info) {
+			info->proc = proc;
+			info->data = data;
+			pthread_t thread;
+			if (pthread_create(&thread, nullptr, _UnixThreadStart, info) == 0) {
+				pthread_detach(thread);
+				result = true;
+			} else {
+				std::free(info);
+			}
+		}
+		return result;
+	}
+
+	SemaphoreHandle SemaphoreCreate(uint32 initial_count) {
+		sem_t* semaphore = (sem_t*)std::malloc(sizeof(sem_t));
+		if (semaphore) {
+			if (sem_init(semaphore, 0, initial_count) != 0) {
+				std::free(semaphore);
+				semaphore = nullptr;
+			}
+		}
+		return (SemaphoreHandle)semaphore;
+	}
+
+	void SemaphoreWait(SemaphoreHandle semaphore) {
+		// NOTE: Retry if interrupted by a signal
+		while (sem_wait((sem_t*)semaphore) != 0) {}
+	}
+
+	void SemaphoreSignal(SemaphoreHandle semaphore) {
+		sem_post((sem_t*)semaphore);
+	}
+
+	uint32 AtomicCompareExchange32(volatile uint32* dest, uint32 exchange, uint32 comparand) {
+		return __sync_val_compare_and_swap(dest, comparand, exchange);
+	}
+
+	uint32 AtomicExchange32(volatile uint32* dest, uint32 value) {
+		return __atomic_exchange_n(dest, value, __ATOMIC_SEQ_CST);
+	}
+
+	uint32 AtomicIncrement32(volatile uint32* dest) {
+		return __sync_add_and_fetch(dest, 1);
+	}
+
+	uint32 AtomicLoad32(volatile uint32* src) {
+		return __atomic_load_n(src, __ATOMIC_SEQ_CST);
+	}
+
 	AB_API void* DebugReadFile(const char* filename, uint32* bytesRead) {
 		void* ptr = nullptr;
 		*bytesRead = 0;
@@ -106,6 +205,47 @@ namespace AB {
 		return ptr;
 	}
 
+	MappedFile DebugMapFile(const char* filename) {
+		MappedFile result = {};
+		int fileHandle = open(filename, O_RDONLY);
+		if (fileHandle != -1) {
+			struct stat fileStat;
+			if (fstat(fileHandle, &fileStat) == 0 && fileStat.st_size > 0) {
+				void* ptr = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+				if (ptr != MAP_FAILED) {
+					// Whole file is going to be read front to back
+					madvise(ptr, fileStat.st_size, MADV_SEQUENTIAL);
+					madvise(ptr, fileStat.st_size, MADV_WILLNEED);
+					result.data = ptr;
+					result.size = (uint64)fileStat.st_size;
+				}
+				else {
+					AB_CORE_WARN("File mapping error. File: %s. mmap() failed.", filename);
+				}
+			}
+			else {
+				AB_CORE_WARN("File mapping error. File: %s. File is empty.", filename);
+			}
+			// NOTE: Mapping stays valid after closing the descriptor
+			close(fileHandle);
+		}
+		else {
+			AB_CORE_WARN("File mapping error. File: %s. Failed to open file.", filename);
+		}
+		return result;
+	}
+
+	void DebugUnmapFile(MappedFile* file) {
+		if (file->data) {
+			munmap(file->data, file->size);
+		}
+		*file = {};
+	}
+
+	AB_API void* DebugAllocFileMemory(uint64 size) {
+		return std::malloc(size);
+	}
+
 	AB_API void DebugFreeFileMemory(void* memory) {
 		if (memory) {
 			std::free(memory);
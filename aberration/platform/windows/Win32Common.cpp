@@ -78,6 +78,91 @@ namespace AB {
 		datetime.milliseconds = time.wMilliseconds;
 	}
 
+	void* ReserveVirtualMemory(uint64 size) {
+		void* ptr = VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+		if (!ptr) {
+			AB_CORE_ERROR("Failed to reserve %u64 bytes of address space.", size);
+		}
+		return ptr;
+	}
+
+	bool32 CommitVirtualMemory(void* address, uint64 size) {
+		bool32 result = VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+		if (!result) {
+			AB_CORE_ERROR("Failed to commit %u64 bytes of memory.", size);
+		}
+		return result;
+	}
+
+	bool32 AdviseHugePages(void* address, uint64 size) {
+		// NOTE: Large pages on windows have to be allocated with MEM_LARGE_PAGES
+		// up front and require SeLockMemoryPrivilege. Not supported for now.
+		return false;
+	}
+
+	uint32 GetLogicalProcessorCount() {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+	}
+
+	struct _Win32ThreadStartInfo {
+		ThreadProc* proc;
+		void* data;
+	};
+
+	static DWORD WINAPI _Win32ThreadStart(LPVOID info_ptr) {
+		_Win32ThreadStartInfo info = *(_Win32ThreadStartInfo*)info_ptr;
+		std::free(info_ptr);
+		info.proc(info.data);
+		return 0;
+	}
+
+	bool32 CreateWorkerThread(ThreadProc* proc, void* data) {
+		bool32 result = false;
+		_Win32ThreadStartInfo* info = (_Win32ThreadStartInfo*)std::malloc(sizeof(_Win32ThreadStartInfo));
+		if (info) {
+			info->proc = proc;
+			info->data = data;
+			HANDLE thread = CreateThread(0, 0, _Win32ThreadStart, info, 0, 0);
+			if (thread) {
+				CloseHandle(thread);
+				result = true;
+			} else {
+				std::free(info);
+			}
+		}
+		return result;
+	}
+
+	SemaphoreHandle SemaphoreCreate(uint32 initial_count) {
+		return (SemaphoreHandle)CreateSemaphoreEx(0, initial_count, LONG_MAX, 0, 0, SEMAPHORE_ALL_ACCESS);
+	}
+
+	void SemaphoreWait(SemaphoreHandle semaphore) {
+		WaitForSingleObjectEx((HANDLE)semaphore, INFINITE, FALSE);
+	}
+
+	void SemaphoreSignal(SemaphoreHandle semaphore) {
+		ReleaseSemaphore((HANDLE)semaphore, 1, 0);
+	}
+
+	uint32 AtomicCompareExchange32(volatile uint32* dest, uint32 exchange, uint32 comparand) {
+		return (uint32)InterlockedCompareExchange((volatile LONG*)dest, (LONG)exchange, (LONG)comparand);
+	}
+
+	uint32 AtomicExchange32(volatile uint32* dest, uint32 value) {
+		return (uint32)InterlockedExchange((volatile LONG*)dest, (LONG)value);
+	}
+
+	uint32 AtomicIncrement32(volatile uint32* dest) {
+		return (uint32)InterlockedIncrement((volatile LONG*)dest);
+	}
+
+	uint32 AtomicLoad32(volatile uint32* src) {
+		return (uint32)InterlockedCompareExchange((volatile LONG*)src, 0, 0);
+	}
+
 	DebugReadTextFileRet DebugReadTextFile(const char* filename) {
 		uint32 bytesRead = 0;
 		char* string = nullptr;
@@ -177,6 +262,43 @@ namespace AB {
 		return  {bitmap, result_read };
 	}
 
+	MappedFile DebugMapFile(const char* filename) {
+		MappedFile result = {};
+		HANDLE fileHandle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+		if (fileHandle != INVALID_HANDLE_VALUE) {
+			LARGE_INTEGER fileSize = { 0 };
+			if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0) {
+				HANDLE mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mappingHandle) {
+					void* ptr = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+					if (ptr) {
+						result.data = ptr;
+						result.size = (uint64)fileSize.QuadPart;
+					} else {
+						AB_CORE_ERROR("Failed to map view of file: %s", filename);
+					}
+					// NOTE: View stays valid after closing the handles
+					CloseHandle(mappingHandle);
+				} else {
+					AB_CORE_ERROR("Failed to create file mapping: %s", filename);
+				}
+			}
+			CloseHandle(fileHandle);
+		}
+		return result;
+	}
+
+	void DebugUnmapFile(MappedFile* file) {
+		if (file->data) {
+			UnmapViewOfFile(file->data);
+		}
+		*file = {};
+	}
+
+	void* DebugAllocFileMemory(uint64 size) {
+		return std::malloc(size);
+	}
+
 	void DebugFreeFileMemory(void* memory) {
 		if (memory) {
 			std::free(memory);
@@ -1,2 +1,3 @@
+#include "StreamBuffer.cpp"
 #include "Renderer3D.cpp"
 #include "Renderer2D.cpp"
@@ -8,6 +8,8 @@
 #include "utils/DebugTools.h"
 #include "platform/Memory.h"
 #include "platform/InputManager.h"
+#include "Compression.h"
+#include "StreamBuffer.h"
 
 namespace AB {
 	const char* SPRITE_VERTEX_SOURCE = R"(
@@ -150,7 +152,6 @@ namespace AB {
 		uint32 drawCallCount;
 		uint32 verticesDrawnCount;
 		// TEMRORARY
-		uint32 GLVBOHandle;
 		uint32 GLIBOHandle;
 		uint32 shaderHandle;
 		GLuint subroutineGlyphIndex;
@@ -167,9 +168,8 @@ namespace AB {
 		uint16 drawQueueUsed;
 		uint32 sortBufferUsage;
 		BatchData batches[RENDERER2D_DRAW_QUEUE_CAPACITY];
-		// TODO: Maybe write vertex data directly to the gpu address space using glMapBuffer
-		// instead of having this vertex buffer
-		VertexData vertexBuffer[RENDERER2D_DRAW_QUEUE_CAPACITY * 4];
+		// NOTE: Points to stream buffer memory while flushing. Write only
+		VertexData* vertexBuffer;
 		RectangleData drawQueue[RENDERER2D_DRAW_QUEUE_CAPACITY];
 		SortEntry sortBufferA[RENDERER2D_DRAW_QUEUE_CAPACITY];
 		SortEntry sortBufferB[RENDERER2D_DRAW_QUEUE_CAPACITY];
@@ -514,7 +514,6 @@ namespace AB {
 	void Renderer2DDestroy() {
 		auto renderer = PermStorage()->renderer2d;
 
-		GLCall(glDeleteBuffers(1, &renderer->GLVBOHandle));
 		GLCall(glDeleteBuffers(1, &renderer->GLIBOHandle));
 		GLCall(glDeleteProgram(renderer->shaderHandle));
 		renderer = nullptr;
@@ -716,13 +715,23 @@ namespace AB {
 		properties->indexCount = 0;
 		properties->sortBufferUsage = 0;
 		properties->drawQueueUsed = 0;
+		properties->vertexBuffer = nullptr;
 	}
 
 	void Renderer2DFlush() {
 		auto renderer = PermStorage()->renderer2d;
+		StreamBuffer* stream = PermStorage()->stream_buffer;
+
+		StreamAllocation vertices = StreamBufferAlloc(stream, (uint32)(sizeof(VertexData) * 4 * renderer->sortBufferUsage), sizeof(float32) * 4);
+		if (!vertices.ptr) {
+			ResetRenderState(renderer);
+			return;
+		}
+		renderer->vertexBuffer = (VertexData*)vertices.ptr;
 
 		SortEntry* sortedBuffer = SortQueue(renderer);
 		GenVertexAndBatchBuffers(renderer, sortedBuffer);
+		StreamBufferFlush(stream);
 		GLCall(glDisable(GL_DEPTH_TEST));
 		// TODO: Temporary disabling face culling here.
 		// Because font using wrong CW vertex order
@@ -730,16 +739,16 @@ namespace AB {
 		GLCall(glClearColor(0.2f, 0.3f, 0.3f, 1.0f));
 		// TODO: Requires GL_LESS Depth test with clear to 0.0 and range 0.0 - 1.0
 		//GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-		GLCall(glBindBuffer(GL_ARRAY_BUFFER, renderer->GLVBOHandle));
-		GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(VertexData) * renderer->vertexCount, (void*)renderer->vertexBuffer, GL_DYNAMIC_DRAW));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, vertices.api_handle));
 		GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer->GLIBOHandle));
 
+		uintptr base = vertices.offset;
 		GLCall(glEnableVertexAttribArray(0));
-		GLCall(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), 0));
+		GLCall(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)base));
 		GLCall(glEnableVertexAttribArray(1));
-		GLCall(glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexData), (void*)(sizeof(float32) * 2)));
+		GLCall(glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexData), (void*)(base + sizeof(float32) * 2)));
 		GLCall(glEnableVertexAttribArray(2));
-		GLCall(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(float32) * 2 + sizeof(byte) * 4)));
+		GLCall(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(base + sizeof(float32) * 2 + sizeof(byte) * 4)));
 
 		// Always using 0 slot
 		GLCall(glUseProgram(renderer->shaderHandle));
@@ -810,6 +819,20 @@ namespace AB {
 			uint32 bytes = 0;
 			// TODO: read only header at the beginning
 			byte* fileData = (byte*)AB::DebugReadFile(filepath, &bytes);
+			if (fileData && ABZIsCompressed(fileData, bytes)) {
+				uint64 uncompressedSize = ABZUncompressedSize(fileData);
+				byte* uncompressed = uncompressedSize <= 0xffffffff ? (byte*)DebugAllocFileMemory(uncompressedSize) : nullptr;
+				if (uncompressed && ABZDecompress(fileData, bytes, uncompressed, uncompressedSize)) {
+					bytes = (uint32)uncompressedSize;
+				} else {
+					AB_CORE_ERROR("Failed to decompress font file: %s", filepath);
+					DebugFreeFileMemory(uncompressed);
+					uncompressed = nullptr;
+					bytes = 0;
+				}
+				DebugFreeFileMemory(fileData);
+				fileData = uncompressed;
+			}
 			if (fileData && bytes) {
 				ABFontBitmapHeader* header = (ABFontBitmapHeader*)fileData;
 
@@ -1134,8 +1157,6 @@ namespace AB {
 		WindowGetSize(&winWidth, &winHeight);
 		GLCall(glViewport(0, 0, winWidth, winHeight));
 
-		GLCall(glGenBuffers(1, &properties->GLVBOHandle));
-
 		uint16* indices = (uint16*)std::malloc(RENDERER2D_INDEX_BUFFER_SIZE * sizeof(uint16));
 		uint16 k = 0;
 		// TODO: IMPORTATNT: This alorithm might work incorrect on different sizes of index buffer
@@ -1168,12 +1189,13 @@ namespace AB {
 		GLCall(glShaderSource(spritefragmentShader, 1, &SPRITE_FRAGMENT_SOURCE, 0));
 		GLCall(glCompileShader(spritefragmentShader));
 
+		FrameScope scope = FrameStorageBeginScope();
 		int32 result = 0;
 		GLCall(glGetShaderiv(spriteVertexShader, GL_COMPILE_STATUS, &result));
 		if (!result) {
 			int32 logLen;
 			GLCall(glGetShaderiv(spriteVertexShader, GL_INFO_LOG_LENGTH, &logLen));
-			char* message = (char*)alloca(logLen);
+			char* message = (char*)FrameAlloc(logLen);
 			GLCall(glGetShaderInfoLog(spriteVertexShader, logLen, NULL, message));
 			AB_CORE_FATAL("Shader compilation error:\n%s", message);
 		};
@@ -1182,7 +1204,7 @@ namespace AB {
 		if (!result) {
 			int32 logLen;
 			GLCall(glGetShaderiv(spritefragmentShader, GL_INFO_LOG_LENGTH, &logLen));
-			char* message = (char*)alloca(logLen);
+			char* message = (char*)FrameAlloc(logLen);
 			GLCall(glGetShaderInfoLog(spritefragmentShader, logLen, NULL, message));
 			AB_CORE_FATAL("Shader compilation error:\n%s", message);
 		};
@@ -1195,10 +1217,11 @@ namespace AB {
 		if (!result) {
 			int32 logLen;
 			GLCall(glGetProgramiv(properties->shaderHandle, GL_INFO_LOG_LENGTH, &logLen));
-			char* message = (char*)alloca(logLen);
+			char* message = (char*)FrameAlloc(logLen);
 			GLCall(glGetProgramInfoLog(properties->shaderHandle, logLen, 0, message));
 			AB_CORE_FATAL("Shader compilation error:\n%s", message);
 		}
+		FrameStorageEndScope(scope);
 
 		GLCall(glDeleteShader(spriteVertexShader));
 		GLCall(glDeleteShader(spritefragmentShader));
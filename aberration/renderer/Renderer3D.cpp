@@ -3,7 +3,18 @@
 #include "platform/Common.h"
 #include "utils/ImageLoader.h"
 #include "platform/Memory.h"
+#include "platform/Window.h"
 #include "AssetManager.h"
+#include "StreamBuffer.h"
+#include "utils/CPUFeatures.h"
+#include <immintrin.h>
+
+// NOTE: Wide cull kernels are compiled with target attributes and picked at runtime
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AB_CULL_TARGET(name)
+#else
+#define AB_CULL_TARGET(name) __attribute__((target(name)))
+#endif
 
 namespace AB {
 
@@ -28,6 +39,8 @@ out_FragColor = texture(skybox, skyboxUV);
 
 	
 	struct DrawCommand {
+		// NOTE: Filled in RendererRender, because mesh and textures may still be streaming when command is submitted
+		uint64 sort_key;
 		int32 mesh_handle;
 		int32 material_handle;
 		hpm::Matrix4 transform;
@@ -56,6 +69,70 @@ out_FragColor = texture(skybox, skyboxUV);
 	};
 //#pragma pack(pop)
 
+	// NOTE: Shininess and map flags fill std140 padding after vectors
+	struct _MaterialStd140 {
+		Vector3 ambient;
+		float32 shininess;
+		Vector3 diffuse;
+		int32 use_diff_map;
+		Vector3 specular;
+		int32 use_spec_map;
+	};
+	static_assert(sizeof(_MaterialStd140) == 48, "Material should match std140 layout of materialData block");
+
+	// NOTE: Uniforms set by renderer. Locations are looked up once when program is created,
+	// -1 if program doesn't use the uniform
+	enum ShaderUniform : uint32 {
+		SHADER_UNIFORM_OCT_NORMALS = 0,
+		SHADER_UNIFORM_DIFFUSE_MAP,
+		SHADER_UNIFORM_SPEC_MAP,
+		SHADER_UNIFORM_SKYBOX,
+		SHADER_UNIFORM_DIR_LIGHT_DIRECTION,
+		SHADER_UNIFORM_DIR_LIGHT_AMBIENT,
+		SHADER_UNIFORM_DIR_LIGHT_DIFFUSE,
+		SHADER_UNIFORM_DIR_LIGHT_SPECULAR,
+		SHADER_UNIFORM_COUNT
+	};
+
+	static const char* SHADER_UNIFORM_NAMES[SHADER_UNIFORM_COUNT] = {
+		"sys_OctNormals",
+		"diffuse_map",
+		"spec_map",
+		"skybox",
+		"dir_light.direction",
+		"dir_light.ambient",
+		"dir_light.diffuse",
+		"dir_light.specular"
+	};
+
+	// NOTE: Samplers are assigned to fixed texture units when program is created
+	static const uint32 SHADER_SAMPLER_UNITS[][2] = {
+		{ SHADER_UNIFORM_DIFFUSE_MAP, 0 },
+		{ SHADER_UNIFORM_SPEC_MAP, 1 },
+		{ SHADER_UNIFORM_SKYBOX, 0 }
+	};
+
+	// NOTE: Enum value is a binding point of the block in every program
+	enum ShaderBlock : uint32 {
+		SHADER_BLOCK_VERTEX_SYSTEM = 0,
+		SHADER_BLOCK_FRAGMENT_SYSTEM,
+		SHADER_BLOCK_POINT_LIGHTS,
+		SHADER_BLOCK_MATERIAL,
+		SHADER_BLOCK_COUNT
+	};
+
+	static const char* SHADER_BLOCK_NAMES[SHADER_BLOCK_COUNT] = {
+		"_vertexSystemUniformBlock",
+		"_fragmentSystemUniformBlock",
+		"pointLightsData",
+		"materialData"
+	};
+
+	struct ShaderProgram {
+		uint32 handle;
+		int32 uniforms[SHADER_UNIFORM_COUNT];
+	};
+
 	static constexpr int32 DRAW_BUFFER_SIZE = 256;
 	static constexpr uint32 SYSTEM_UBO_SIZE = sizeof(Matrix4) * 4 + sizeof(Vector4);
 	static constexpr uint32 SYSTEM_UBO_VERTEX_OFFSET = 0;
@@ -63,31 +140,98 @@ out_FragColor = texture(skybox, skyboxUV);
 	static constexpr uint32 SYSTEM_UBO_VERTEX_VIEWPROJ_OFFSET = 0;
 	static constexpr uint32 SYSTEM_UBO_VERTEX_VIEW_OFFSET = sizeof(Matrix4) * 1;
 	static constexpr uint32 SYSTEM_UBO_VERTEX_PROJ_OFFSET = sizeof(Matrix4) * 2;
-	static constexpr uint32 SYSTEM_UBO_VERTEX_NORMAL_OFFSET = sizeof(Matrix4) * 3;
+	// NOTE: Matrix at sizeof(Matrix4) * 3 is unused. It keeps fragment part at 256 bytes which is a valid offset
+	// for any GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
 	static constexpr uint32 SYSTEM_UBO_FRAGMENT_OFFSET = sizeof(Matrix4) * 4;
 	static constexpr uint32 SYSTEM_UBO_FRAGMENT_SIZE= sizeof(Vector4);
 
+	// Lod is switched when its projected error gets below this number of pixels
+	static constexpr float32 RENDERER_DEFAULT_LOD_ERROR_PIXELS = 1.0f;
+	// Meshes closer than that always use lod 0
+	static constexpr float32 RENDERER_LOD_MIN_DISTANCE = 0.1f;
+
+	// NOTE: Draw sort key layout from the most significant bits:
+	// program | diffuse map | specular map | mesh | lod | depth bucket.
+	// Commands with equal bits above depth are drawn as one instanced batch.
+	// Material is owned by the mesh, so its uniforms change together with mesh bits.
+	// Texture fields store handle + 1, zero means that map is absent or not resident yet.
+	// Depth is view depth quantized to RENDERER_SORT_DEPTH_RANGE, so equal states are drawn front to back
+	static constexpr uint32 DRAW_KEY_PROGRAM_SHIFT = 60;
+	static constexpr uint32 DRAW_KEY_DIFF_MAP_SHIFT = 52;
+	static constexpr uint32 DRAW_KEY_SPEC_MAP_SHIFT = 44;
+	static constexpr uint32 DRAW_KEY_MESH_SHIFT = 36;
+	static constexpr uint32 DRAW_KEY_LOD_SHIFT = 32;
+	static constexpr uint32 DRAW_KEY_DEPTH_SHIFT = 16;
+	static constexpr uint64 DRAW_KEY_DEPTH_MAX = 0xffff;
+	// NOTE: Matches far plane of the projection
+	static constexpr float32 RENDERER_SORT_DEPTH_RANGE = 100.0f;
+	// NOTE: Only mesh program is drawn from the queue for now
+	static constexpr uint64 DRAW_PROGRAM_MESH = 0;
+	static_assert(TEXTURE_STORAGE_CAPACITY < 0xff && MESH_STORAGE_CAPACITY < 0xff, "Handles don't fit into draw sort key");
+	static_assert(AAB_MAX_LODS <= 0x10, "Lod index doesn't fit into draw sort key");
+
+	// NOTE: Per instance vertex attributes. Model matrix takes 4 locations, normal matrix 3
+	static constexpr uint32 INSTANCE_ATTRIB_MODEL_LOCATION = 3;
+	static constexpr uint32 INSTANCE_ATTRIB_NORMAL_LOCATION = 7;
+	static constexpr uint32 INSTANCE_ATTRIB_END_LOCATION = 10;
+
+	struct _InstanceData {
+		Matrix4 model;
+		// NOTE: Columns of inverse transpose of upper 3x3 part of the transform
+		Vector3 normal[3];
+	};
+
+	// NOTE: World space bounds of queued commands in SoA layout, so frustum test runs on 4 or 8 commands at once.
+	// Arrays are padded to CULL_BATCH_SIZE with zeros. Center is the center of the AABB, radius is the radius
+	// of a sphere around that center which contains the bounding sphere of the mesh.
+	// Test uses the smaller of sphere radius and AABB projected on plane normal
+	static constexpr uint32 CULL_BATCH_SIZE = 8;
+
+	struct _CullBounds {
+		float32* center_x;
+		float32* center_y;
+		float32* center_z;
+		float32* extent_x;
+		float32* extent_y;
+		float32* extent_z;
+		float32* radius;
+	};
+
+	enum class CullKernel : uint32 {
+		Scalar = 0,
+		SSE,
+		AVX
+	};
+
 	static constexpr uint32 POINT_LIGHTS_NUMBER = 2;
 	static constexpr uint32 POINT_LIGHT_STRUCT_SIZE = sizeof(Vector4) * 4 + sizeof(float32) * 2;
 	static constexpr uint32 POINT_LIGHT_STRUCT_ALIGMENT = sizeof(Vector4);
 	static constexpr uint32 POINT_LIGHT_UBO_SIZE = POINT_LIGHTS_NUMBER * (POINT_LIGHT_STRUCT_SIZE + sizeof(float32) * 2); 
 
 	struct Renderer {
-		uint32 vertexSystemUBHandle;
-		uint32 pointLightUBHandle;
+		// NOTE: System and point light blocks, materials of meshes drawn in the frame and
+		// _InstanceData of all commands in sorted order are suballocated from the stream buffer every frame
+		uint32 uniform_alignment;
+		// NOTE: Entries of material block are material_stride apart
+		uint32 material_stride;
 		int32 skyboxHandle;
-		int32 skyboxProgramHandle;
+		ShaderProgram skybox_program;
 		uint32 skyboxVB;
-		int32 program_handle;
+		ShaderProgram mesh_program;
 		uint32 draw_buffer_at;
 		DrawCommand draw_buffer[DRAW_BUFFER_SIZE];
+		RendererStats stats;
 		Camera camera;
 		hpm::Matrix4 projection;
+		float32 lod_error_threshold;
+		bool32 meshlet_frustum_culling;
+		bool32 meshlet_backface_culling;
+		CullKernel cull_kernel;
 		DirectionalLight dir_light;
 		PointLight pointLights[POINT_LIGHTS_NUMBER];
 	};
 
-	static uint32 RendererCreateProgram(const char* vertexSource, const char* fragmentSource) 
+	static ShaderProgram RendererCreateProgram(const char* vertexSource, const char* fragmentSource) 
 	{
 
 		const char* commonShaderHeader = R"(
@@ -105,14 +249,28 @@ out_FragColor = texture(skybox, skyboxUV);
 layout (location = 0) in Vector3 v_Position;
 layout (location = 1) in Vector2 v_UV;
 layout (location = 2) in Vector3 v_Normal;
+// NOTE: Per instance attributes. See _InstanceData
+layout (location = 3) in Matrix4 sys_ModelMatrix;
+layout (location = 7) in Matrix3 sys_NormalMatrix;
 
 layout (std140) uniform _vertexSystemUniformBlock {
 Matrix4 sys_ViewProjMatrix;
 Matrix4 sys_ViewMatrix;
 Matrix4 sys_ProjectionMatrix;
-Matrix4 sys_NormalMatrix;
+Matrix4 _sys_Reserved;
 };
-uniform Matrix4 sys_ModelMatrix;
+uniform int sys_OctNormals;
+
+Vector3 sys_DecodeNormal(Vector3 n) {
+	if (sys_OctNormals != 0) {
+		Vector3 v = Vector3(n.xy, 1.0f - abs(n.x) - abs(n.y));
+		float32 t = max(-v.z, 0.0f);
+		v.x += v.x >= 0.0f ? -t : t;
+		v.y += v.y >= 0.0f ? -t : t;
+		return normalize(v);
+	}
+	return n;
+}
 )";
 
 		const char* fragmentShaderHeader = R"(
@@ -127,14 +285,15 @@ Vector3 sys_ViewPos;};
 		uint64 fragmentSourceLength = strlen(fragmentSource);
 		uint64 vertexSourceLength = strlen(vertexSource);
 
-		// TODO: allocation
-		char* fullVertexSource = (char*)malloc(commonHeaderLength + vertexHeaderLength + vertexSourceLength + 1);
+		FrameScope scope = FrameStorageBeginScope();
+
+		char* fullVertexSource = (char*)FrameAlloc(commonHeaderLength + vertexHeaderLength + vertexSourceLength + 1);
 		AB_CORE_ASSERT(fullVertexSource);
 		CopyArray(char, commonHeaderLength, fullVertexSource, commonShaderHeader);
 		CopyArray(char, vertexHeaderLength, fullVertexSource + commonHeaderLength, vertexShaderHeader);
 		CopyArray(char, vertexSourceLength + 1, fullVertexSource + commonHeaderLength + vertexHeaderLength, vertexSource);
 
-		char* fullFragmentSource = (char*)malloc(commonHeaderLength + fragmentHeaderLength + fragmentSourceLength + 1);
+		char* fullFragmentSource = (char*)FrameAlloc(commonHeaderLength + fragmentHeaderLength + fragmentSourceLength + 1);
 		AB_CORE_ASSERT(fullFragmentSource);
 		CopyArray(char, commonHeaderLength, fullFragmentSource, commonShaderHeader);
 		CopyArray(char, fragmentHeaderLength, fullFragmentSource + commonHeaderLength, fragmentShaderHeader);
@@ -183,12 +342,9 @@ Vector3 sys_ViewPos;};
 							{
 								int32 logLength;
 								GLCall(glGetProgramiv(programHandle, GL_INFO_LOG_LENGTH, &logLength));
-								// TODO: Allocator
-								char* message = (char*)malloc(logLength);
-								AB_CORE_ASSERT(message);
+								char* message = (char*)FrameAlloc(logLength);
 								GLCall(glGetProgramInfoLog(programHandle, logLength, 0, message));
 								AB_CORE_ERROR("Shader program linking error:\n%s", message);
-								free(message);
 							}
 						} 
 						else 
@@ -200,12 +356,9 @@ Vector3 sys_ViewPos;};
 					{
 						GLint logLength;
 						GLCall(glGetShaderiv(fragmentHandle, GL_INFO_LOG_LENGTH, &logLength));
-						// TODO: Allocators
-						GLchar* message = (GLchar*)malloc(logLength);
-						AB_CORE_ASSERT(message);
+						GLchar* message = (GLchar*)FrameAlloc(logLength);
 						GLCall(glGetShaderInfoLog(fragmentHandle, logLength, nullptr, message));
 						AB_CORE_ERROR("Frgament shader compilation error:\n%s", message);
-						free(message);
 					}
 				}
 				else 
@@ -217,12 +370,9 @@ Vector3 sys_ViewPos;};
 			{
 				GLint logLength;
 				GLCall(glGetShaderiv(vertexHandle, GL_INFO_LOG_LENGTH, &logLength));
-				// TODO: Allocators
-				GLchar* message = (GLchar*)malloc(logLength);
-				AB_CORE_ASSERT(message);
+				GLchar* message = (GLchar*)FrameAlloc(logLength);
 				GLCall(glGetShaderInfoLog(vertexHandle, logLength, nullptr, message));
 				AB_CORE_ERROR("Vertex shader compilation error:\n%s", message);
-				free(message);
 			}
 		}
 		else 
@@ -230,28 +380,43 @@ Vector3 sys_ViewPos;};
 			AB_CORE_ERROR("Falled to create vertex shader");
 		}
 
-		free(fullVertexSource);
-		free(fullFragmentSource);
+		FrameStorageEndScope(scope);
 
-		return resultHandle;
+		ShaderProgram program = {};
+		program.handle = resultHandle;
+		if (resultHandle) {
+			for (uint32 i = 0; i < SHADER_UNIFORM_COUNT; i++) {
+				GLCall(program.uniforms[i] = glGetUniformLocation(resultHandle, SHADER_UNIFORM_NAMES[i]));
+			}
+			for (uint32 i = 0; i < SHADER_BLOCK_COUNT; i++) {
+				uint32 blockIndex;
+				GLCall(blockIndex = glGetUniformBlockIndex(resultHandle, SHADER_BLOCK_NAMES[i]));
+				if (blockIndex != GL_INVALID_INDEX) {
+					GLCall(glUniformBlockBinding(resultHandle, blockIndex, i));
+				}
+			}
+			GLCall(glUseProgram(resultHandle));
+			for (uint32 i = 0; i < sizeof(SHADER_SAMPLER_UNITS) / sizeof(SHADER_SAMPLER_UNITS[0]); i++) {
+				int32 location = program.uniforms[SHADER_SAMPLER_UNITS[i][0]];
+				if (location != -1) {
+					GLCall(glUniform1i(location, SHADER_SAMPLER_UNITS[i][1]));
+				}
+			}
+			GLCall(glUseProgram(0));
+		}
+		return program;
 	}
 
 	
-	static void BindSystemUniformBuffer(Renderer* renderer, int32 programHandle) {
-		uint32 sysUBOVertexIndex;
-		GLCall(sysUBOVertexIndex = glGetUniformBlockIndex(programHandle,
-														  "_vertexSystemUniformBlock"));
-		GLCall(glUniformBlockBinding(programHandle, sysUBOVertexIndex, 0));
-		GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, 0, renderer->vertexSystemUBHandle,
-								 SYSTEM_UBO_VERTEX_OFFSET, SYSTEM_UBO_VERTEX_SIZE));
-
-		uint32 sysUBOFragIndex;
-		GLCall(sysUBOFragIndex = glGetUniformBlockIndex(programHandle,
-														"_fragmentSystemUniformBlock"));
-		GLCall(glUniformBlockBinding(programHandle, sysUBOFragIndex, 1));
-		GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, 1, renderer->vertexSystemUBHandle,
-								 SYSTEM_UBO_FRAGMENT_OFFSET, SYSTEM_UBO_FRAGMENT_SIZE));
-	}  	
+	// NOTE: Blocks are bound to the same points in all programs, so buffers are bound once per frame
+	static void BindUniformBuffers(const StreamAllocation* system, const StreamAllocation* point_lights) {
+		GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, SHADER_BLOCK_VERTEX_SYSTEM, system->api_handle,
+								 system->offset + SYSTEM_UBO_VERTEX_OFFSET, SYSTEM_UBO_VERTEX_SIZE));
+		GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, SHADER_BLOCK_FRAGMENT_SYSTEM, system->api_handle,
+								 system->offset + SYSTEM_UBO_FRAGMENT_OFFSET, SYSTEM_UBO_FRAGMENT_SIZE));
+		GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, SHADER_BLOCK_POINT_LIGHTS, point_lights->api_handle,
+								 point_lights->offset, POINT_LIGHT_UBO_SIZE));
+	}
 
 
 	static uint32 LoadTexture(const char* filepath) {
@@ -304,26 +469,16 @@ Vector3 sys_ViewPos;};
 		auto[vertexSource, vSize] = DebugReadTextFile("../assets/shaders/MeshVertex.glsl");
 		auto[fragmentSource, fSize] = DebugReadTextFile("../assets/shaders/MeshFragment.glsl");
 
-		props->program_handle = RendererCreateProgram(vertexSource, fragmentSource);
-
-		uint32 sysVertexUB;
-		GLCall(glGenBuffers(1, &sysVertexUB));
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, sysVertexUB));
-		GLCall(glBufferData(GL_UNIFORM_BUFFER, SYSTEM_UBO_SIZE, NULL, GL_DYNAMIC_DRAW));
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
-		props->vertexSystemUBHandle = sysVertexUB;
-
-		uint32 pointLightUB;
-		GLCall(glGenBuffers(1, &pointLightUB));
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, pointLightUB));
-		GLCall(glBufferData(GL_UNIFORM_BUFFER, POINT_LIGHT_UBO_SIZE, NULL, GL_DYNAMIC_DRAW));
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
-		props->pointLightUBHandle = pointLightUB;
+		props->mesh_program = RendererCreateProgram(vertexSource, fragmentSource);
+
+		AB_CORE_ASSERT(PermStorage()->stream_buffer, "Stream buffer should be created before renderer");
+		props->uniform_alignment = StreamBufferGetUniformAlignment(PermStorage()->stream_buffer);
+		props->material_stride = (sizeof(_MaterialStd140) + props->uniform_alignment - 1) / props->uniform_alignment * props->uniform_alignment;
 		
 		DebugFreeFileMemory(vertexSource);
 		DebugFreeFileMemory(fragmentSource);
 
-		props->skyboxProgramHandle = RendererCreateProgram(SKYBOX_VERTEX_PROGRAM,
+		props->skybox_program = RendererCreateProgram(SKYBOX_VERTEX_PROGRAM,
 														   SKYBOX_FRAGMENT_PROGRAM);
 		float32 fullscreenQuadVertices[18] = {
 			-1.0f,  -1.0f, 0.0f,
@@ -340,6 +495,11 @@ Vector3 sys_ViewPos;};
 		GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 		
 		props->projection = hpm::PerspectiveRH(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+		props->lod_error_threshold = RENDERER_DEFAULT_LOD_ERROR_PIXELS;
+		props->meshlet_frustum_culling = true;
+		props->meshlet_backface_culling = true;
+		// NOTE: SSE is the x86-64 baseline
+		props->cull_kernel = CPUGetFeatures()->avx ? CullKernel::AVX : CullKernel::SSE;
 		AB::GetMemory()->perm_storage.forward_renderer = props;
 
 		return props;
@@ -357,6 +517,15 @@ Vector3 sys_ViewPos;};
 		CopyArray(PointLight, 1, renderer->pointLights + index, light);
 	}
 
+	void RendererSetLODErrorThreshold(Renderer* renderer, float32 pixels) {
+		renderer->lod_error_threshold = pixels;
+	}
+
+	void RendererSetMeshletCulling(Renderer* renderer, bool32 frustum, bool32 backface) {
+		renderer->meshlet_frustum_culling = frustum;
+		renderer->meshlet_backface_culling = backface;
+	}
+
 	void RendererSetCamera(Renderer* renderer, hpm::Vector3 front, hpm::Vector3 position) {
 		renderer->camera.front = hpm::Normalize(front);
 		renderer->camera.position = position;
@@ -373,17 +542,299 @@ Vector3 sys_ViewPos;};
 		}
 	}
 
+	// NOTE: Picks the coarsest lod which projected error is below threshold.
+	// Error is scaled by the largest axis scale of transform and projected at the distance
+	// to the nearest point of bounding sphere. pixels_per_unit is the size of one unit at distance 1
+	static uint32 SelectMeshLOD(Renderer* renderer, Mesh* mesh, const hpm::Matrix4* transform, float32 pixels_per_unit) {
+		uint32 result = 0;
+		if (mesh->num_lods > 1) {
+			float32 scale = 0.0f;
+			for (uint32 i = 0; i < 3; i++) {
+				hpm::Vector3 axis = { transform->columns[i].x, transform->columns[i].y, transform->columns[i].z };
+				float32 axis_scale = hpm::Length(axis);
+				scale = axis_scale > scale ? axis_scale : scale;
+			}
+			hpm::Vector3 c = mesh->bsphere_center;
+			hpm::Vector3 center = {
+				transform->_11 * c.x + transform->_12 * c.y + transform->_13 * c.z + transform->_14,
+				transform->_21 * c.x + transform->_22 * c.y + transform->_23 * c.z + transform->_24,
+				transform->_31 * c.x + transform->_32 * c.y + transform->_33 * c.z + transform->_34
+			};
+			float32 distance = hpm::Length(hpm::Subtract(center, renderer->camera.position)) - mesh->bsphere_radius * scale;
+			if (distance > RENDERER_LOD_MIN_DISTANCE) {
+				float32 pixels_per_mesh_unit = pixels_per_unit * scale / distance;
+				for (uint32 i = 1; i < mesh->num_lods; i++) {
+					if (mesh->lods[i].error * pixels_per_mesh_unit > renderer->lod_error_threshold) {
+						break;
+					}
+					result = i;
+				}
+			}
+		}
+		return result;
+	}
+
+	// NOTE: Planes are in the space which matrix transforms from. They are normalized,
+	// so plane equation gives distance. Order is left, right, bottom, top, near, far
+	static void ExtractFrustumPlanes(const hpm::Matrix4* m, hpm::Vector4* planes) {
+		for (uint32 i = 0; i < 3; i++) {
+			hpm::Vector4 row = { m->data[i], m->data[4 + i], m->data[8 + i], m->data[12 + i] };
+			hpm::Vector4 w = { m->_41, m->_42, m->_43, m->_44 };
+			planes[i * 2 + 0] = hpm::Add(w, row);
+			planes[i * 2 + 1] = hpm::Subtract(w, row);
+		}
+		for (uint32 i = 0; i < 6; i++) {
+			float32 length = sqrtf(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+			planes[i] = hpm::Multiply(planes[i], length > 0.0f ? 1.0f / length : 0.0f);
+		}
+	}
+
+	// NOTE: Culling is done in mesh space. Frustum planes are extracted from model-view-projection matrix,
+	// camera position is transformed by inverse model matrix. Both tests stay exact under non-uniform scale.
+	// Surviving meshlets which are adjacent in the index buffer are merged into one range.
+	// Returns number of ranges written to counts and offsets
+	static uint32 CullMeshlets(Renderer* renderer, Mesh* mesh, uint32 first, uint32 end, const hpm::Matrix4* mvp, hpm::Vector3 camera, uintptr index_size, GLsizei* counts, const void** offsets) {
+		hpm::Vector4 planes[6];
+		ExtractFrustumPlanes(mvp, planes);
+
+		uint32 ranges = 0;
+		uint32 range_end = 0xffffffff;
+		for (uint32 m = first; m < end; m++) {
+			AABMeshlet* meshlet = mesh->meshlets + m;
+			bool32 visible = true;
+			if (renderer->meshlet_frustum_culling) {
+				for (uint32 i = 0; i < 6 && visible; i++) {
+					float32 distance = planes[i].x * meshlet->center.x + planes[i].y * meshlet->center.y + planes[i].z * meshlet->center.z + planes[i].w;
+					visible = distance >= -meshlet->radius;
+				}
+			}
+			if (visible && renderer->meshlet_backface_culling) {
+				hpm::Vector3 view = hpm::Subtract(meshlet->center, camera);
+				visible = hpm::Dot(view, meshlet->cone_axis) < meshlet->cone_cutoff * hpm::Length(view) + meshlet->radius;
+			}
+			if (visible) {
+				if (meshlet->indices_offset == range_end) {
+					counts[ranges - 1] += meshlet->indices_count;
+				} else {
+					counts[ranges] = (GLsizei)meshlet->indices_count;
+					offsets[ranges] = (void*)(meshlet->indices_offset * index_size);
+					ranges++;
+				}
+				range_end = meshlet->indices_offset + meshlet->indices_count;
+			}
+		}
+		return ranges;
+	}
+
+	// NOTE: World AABB of transformed box has extent |M| * e. Sphere radius is scaled by the largest axis scale
+	// and grown by the distance between sphere center and AABB center
+	static void MakeCullBounds(_CullBounds* bounds, uint32 index, const hpm::Matrix4* t, const Mesh* mesh) {
+		hpm::Vector3 c = hpm::Multiply(hpm::Add(mesh->aabb_min, mesh->aabb_max), 0.5f);
+		hpm::Vector3 e = hpm::Multiply(hpm::Subtract(mesh->aabb_max, mesh->aabb_min), 0.5f);
+		bounds->center_x[index] = t->_11 * c.x + t->_12 * c.y + t->_13 * c.z + t->_14;
+		bounds->center_y[index] = t->_21 * c.x + t->_22 * c.y + t->_23 * c.z + t->_24;
+		bounds->center_z[index] = t->_31 * c.x + t->_32 * c.y + t->_33 * c.z + t->_34;
+		bounds->extent_x[index] = fabsf(t->_11) * e.x + fabsf(t->_12) * e.y + fabsf(t->_13) * e.z;
+		bounds->extent_y[index] = fabsf(t->_21) * e.x + fabsf(t->_22) * e.y + fabsf(t->_23) * e.z;
+		bounds->extent_z[index] = fabsf(t->_31) * e.x + fabsf(t->_32) * e.y + fabsf(t->_33) * e.z;
+
+		float32 scale = 0.0f;
+		for (uint32 i = 0; i < 3; i++) {
+			hpm::Vector3 axis = { t->columns[i].x, t->columns[i].y, t->columns[i].z };
+			float32 axis_scale = hpm::Length(axis);
+			scale = axis_scale > scale ? axis_scale : scale;
+		}
+		hpm::Vector3 offset = hpm::Subtract(mesh->bsphere_center, c);
+		bounds->radius[index] = (mesh->bsphere_radius + hpm::Length(offset)) * scale;
+	}
+
+	// NOTE: Planes are normalized and point inside. visible gets 1 or 0 for every entry including padding
+	static void CullBoundsScalar(const hpm::Vector4* planes, const _CullBounds* bounds, uint32 count, byte* visible) {
+		for (uint32 i = 0; i < count; i++) {
+			bool32 inside = true;
+			for (uint32 p = 0; p < 6; p++) {
+				float32 distance = planes[p].x * bounds->center_x[i] + planes[p].y * bounds->center_y[i] + planes[p].z * bounds->center_z[i] + planes[p].w;
+				float32 box_radius = fabsf(planes[p].x) * bounds->extent_x[i] + fabsf(planes[p].y) * bounds->extent_y[i] + fabsf(planes[p].z) * bounds->extent_z[i];
+				float32 radius = box_radius < bounds->radius[i] ? box_radius : bounds->radius[i];
+				inside = inside && distance + radius >= 0.0f;
+			}
+			visible[i] = inside ? 1 : 0;
+		}
+	}
+
+	static void CullBoundsSSE(const hpm::Vector4* planes, const _CullBounds* bounds, uint32 count, byte* visible) {
+		__m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+		for (uint32 p = 0; p < 6; p++) {
+			nx[p] = _mm_set1_ps(planes[p].x);
+			ny[p] = _mm_set1_ps(planes[p].y);
+			nz[p] = _mm_set1_ps(planes[p].z);
+			nw[p] = _mm_set1_ps(planes[p].w);
+			ax[p] = _mm_and_ps(nx[p], abs_mask);
+			ay[p] = _mm_and_ps(ny[p], abs_mask);
+			az[p] = _mm_and_ps(nz[p], abs_mask);
+		}
+		for (uint32 i = 0; i < count; i += 4) {
+			__m128 cx = _mm_loadu_ps(bounds->center_x + i);
+			__m128 cy = _mm_loadu_ps(bounds->center_y + i);
+			__m128 cz = _mm_loadu_ps(bounds->center_z + i);
+			__m128 ex = _mm_loadu_ps(bounds->extent_x + i);
+			__m128 ey = _mm_loadu_ps(bounds->extent_y + i);
+			__m128 ez = _mm_loadu_ps(bounds->extent_z + i);
+			__m128 sphere = _mm_loadu_ps(bounds->radius + i);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (uint32 p = 0; p < 6; p++) {
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), nw[p]));
+				__m128 box_radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+				__m128 radius = _mm_min_ps(box_radius, sphere);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+			uint32 mask = (uint32)_mm_movemask_ps(inside);
+			for (uint32 k = 0; k < 4; k++) {
+				visible[i + k] = (mask >> k) & 1;
+			}
+		}
+	}
+
+	AB_CULL_TARGET("avx")
+	static void CullBoundsAVX(const hpm::Vector4* planes, const _CullBounds* bounds, uint32 count, byte* visible) {
+		__m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		__m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+		for (uint32 p = 0; p < 6; p++) {
+			nx[p] = _mm256_set1_ps(planes[p].x);
+			ny[p] = _mm256_set1_ps(planes[p].y);
+			nz[p] = _mm256_set1_ps(planes[p].z);
+			nw[p] = _mm256_set1_ps(planes[p].w);
+			ax[p] = _mm256_and_ps(nx[p], abs_mask);
+			ay[p] = _mm256_and_ps(ny[p], abs_mask);
+			az[p] = _mm256_and_ps(nz[p], abs_mask);
+		}
+		for (uint32 i = 0; i < count; i += 8) {
+			__m256 cx = _mm256_loadu_ps(bounds->center_x + i);
+			__m256 cy = _mm256_loadu_ps(bounds->center_y + i);
+			__m256 cz = _mm256_loadu_ps(bounds->center_z + i);
+			__m256 ex = _mm256_loadu_ps(bounds->extent_x + i);
+			__m256 ey = _mm256_loadu_ps(bounds->extent_y + i);
+			__m256 ez = _mm256_loadu_ps(bounds->extent_z + i);
+			__m256 sphere = _mm256_loadu_ps(bounds->radius + i);
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (uint32 p = 0; p < 6; p++) {
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)), _mm256_add_ps(_mm256_mul_ps(nz[p], cz), nw[p]));
+				__m256 box_radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez));
+				__m256 radius = _mm256_min_ps(box_radius, sphere);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			uint32 mask = (uint32)_mm256_movemask_ps(inside);
+			for (uint32 k = 0; k < 8; k++) {
+				visible[i + k] = (mask >> k) & 1;
+			}
+		}
+	}
+
+	// NOTE: Count should be multiple of CULL_BATCH_SIZE
+	static void CullBounds(CullKernel kernel, const hpm::Matrix4* view_proj, const _CullBounds* bounds, uint32 count, byte* visible) {
+		hpm::Vector4 planes[6];
+		ExtractFrustumPlanes(view_proj, planes);
+		switch (kernel) {
+		case CullKernel::AVX: { CullBoundsAVX(planes, bounds, count, visible); } break;
+		case CullKernel::SSE: { CullBoundsSSE(planes, bounds, count, visible); } break;
+		default: { CullBoundsScalar(planes, bounds, count, visible); } break;
+		}
+	}
+
+	static uint64 MakeDrawKey(Renderer* renderer, AssetManager* asset_mgr, const DrawCommand* command, Mesh* mesh, float32 pixels_per_unit) {
+		uint64 diff_map = AssetGetTextureData(asset_mgr, mesh->material->diff_map_handle) ? mesh->material->diff_map_handle + 1 : 0;
+		uint64 spec_map = AssetGetTextureData(asset_mgr, mesh->material->spec_map_handle) ? mesh->material->spec_map_handle + 1 : 0;
+
+		const hpm::Matrix4* t = &command->transform;
+		hpm::Vector3 c = mesh->bsphere_center;
+		hpm::Vector3 center = {
+			t->_11 * c.x + t->_12 * c.y + t->_13 * c.z + t->_14,
+			t->_21 * c.x + t->_22 * c.y + t->_23 * c.z + t->_24,
+			t->_31 * c.x + t->_32 * c.y + t->_33 * c.z + t->_34
+		};
+		float32 depth = hpm::Dot(hpm::Subtract(center, renderer->camera.position), renderer->camera.front);
+		depth = depth < 0.0f ? 0.0f : (depth > RENDERER_SORT_DEPTH_RANGE ? RENDERER_SORT_DEPTH_RANGE : depth);
+		uint64 depth_bucket = (uint64)(depth / RENDERER_SORT_DEPTH_RANGE * (float32)DRAW_KEY_DEPTH_MAX);
+		uint64 lod = SelectMeshLOD(renderer, mesh, &command->transform, pixels_per_unit);
+
+		return DRAW_PROGRAM_MESH << DRAW_KEY_PROGRAM_SHIFT
+			| diff_map << DRAW_KEY_DIFF_MAP_SHIFT
+			| spec_map << DRAW_KEY_SPEC_MAP_SHIFT
+			| (uint64)command->mesh_handle << DRAW_KEY_MESH_SHIFT
+			| lod << DRAW_KEY_LOD_SHIFT
+			| depth_bucket << DRAW_KEY_DEPTH_SHIFT;
+	}
+
+	// NOTE: For affine transform with columns a, b, c inverse transpose of upper 3x3 part
+	// has columns b x c, c x a, a x b divided by determinant.
+	// Instance is in mapped stream buffer memory, so it is written once and never read
+	static void MakeInstanceData(_InstanceData* instance, const hpm::Matrix4* transform, const Mesh* mesh) {
+		_InstanceData result;
+		if (mesh->vertex_format.position_format == AAB_VERTEX_ATTRIB_UNORM16) {
+			// NOTE: Dequantization of positions is folded into model matrix.
+			// Normal matrix is still calculated from the original transform
+			result.model = Translate(*transform, mesh->aabb_min);
+			result.model = Scale(result.model, Subtract(mesh->aabb_max, mesh->aabb_min));
+		} else {
+			result.model = *transform;
+		}
+		hpm::Vector3 a = { transform->_11, transform->_21, transform->_31 };
+		hpm::Vector3 b = { transform->_12, transform->_22, transform->_32 };
+		hpm::Vector3 c = { transform->_13, transform->_23, transform->_33 };
+		hpm::Vector3 bc = hpm::Cross(b, c);
+		float32 det = hpm::Dot(a, bc);
+		float32 inv_det = det != 0.0f ? 1.0f / det : 0.0f;
+		result.normal[0] = hpm::Multiply(bc, inv_det);
+		result.normal[1] = hpm::Multiply(hpm::Cross(c, a), inv_det);
+		result.normal[2] = hpm::Multiply(hpm::Cross(a, b), inv_det);
+		CopyScalar(_InstanceData, instance, &result);
+	}
+
+	// NOTE: LSD radix sort by bytes. Passes where all keys have the same byte are skipped,
+	// so unused low bits of the key cost nothing. Sort is stable, equal keys keep submission order.
+	// Temp arrays should have count elements. Result is written to keys and values
+	static void SortDrawKeys(uint64* keys, uint32* values, uint64* temp_keys, uint32* temp_values, uint32 count) {
+		uint64* src_keys = keys;
+		uint32* src_values = values;
+		uint64* dst_keys = temp_keys;
+		uint32* dst_values = temp_values;
+		for (uint32 shift = 0; shift < 64; shift += 8) {
+			uint32 offsets[256] = {};
+			for (uint32 i = 0; i < count; i++) {
+				offsets[(src_keys[i] >> shift) & 0xff]++;
+			}
+			if (count == 0 || offsets[(src_keys[0] >> shift) & 0xff] == count) {
+				continue;
+			}
+			uint32 sum = 0;
+			for (uint32 i = 0; i < 256; i++) {
+				uint32 bucket_size = offsets[i];
+				offsets[i] = sum;
+				sum += bucket_size;
+			}
+			for (uint32 i = 0; i < count; i++) {
+				uint32 at = offsets[(src_keys[i] >> shift) & 0xff]++;
+				dst_keys[at] = src_keys[i];
+				dst_values[at] = src_values[i];
+			}
+			uint64* k = src_keys; src_keys = dst_keys; dst_keys = k;
+			uint32* v = src_values; src_values = dst_values; dst_values = v;
+		}
+		if (src_keys != keys) {
+			CopyArray(uint64, count, keys, src_keys);
+			CopyArray(uint32, count, values, src_values);
+		}
+	}
+
 	static void DrawSkybox(Renderer* renderer) {
 		if (renderer->skyboxHandle) {
 			GLCall(glEnable(GL_DEPTH_TEST));
 			GLCall(glDepthMask(GL_FALSE));
 			AB_GLCALL(glDepthFunc(GL_LEQUAL));
-			GLCall(glUseProgram(renderer->skyboxProgramHandle));
+			GLCall(glUseProgram(renderer->skybox_program.handle));
 			GLCall(glActiveTexture(GL_TEXTURE0));
 			GLCall(glBindTexture(GL_TEXTURE_CUBE_MAP, renderer->skyboxHandle));
-			GLCall(glUniform1i(glGetUniformLocation(renderer->skyboxProgramHandle,
-													"skybox"), 0));
-			BindSystemUniformBuffer(renderer, renderer->skyboxProgramHandle);
 			GLCall(glBindBuffer(GL_ARRAY_BUFFER, renderer->skyboxVB));
 			GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(hpm::Vector3), (void*)0));
 			GLCall(glEnableVertexAttribArray(0));
@@ -403,134 +854,290 @@ Vector3 sys_ViewPos;};
 		Matrix4 viewProj = Multiply(renderer->projection, renderer->camera.look_at);
 		hpm::Vector3* view_pos = &renderer->camera.position;
 
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, renderer->vertexSystemUBHandle));
-		GLCall(glBufferSubData(GL_UNIFORM_BUFFER, SYSTEM_UBO_VERTEX_VIEWPROJ_OFFSET, sizeof(Matrix4), viewProj.data));
-		GLCall(glBufferSubData(GL_UNIFORM_BUFFER, SYSTEM_UBO_VERTEX_VIEW_OFFSET, sizeof(Matrix4), renderer->camera.look_at.data));
-		GLCall(glBufferSubData(GL_UNIFORM_BUFFER, SYSTEM_UBO_VERTEX_PROJ_OFFSET, sizeof(Matrix4), renderer->projection.data));
-		GLCall(glBufferSubData(GL_UNIFORM_BUFFER, SYSTEM_UBO_FRAGMENT_OFFSET, SYSTEM_UBO_FRAGMENT_SIZE, view_pos->data));
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+		uint32 window_width = 0;
+		uint32 window_height = 0;
+		WindowGetSize(&window_width, &window_height);
+		// NOTE: projection._22 is cot(fov / 2), so this is the screen size of one unit at distance 1
+		float32 pixels_per_unit = renderer->projection._22 * 0.5f * (float32)window_height;
+
+		FrameScope queue_scope = FrameStorageBeginScope();
+		AssetManager* asset_mgr = PermStorage()->asset_manager;
+		uint32 bounds_count = 0;
+		uint32 bounds_capacity = (renderer->draw_buffer_at + CULL_BATCH_SIZE - 1) / CULL_BATCH_SIZE * CULL_BATCH_SIZE;
+		uint32* bounds_command = (uint32*)FrameAlloc(bounds_capacity * sizeof(uint32));
+		_CullBounds bounds;
+		float32** bounds_arrays[] = { &bounds.center_x, &bounds.center_y, &bounds.center_z, &bounds.extent_x, &bounds.extent_y, &bounds.extent_z, &bounds.radius };
+		for (uint32 i = 0; i < sizeof(bounds_arrays) / sizeof(bounds_arrays[0]); i++) {
+			*bounds_arrays[i] = (float32*)FrameAlloc(bounds_capacity * sizeof(float32));
+			SetArray(float32, bounds_capacity, *bounds_arrays[i], 0);
+		}
+		for (uint32 i = 0; i < renderer->draw_buffer_at; i++) {
+			DrawCommand* command = &renderer->draw_buffer[i];
+			Mesh* mesh = AB::AssetGetMeshData(asset_mgr, command->mesh_handle);
+			// NOTE: Mesh is still streaming or failed to load
+			if (mesh) {
+				MakeCullBounds(&bounds, bounds_count, &command->transform, mesh);
+				bounds_command[bounds_count] = i;
+				bounds_count++;
+			}
+		}
+		uint32 padded_count = (bounds_count + CULL_BATCH_SIZE - 1) / CULL_BATCH_SIZE * CULL_BATCH_SIZE;
+		byte* visible = (byte*)FrameAlloc(padded_count);
+		CullBounds(renderer->cull_kernel, &viewProj, &bounds, padded_count, visible);
+
+		uint32 queue_size = 0;
+		uint64* keys = (uint64*)FrameAlloc(renderer->draw_buffer_at * sizeof(uint64) * 2);
+		uint32* order = (uint32*)FrameAlloc(renderer->draw_buffer_at * sizeof(uint32) * 2);
+		for (uint32 i = 0; i < bounds_count; i++) {
+			if (visible[i]) {
+				DrawCommand* command = &renderer->draw_buffer[bounds_command[i]];
+				Mesh* mesh = AB::AssetGetMeshData(asset_mgr, command->mesh_handle);
+				command->sort_key = MakeDrawKey(renderer, asset_mgr, command, mesh, pixels_per_unit);
+				keys[queue_size] = command->sort_key;
+				order[queue_size] = bounds_command[i];
+				queue_size++;
+			}
+		}
+		SortDrawKeys(keys, order, keys + queue_size, order + queue_size, queue_size);
 
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, renderer->pointLightUBHandle));
-		_PointLightStd140* buffer;
-		GLCall(buffer = (_PointLightStd140*)glMapBuffer(GL_UNIFORM_BUFFER, GL_READ_WRITE));
+		// NOTE: Commands of a mesh are adjacent after sorting, so each mesh gets one material entry
+		uint32 material_count = 0;
+		for (uint32 i = 0; i < queue_size; i++) {
+			if (i == 0 || ((keys[i] ^ keys[i - 1]) >> DRAW_KEY_MESH_SHIFT) & 0xff) {
+				material_count++;
+			}
+		}
+
+		// NOTE: All per-frame data is written straight to the stream buffer, which is write only memory.
+		// Structures are built on the stack and copied
+		StreamBuffer* stream = PermStorage()->stream_buffer;
+		StreamAllocation system_block = StreamBufferAlloc(stream, SYSTEM_UBO_SIZE, renderer->uniform_alignment);
+		StreamAllocation point_lights_block = StreamBufferAlloc(stream, POINT_LIGHT_UBO_SIZE, renderer->uniform_alignment);
+		StreamAllocation material_block = StreamBufferAlloc(stream, material_count * renderer->material_stride, renderer->uniform_alignment);
+		StreamAllocation instance_block = StreamBufferAlloc(stream, queue_size * sizeof(_InstanceData), sizeof(Vector4));
+		if (!(system_block.ptr && point_lights_block.ptr && material_block.ptr && instance_block.ptr)) {
+			FrameStorageEndScope(queue_scope);
+			renderer->draw_buffer_at = 0;
+			return;
+		}
+
+		byte* system_data = (byte*)system_block.ptr;
+		CopyScalar(Matrix4, system_data + SYSTEM_UBO_VERTEX_VIEWPROJ_OFFSET, viewProj.data);
+		CopyScalar(Matrix4, system_data + SYSTEM_UBO_VERTEX_VIEW_OFFSET, renderer->camera.look_at.data);
+		CopyScalar(Matrix4, system_data + SYSTEM_UBO_VERTEX_PROJ_OFFSET, renderer->projection.data);
+		Vector4 fragment_system = { view_pos->x, view_pos->y, view_pos->z, 0.0f };
+		CopyScalar(Vector4, system_data + SYSTEM_UBO_FRAGMENT_OFFSET, fragment_system.data);
+
+		_PointLightStd140 point_lights[POINT_LIGHTS_NUMBER] = {};
 		for (uint32 i = 0; i < POINT_LIGHTS_NUMBER; i++)
 		{
-			buffer[i].position = renderer->pointLights[i].position;
-			buffer[i].ambient = renderer->pointLights[i].ambient;
-			buffer[i].diffuse = renderer->pointLights[i].diffuse;
-			buffer[i].specular = renderer->pointLights[i].specular;
-			buffer[i].linear = renderer->pointLights[i].linear;
-			buffer[i].quadratic = renderer->pointLights[i].quadratic;
+			point_lights[i].position = renderer->pointLights[i].position;
+			point_lights[i].ambient = renderer->pointLights[i].ambient;
+			point_lights[i].diffuse = renderer->pointLights[i].diffuse;
+			point_lights[i].specular = renderer->pointLights[i].specular;
+			point_lights[i].linear = renderer->pointLights[i].linear;
+			point_lights[i].quadratic = renderer->pointLights[i].quadratic;
 		}
-		GLCall(glUnmapBuffer(GL_UNIFORM_BUFFER));
-		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+		CopyArray(_PointLightStd140, POINT_LIGHTS_NUMBER, point_lights_block.ptr, point_lights);
+
+		// NOTE: Instance data is written in sorted order, so each batch is a contiguous range
+		byte* materials = (byte*)material_block.ptr;
+		_InstanceData* instances = (_InstanceData*)instance_block.ptr;
+		for (uint32 i = 0; i < queue_size; i++) {
+			DrawCommand* command = &renderer->draw_buffer[order[i]];
+			Mesh* mesh = AB::AssetGetMeshData(asset_mgr, command->mesh_handle);
+			MakeInstanceData(instances + i, &command->transform, mesh);
+			if (i == 0 || ((keys[i] ^ keys[i - 1]) >> DRAW_KEY_MESH_SHIFT) & 0xff) {
+				_MaterialStd140 material;
+				material.ambient = mesh->material->ambient;
+				material.shininess = mesh->material->shininess;
+				material.diffuse = mesh->material->diffuse;
+				material.use_diff_map = ((keys[i] >> DRAW_KEY_DIFF_MAP_SHIFT) & 0xff) != 0;
+				material.specular = mesh->material->specular;
+				material.use_spec_map = ((keys[i] >> DRAW_KEY_SPEC_MAP_SHIFT) & 0xff) != 0;
+				CopyScalar(_MaterialStd140, materials, &material);
+				materials += renderer->material_stride;
+			}
+		}
+		StreamBufferFlush(stream);
 
-		GLCall(glUniformMatrix4fv(glGetUniformLocation(renderer->program_handle, "sys_ViewProjMatrix"), 1, GL_FALSE, viewProj.data));
-		
+		BindUniformBuffers(&system_block, &point_lights_block);
 		DrawSkybox(renderer);
 		
 		GLCall(glEnable(GL_DEPTH_TEST));
 		GLCall(glDepthMask(GL_TRUE));
 		GLCall(glDepthFunc(GL_LESS));
 		
-		GLCall(glUseProgram(renderer->program_handle));
+		ShaderProgram* program = &renderer->mesh_program;
+		GLCall(glUseProgram(program->handle));
 
-		BindSystemUniformBuffer(renderer, renderer->program_handle);
-		
-		uint32 pointLightsUBOIndex;
-		GLCall(pointLightsUBOIndex = glGetUniformBlockIndex(renderer->program_handle, "pointLightsData"));
-		GLCall(glUniformBlockBinding(renderer->program_handle, pointLightsUBOIndex, 2));
-		GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, 2, renderer->pointLightUBHandle));
-
-		//GLCall(glUniformMatrix4fv(glGetUniformLocation(renderer->program_handle, "projection"), 1, GL_FALSE, renderer->projection.data));
-		//GLCall(glUniformMatrix4fv(glGetUniformLocation(renderer->program_handle, "view"), 1, GL_FALSE, renderer->camera.look_at.data));
+		GLCall(glUniform3fv(program->uniforms[SHADER_UNIFORM_DIR_LIGHT_DIRECTION], 1, renderer->dir_light.direction.data));
+		GLCall(glUniform3fv(program->uniforms[SHADER_UNIFORM_DIR_LIGHT_AMBIENT], 1, renderer->dir_light.ambient.data));
+		GLCall(glUniform3fv(program->uniforms[SHADER_UNIFORM_DIR_LIGHT_DIFFUSE], 1, renderer->dir_light.diffuse.data));
+		GLCall(glUniform3fv(program->uniforms[SHADER_UNIFORM_DIR_LIGHT_SPECULAR], 1, renderer->dir_light.specular.data));
 
-		GLCall(glUniform1i(glGetUniformLocation(renderer->program_handle, "material.diffuse_map"), 0));
-		GLCall(glUniform1i(glGetUniformLocation(renderer->program_handle, "material.spec_map"), 1));
+		for (uint32 i = INSTANCE_ATTRIB_MODEL_LOCATION; i < INSTANCE_ATTRIB_END_LOCATION; i++) {
+			GLCall(glEnableVertexAttribArray(i));
+			GLCall(glVertexAttribDivisor(i, 1));
+		}
 
-		GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "dir_light.direction"), 1, renderer->dir_light.direction.data));
-		GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "dir_light.ambient"), 1, renderer->dir_light.ambient.data));
-		GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "dir_light.diffuse"), 1, renderer->dir_light.diffuse.data));
-		GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "dir_light.specular"), 1, renderer->dir_light.specular.data));
+		RendererStats stats = {};
+		stats.commands = renderer->draw_buffer_at;
+		stats.visible = queue_size;
+		stats.culled = bounds_count - queue_size;
+		// NOTE: Fields of the first key are never equal to this
+		uint64 prev_key = ~0ull;
+		Mesh* mesh = nullptr;
+		AABVertexFormat* format = nullptr;
+		uint32 material_index = 0;
+		uint32 batch_end = 0;
+		for (uint32 batch_begin = 0; batch_begin < queue_size; batch_begin = batch_end) {
+			uint64 key = keys[batch_begin];
+			for (batch_end = batch_begin + 1; batch_end < queue_size; batch_end++) {
+				if ((keys[batch_end] ^ key) >> DRAW_KEY_LOD_SHIFT) {
+					break;
+				}
+			}
+			uint32 instance_count = batch_end - batch_begin;
+			DrawCommand* command = &renderer->draw_buffer[order[batch_begin]];
+			uint64 changed = key ^ prev_key;
+			prev_key = key;
+
+			if ((changed >> DRAW_KEY_MESH_SHIFT) & 0xff) {
+				stats.state_changes++;
+				mesh = AB::AssetGetMeshData(asset_mgr, command->mesh_handle);
+				GLCall(glBindBuffer(GL_ARRAY_BUFFER, mesh->api_vb_handle));
+#if 1
+				format = &mesh->vertex_format;
+				if (format->position_format == AAB_VERTEX_ATTRIB_UNORM16) {
+					GLCall(glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(uint16) * 4, 0));
+				} else {
+					GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0));
+				}
+				GLCall(glEnableVertexAttribArray(0));
+				if (mesh->vb_uv_offset) {
+					if (format->uv_format == AAB_VERTEX_ATTRIB_FLOAT16) {
+						GLCall(glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, 0, (void*)mesh->vb_uv_offset));
+					} else {
+						GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)mesh->vb_uv_offset));
+					}
+					GLCall(glEnableVertexAttribArray(1));
+				}
+				bool32 oct_normals = format->normal_format == AAB_VERTEX_ATTRIB_OCT_SNORM16;
+				if (mesh->vb_normal_offset) {
+					if (oct_normals) {
+						GLCall(glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, 0, (void*)mesh->vb_normal_offset));
+					} else {
+						GLCall(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)mesh->vb_normal_offset));
+					}
+					GLCall(glEnableVertexAttribArray(2));
+				}
+				GLCall(glUniform1i(program->uniforms[SHADER_UNIFORM_OCT_NORMALS], oct_normals ? 1 : 0));
 
-			
+				if (mesh->api_ib_handle != 0) {
+					GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->api_ib_handle));
+				}
 
-		for (uint32 i = 0; i < renderer->draw_buffer_at; i++) {
-			DrawCommand* command = &renderer->draw_buffer[i];
-			Mesh* mesh = AB::AssetGetMeshData(PermStorage()->asset_manager, command->mesh_handle);
+#else
 
-			GLCall(glBindBuffer(GL_ARRAY_BUFFER, mesh->api_vb_handle));
-#if 1
-			GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0));
-			GLCall(glEnableVertexAttribArray(0));
-			if (mesh->uvs) {
-				GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)((byte*)(mesh->uvs) - (byte*)(mesh->positions))));
+				GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (sizeof(hpm::Vector3) * 2 + sizeof(hpm::Vector2)), (void*)0));
+				GLCall(glEnableVertexAttribArray(0));
+				GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, (sizeof(hpm::Vector3) * 2 + sizeof(hpm::Vector2)), (void*)(sizeof(hpm::Vector3))));
 				GLCall(glEnableVertexAttribArray(1));
-			}
-			if (mesh->normals) {
-				GLCall(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)((byte*)mesh->normals - (byte*)mesh->positions)));
+				GLCall(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, (sizeof(hpm::Vector3) * 2 + sizeof(hpm::Vector2)), (void*)(sizeof(hpm::Vector2) + sizeof(hpm::Vector3))));
 				GLCall(glEnableVertexAttribArray(2));
-			}
-
-			if (mesh->api_ib_handle != 0) {
 				GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->api_ib_handle));
-			}
-
-#else
-
-			GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (sizeof(hpm::Vector3) * 2 + sizeof(hpm::Vector2)), (void*)0));
-			GLCall(glEnableVertexAttribArray(0));
-			GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, (sizeof(hpm::Vector3) * 2 + sizeof(hpm::Vector2)), (void*)(sizeof(hpm::Vector3))));
-			GLCall(glEnableVertexAttribArray(1));
-			GLCall(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, (sizeof(hpm::Vector3) * 2 + sizeof(hpm::Vector2)), (void*)(sizeof(hpm::Vector2) + sizeof(hpm::Vector3))));
-			GLCall(glEnableVertexAttribArray(2));
-			GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->api_ib_handle));
 
 #endif
-			GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "material.ambinet"), 1,  mesh->material->ambient.data));
-			GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "material.diffuse"), 1, mesh->material->diffuse.data));
-			GLCall(glUniform3fv(glGetUniformLocation(renderer->program_handle, "material.specular"), 1, mesh->material->specular.data));
-			GLCall(glUniform1f(glGetUniformLocation(renderer->program_handle, "material.shininess"), mesh->material->shininess));
-
-			GLCall(glUniformMatrix4fv(glGetUniformLocation(renderer->program_handle, "sys_ModelMatrix"), 1, GL_FALSE, command->transform.data));
+				GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, SHADER_BLOCK_MATERIAL, material_block.api_handle,
+										 material_block.offset + material_index * renderer->material_stride, sizeof(_MaterialStd140)));
+				material_index++;
+			} else {
+				stats.state_changes_avoided++;
+			}
 
+			if ((changed >> DRAW_KEY_DIFF_MAP_SHIFT) & 0xff) {
+				stats.state_changes++;
+				GLCall(glActiveTexture(GL_TEXTURE0));
+				// NOTE: Use flags are in material block, so absent maps are just unbound
+				Texture* diff_texture = AssetGetTextureData(asset_mgr, (int32)((key >> DRAW_KEY_DIFF_MAP_SHIFT) & 0xff) - 1);
+				GLCall(glBindTexture(GL_TEXTURE_2D, diff_texture ? diff_texture->api_handle : 0));
+			} else {
+				stats.state_changes_avoided++;
+			}
 
-			Matrix4 inv = Inverse(command->transform);
-			Matrix4 normalMatrix = Transpose(inv);
-		
-			GLCall(glBindBuffer(GL_UNIFORM_BUFFER, renderer->vertexSystemUBHandle));
-			GLCall(glBufferSubData(GL_UNIFORM_BUFFER, SYSTEM_UBO_VERTEX_NORMAL_OFFSET, sizeof(Matrix4), normalMatrix.data));
-			GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
-			
-			GLCall(glActiveTexture(GL_TEXTURE0));
-			Texture* diff_texture = AssetGetTextureData(PermStorage()->asset_manager, mesh->material->diff_map_handle);
-			if (diff_texture) {
-				GLCall(glUniform1i(glGetUniformLocation(renderer->program_handle, "material.use_diff_map"), 1));
-				GLCall(glBindTexture(GL_TEXTURE_2D, diff_texture->api_handle));
+			if ((changed >> DRAW_KEY_SPEC_MAP_SHIFT) & 0xff) {
+				stats.state_changes++;
+				GLCall(glActiveTexture(GL_TEXTURE1));
+				Texture* spec_texture = AssetGetTextureData(asset_mgr, (int32)((key >> DRAW_KEY_SPEC_MAP_SHIFT) & 0xff) - 1);
+				GLCall(glBindTexture(GL_TEXTURE_2D, spec_texture ? spec_texture->api_handle : 0));
 			} else {
-				GLCall(glUniform1i(glGetUniformLocation(renderer->program_handle, "material.use_diff_map"), 0));
+				stats.state_changes_avoided++;
 			}
-			//GLCall(glBindTexture(GL_TEXTURE_2D, mesh->material->diffuse_map_handle));
-			GLCall(glActiveTexture(GL_TEXTURE1));
-			Texture* spec_texture = AssetGetTextureData(PermStorage()->asset_manager, mesh->material->spec_map_handle);
-			if (spec_texture) {
-				GLCall(glUniform1i(glGetUniformLocation(renderer->program_handle, "material.use_spec_map"), 1));
-				GLCall(glBindTexture(GL_TEXTURE_2D, spec_texture->api_handle));
+
+			// NOTE: There is no base instance in GL 3.3, so instance attributes are pointed to the batch
+			GLCall(glBindBuffer(GL_ARRAY_BUFFER, instance_block.api_handle));
+			uintptr instance_offset = instance_block.offset + batch_begin * sizeof(_InstanceData);
+			for (uint32 c = 0; c < 4; c++) {
+				GLCall(glVertexAttribPointer(INSTANCE_ATTRIB_MODEL_LOCATION + c, 4, GL_FLOAT, GL_FALSE, sizeof(_InstanceData),
+											 (void*)(instance_offset + offsetof(_InstanceData, model) + sizeof(Vector4) * c)));
 			}
-			else {
-				GLCall(glUniform1i(glGetUniformLocation(renderer->program_handle, "material.use_spec_map"), 0));
+			for (uint32 c = 0; c < 3; c++) {
+				GLCall(glVertexAttribPointer(INSTANCE_ATTRIB_NORMAL_LOCATION + c, 3, GL_FLOAT, GL_FALSE, sizeof(_InstanceData),
+											 (void*)(instance_offset + offsetof(_InstanceData, normal) + sizeof(Vector3) * c)));
 			}
-			//GLCall(glBindTexture(GL_TEXTURE_2D, mesh->material->specular_map_handle));
-
 
 			if (mesh->api_ib_handle != 0) {
-				GLCall(glDrawElements(GL_TRIANGLES, (GLsizei)mesh->num_indices, GL_UNSIGNED_INT, 0));
+				uint32 index_type = format->index_format == AAB_INDEX_FORMAT_UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+				uintptr index_size = AABIndexFormatSize(format->index_format);
+				uint32 lod_index = (uint32)((key >> DRAW_KEY_LOD_SHIFT) & 0xf);
+				AABMeshLOD* lod = &mesh->lods[lod_index];
+				uint32 first_meshlet = mesh->lod_first_meshlet[lod_index];
+				uint32 end_meshlet = mesh->lod_first_meshlet[lod_index + 1];
+				// NOTE: Instances share a draw, so clusters are culled only for single instance
+				bool32 cull_meshlets = instance_count == 1 && end_meshlet > first_meshlet && (renderer->meshlet_frustum_culling || renderer->meshlet_backface_culling);
+				if (cull_meshlets) {
+					FrameScope scope = FrameStorageBeginScope();
+					uint32 max_ranges = end_meshlet - first_meshlet;
+					GLsizei* counts = (GLsizei*)FrameAlloc(max_ranges * sizeof(GLsizei));
+					const void** offsets = (const void**)FrameAlloc(max_ranges * sizeof(void*));
+					Matrix4 mvp = Multiply(viewProj, command->transform);
+					Matrix4 inv = Inverse(command->transform);
+					Vector3 camera = {
+						inv._11 * view_pos->x + inv._12 * view_pos->y + inv._13 * view_pos->z + inv._14,
+						inv._21 * view_pos->x + inv._22 * view_pos->y + inv._23 * view_pos->z + inv._24,
+						inv._31 * view_pos->x + inv._32 * view_pos->y + inv._33 * view_pos->z + inv._34
+					};
+					uint32 ranges = CullMeshlets(renderer, mesh, first_meshlet, end_meshlet, &mvp, camera, index_size, counts, offsets);
+					if (ranges) {
+						GLCall(glMultiDrawElements(GL_TRIANGLES, counts, index_type, offsets, (GLsizei)ranges));
+						stats.draw_calls++;
+					}
+					FrameStorageEndScope(scope);
+				} else {
+					GLCall(glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)lod->indices_count, index_type, (void*)(lod->indices_offset * index_size), (GLsizei)instance_count));
+					stats.draw_calls++;
+				}
 			} else {
-				GLCall(glDrawArrays(GL_TRIANGLES, 0, mesh->num_vertices));
+				GLCall(glDrawArraysInstanced(GL_TRIANGLES, 0, mesh->num_vertices, (GLsizei)instance_count));
+				stats.draw_calls++;
 			}
 		}
+		FrameStorageEndScope(queue_scope);
 
+		// NOTE: Vertex array is shared with other renderers
+		for (uint32 i = INSTANCE_ATTRIB_MODEL_LOCATION; i < INSTANCE_ATTRIB_END_LOCATION; i++) {
+			GLCall(glVertexAttribDivisor(i, 0));
+			GLCall(glDisableVertexAttribArray(i));
+		}
+
+		renderer->stats = stats;
+		renderer->draw_buffer_at = 0;
 
 		GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 	}
+
+	RendererStats RendererGetStats(Renderer* renderer) {
+		return renderer->stats;
+	}
 }
@@ -21,12 +21,32 @@ namespace AB {
 		float32 quadratic;
 	};
 
+	struct AB_API RendererStats {
+		// NOTE: Counters of the last rendered frame
+		uint32 commands;
+		// Commands with resident mesh which passed and failed the frustum test
+		uint32 visible;
+		uint32 culled;
+		uint32 draw_calls;
+		// Program, mesh and texture binds which were actually emitted
+		uint32 state_changes;
+		// Binds skipped because the previous batch had the same state
+		uint32 state_changes_avoided;
+	};
+
 	AB_API Renderer* RendererInit();
 	AB_API void RendererSetSkybox(Renderer* renderer, int32 cubemapHandle);
 	AB_API void RendererSetDirectionalLight(Renderer* renderer, const DirectionalLight* light);
 	AB_API void RendererSetPointLight(Renderer* renderer, uint32 index, PointLight* light);
 	//AB_API int32 CreateMaterial(const char* diff_path, const char* spec_path, float32 shininess);
 	AB_API void RendererSetCamera(Renderer* renderer, hpm::Vector3 front, hpm::Vector3 position);
+	// Lods are switched when simplification error projected to the screen is below this number of pixels. Default is 1
+	AB_API void RendererSetLODErrorThreshold(Renderer* renderer, float32 pixels);
+	// Culling of meshlets against view frustum and by normal cones. Both are enabled by default.
+	// Cone culling drops clusters which face away from the camera, so it should be disabled for double sided geometry
+	AB_API void RendererSetMeshletCulling(Renderer* renderer, bool32 frustum, bool32 backface);
 	AB_API void RendererSubmit(Renderer* renderer, int32 mesh_handle, int32 material_handle, const hpm::Matrix4* transform);
+	// NOTE: Commands are sorted by state and drawn once. Queue is cleared after rendering
 	AB_API void RendererRender(Renderer* renderer);
+	AB_API RendererStats RendererGetStats(Renderer* renderer);
 }
@@ -0,0 +1,151 @@
+#include "StreamBuffer.h"
+#include "platform/API/OpenGL/OpenGL.h"
+#include "platform/Memory.h"
+#include "utils/Log.h"
+
+namespace AB {
+
+	static constexpr GLuint64 STREAM_BUFFER_FENCE_TIMEOUT_NS = 1000000000;
+
+	struct StreamBuffer {
+		uint32 api_handle;
+		uint32 frame_size;
+		uint32 uniform_alignment;
+		bool32 persistent;
+		// NOTE: Persistent mapping of all regions, or system memory copy of the frame for orphaning path
+		byte* memory;
+		uint32 region;
+		uint32 at;
+		// NOTE: Bytes of the frame already uploaded in orphaning path
+		uint32 flushed;
+		GLsync fences[STREAM_BUFFER_FRAME_COUNT];
+	};
+
+	StreamBuffer* StreamBufferCreate(uint32 frame_size) {
+		StreamBuffer* buffer = (StreamBuffer*)SysAlloc(sizeof(StreamBuffer));
+		*buffer = {};
+
+		GLint alignment = 0;
+		GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+		buffer->uniform_alignment = alignment > 0 ? (uint32)alignment : 256;
+		// NOTE: Regions begin at valid uniform buffer offsets
+		buffer->frame_size = (frame_size + buffer->uniform_alignment - 1) / buffer->uniform_alignment * buffer->uniform_alignment;
+
+		GLCall(glGenBuffers(1, &buffer->api_handle));
+		GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->api_handle));
+		if (glBufferStorage) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			GLsizeiptr total_size = (GLsizeiptr)buffer->frame_size * STREAM_BUFFER_FRAME_COUNT;
+			GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, total_size, nullptr, flags));
+			GLCall(buffer->memory = (byte*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total_size, flags));
+			if (buffer->memory) {
+				buffer->persistent = true;
+			} else {
+				// NOTE: Storage of the buffer is immutable now, so fallback needs a new one
+				AB_CORE_WARN("Failed to map stream buffer persistently. Falling back to orphaning.");
+				GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+				GLCall(glDeleteBuffers(1, &buffer->api_handle));
+				GLCall(glGenBuffers(1, &buffer->api_handle));
+				GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->api_handle));
+			}
+		}
+		if (!buffer->persistent) {
+			GLCall(glBufferData(GL_COPY_WRITE_BUFFER, buffer->frame_size, nullptr, GL_STREAM_DRAW));
+			// NOTE: System storage cannot free, so staging copy lives in the heap
+			buffer->memory = (byte*)std::malloc(buffer->frame_size);
+		}
+		GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+		return buffer;
+	}
+
+	void StreamBufferDestroy(StreamBuffer* buffer) {
+		for (uint32 i = 0; i < STREAM_BUFFER_FRAME_COUNT; i++) {
+			if (buffer->fences[i]) {
+				GLCall(glDeleteSync(buffer->fences[i]));
+				buffer->fences[i] = 0;
+			}
+		}
+		if (buffer->persistent) {
+			GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->api_handle));
+			GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+			GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+		} else {
+			std::free(buffer->memory);
+		}
+		GLCall(glDeleteBuffers(1, &buffer->api_handle));
+		buffer->api_handle = 0;
+		buffer->memory = nullptr;
+	}
+
+	void StreamBufferBeginFrame(StreamBuffer* buffer) {
+		buffer->at = 0;
+		buffer->flushed = 0;
+		if (buffer->persistent) {
+			GLsync fence = buffer->fences[buffer->region];
+			if (fence) {
+				// NOTE: Flush bit only for the first wait, otherwise the fence might never be submitted
+				GLenum status;
+				GLCall(status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_FENCE_TIMEOUT_NS));
+				while (status == GL_TIMEOUT_EXPIRED) {
+					GLCall(status = glClientWaitSync(fence, 0, STREAM_BUFFER_FENCE_TIMEOUT_NS));
+				}
+				if (status == GL_WAIT_FAILED) {
+					AB_CORE_ERROR("Failed to wait for stream buffer fence");
+				}
+				GLCall(glDeleteSync(fence));
+				buffer->fences[buffer->region] = 0;
+			}
+		} else {
+			GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->api_handle));
+			GLCall(glBufferData(GL_COPY_WRITE_BUFFER, buffer->frame_size, nullptr, GL_STREAM_DRAW));
+			GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+		}
+	}
+
+	StreamAllocation StreamBufferAlloc(StreamBuffer* buffer, uint32 size, uint32 alignment) {
+		StreamAllocation result = {};
+		uint32 offset = (buffer->at + alignment - 1) & ~(alignment - 1);
+		if (offset <= buffer->frame_size && size <= buffer->frame_size - offset) {
+			buffer->at = offset + size;
+			// NOTE: Orphaning path has only one region
+			uint32 region_offset = buffer->persistent ? buffer->region * buffer->frame_size : 0;
+			result.ptr = buffer->memory + region_offset + offset;
+			result.api_handle = buffer->api_handle;
+			result.offset = region_offset + offset;
+		} else {
+			AB_CORE_ERROR("Stream buffer is out of space. Frame size: %u32, requested: %u32", buffer->frame_size, size);
+		}
+		return result;
+	}
+
+	void StreamBufferFlush(StreamBuffer* buffer) {
+		// NOTE: Mapping is coherent in persistent path, so writes are already visible to subsequent commands
+		if (!buffer->persistent && buffer->at > buffer->flushed) {
+			// NOTE: Earlier draws of the frame may still read flushed part, but never this range
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+			uint32 size = buffer->at - buffer->flushed;
+			void* dest;
+			GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer->api_handle));
+			GLCall(dest = glMapBufferRange(GL_COPY_WRITE_BUFFER, buffer->flushed, size, flags));
+			if (dest) {
+				memcpy(dest, buffer->memory + buffer->flushed, size);
+				GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+			} else {
+				GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, buffer->flushed, size, buffer->memory + buffer->flushed));
+			}
+			GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+			buffer->flushed = buffer->at;
+		}
+	}
+
+	void StreamBufferEndFrame(StreamBuffer* buffer) {
+		if (buffer->persistent) {
+			GLCall(buffer->fences[buffer->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+			buffer->region = (buffer->region + 1) % STREAM_BUFFER_FRAME_COUNT;
+		}
+	}
+
+	uint32 StreamBufferGetUniformAlignment(StreamBuffer* buffer) {
+		return buffer->uniform_alignment;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "AB.h"
+
+namespace AB {
+	// NOTE: Per-frame GPU data (constants, instance and dynamic vertex data) is suballocated from one buffer
+	// split into STREAM_BUFFER_FRAME_COUNT regions. Region is reused only after fence of the frame
+	// which wrote it is signaled, so writes never wait on the driver.
+	// Uses persistent coherent mapping if ARB_buffer_storage is supported, otherwise
+	// writes go to system memory and are uploaded to buffer orphaned at the beginning of the frame
+	constexpr uint32 STREAM_BUFFER_FRAME_COUNT = 3;
+	constexpr uint32 STREAM_BUFFER_DEFAULT_FRAME_SIZE = 1024 * 1024;
+
+	struct StreamBuffer;
+
+	struct StreamAllocation {
+		// NOTE: Write only. Valid until StreamBufferEndFrame. Null if frame region is exhausted
+		void* ptr;
+		uint32 api_handle;
+		uint32 offset;
+	};
+
+	StreamBuffer* StreamBufferCreate(uint32 frame_size);
+	void StreamBufferDestroy(StreamBuffer* buffer);
+	// NOTE: Waits for the GPU if it still uses the region three frames behind
+	void StreamBufferBeginFrame(StreamBuffer* buffer);
+	// Offset is aligned to alignment, which should be power of two
+	StreamAllocation StreamBufferAlloc(StreamBuffer* buffer, uint32 size, uint32 alignment);
+	// NOTE: Should be called after writing allocations and before draws which read them
+	void StreamBufferFlush(StreamBuffer* buffer);
+	// Puts a fence after all commands using the current region
+	void StreamBufferEndFrame(StreamBuffer* buffer);
+	uint32 StreamBufferGetUniformAlignment(StreamBuffer* buffer);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "AB.h"
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// NOTE: Instruction set extensions which SIMD kernels are picked by at runtime.
+// Everything is inline so tools can use it without linking the engine.
+namespace AB {
+	struct CPUFeatures {
+		bool32 ssse3;
+		// NOTE: AVX flags are set only if OS saves YMM registers
+		bool32 avx;
+		bool32 avx2;
+	};
+
+	inline CPUFeatures _CPUDetectFeatures() {
+		CPUFeatures result = {};
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 1);
+		result.ssse3 = (info[2] & (1 << 9)) != 0;
+		result.avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		result.avx2 = result.avx && (info[1] & (1 << 5));
+#else
+		__builtin_cpu_init();
+		result.ssse3 = __builtin_cpu_supports("ssse3");
+		result.avx = __builtin_cpu_supports("avx");
+		result.avx2 = __builtin_cpu_supports("avx2");
+#endif
+		return result;
+	}
+
+	// NOTE: Detected once. Safe to call from any thread
+	inline const CPUFeatures* CPUGetFeatures() {
+		static CPUFeatures features = _CPUDetectFeatures();
+		return &features;
+	}
+}
@@ -43,23 +43,45 @@ namespace AB {
 		AB::Renderer2DDebugDrawString({ 35, canvas.y - h }, 20.0, (uint32)DebugUIColors::Clouds, buffer);
 	}
 
+	static void _DebugOverlayDrawMemoryPane(DebugOverlayProperties* properties) {
+		SysStorageStats* stats = &properties->memoryStats;
+		char buffer[128];
+		AB::FormatString(buffer, 128, "sys mem: %u64 kb used | %u64 kb committed | %u64 b padding",
+						 stats->used / 1024, stats->committed / 1024, stats->padding);
+		DebugOverlayPushString(properties, buffer);
+		for (uint32 i = 0; i < (uint32)MemorySubsystem::_Count; i++) {
+			if (stats->subsystem_bytes[i]) {
+				AB::FormatString(buffer, 128, "  %s: %u64 kb", MemorySubsystemName((MemorySubsystem)i), stats->subsystem_bytes[i] / 1024);
+				DebugOverlayPushString(properties, buffer);
+			}
+		}
+	}
+
 	void DrawDebugOverlay(DebugOverlayProperties* properties) {
 		if (properties->drawMainPane) {
 			_DebugOverlayDrawMainPane(properties);
 		}
 		properties->overlayAdvance = 0;
+		if (properties->drawMemoryPane) {
+			_DebugOverlayDrawMemoryPane(properties);
+		}
 	}
 
 	void DebugOverlayEnableMainPane(DebugOverlayProperties* properties, bool32 enable) {
 		properties->drawMainPane = enable;
 	}
 
+	void DebugOverlayEnableMemoryPane(DebugOverlayProperties* properties, bool32 enable) {
+		properties->drawMemoryPane = enable;
+	}
+
 	void UpdateDebugOverlay(DebugOverlayProperties* properties) {
 		auto* app = PermStorage()->application;
 		properties->frameTime = app->frame_time;
 		properties->fps = app->fps;
 		properties->ups = app->ups;
 		properties->drawCalls = Renderer2DGetDrawCallCount();
+		properties->memoryStats = SysStorageGetStats();
 	}
 
 	void DebugOverlayPushVar(DebugOverlayProperties* properties, const char* title, hpm::Vector2 vec) {
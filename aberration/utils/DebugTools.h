@@ -12,11 +12,14 @@ namespace AB {
 		hpm::Vector2 overlayBeginPos;
 		float32 overlayAdvance;
 		bool32 drawMainPane;
+		bool32 drawMemoryPane;
+		SysStorageStats memoryStats;
 	};
 
 	DebugOverlayProperties* CreateDebugOverlay();
 	AB_API void DrawDebugOverlay(DebugOverlayProperties* properties);
 	AB_API void DebugOverlayEnableMainPane(DebugOverlayProperties* properties, bool32 enable);
+	AB_API void DebugOverlayEnableMemoryPane(DebugOverlayProperties* properties, bool32 enable);
 	AB_API void UpdateDebugOverlay(DebugOverlayProperties* properties);
 	AB_API void DebugOverlayPushString(DebugOverlayProperties* properties, const char* string);
 	AB_API void DebugOverlayPushVar(DebugOverlayProperties* properties, const char* title, hpm::Vector2 vec);
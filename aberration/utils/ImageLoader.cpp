@@ -1,4 +1,5 @@
 #include "ImageLoader.h"
+#include "PixelSwizzle.h"
 #include "platform/Common.h"
 #include "utils/Log.h"
 #include <hypermath.h>
@@ -6,39 +7,38 @@
 
 namespace AB {
 	
-	Image LoadBMP(const char* filename) {
-		Image image = {};
-		uint32 dataSize;
-		byte* data = (byte*)AB::DebugReadFile(filename, &dataSize);
-		if (!data) {
-			AB_CORE_WARN("Failed to load BMP image: %s. Failed to open file.", filename);
-			return image;
+	bool32 ReadBMPInfo(const void* data, uint64 dataSize, const char* filename, BMPInfo* info) {
+		*info = {};
+		if (dataSize < sizeof(BMPHeader) + sizeof(BMPInfoHeaderCore)) {
+			AB_CORE_WARN("Failed to load BMP image: %s. File is too small.", filename);
+			return false;
 		}
-
 		BMPHeader* header = (BMPHeader*)data;
-		BMPInfoHeaderCore* infoHeader = (BMPInfoHeaderCore*)(data + sizeof(BMPHeader));
+		BMPInfoHeaderCore* infoHeader = (BMPInfoHeaderCore*)((byte*)data + sizeof(BMPHeader));
 		// TODO: Check is it actually bmp
 		uint16 bitsPerPixel = 0;
+		uint32 width = 0;
+		uint32 height = 0;
 
 		bool32 bottomUp = true;
 		switch (infoHeader->structSize) {
 			case sizeof(BMPInfoHeaderCore) : {
 				// Core version
-				image.width = infoHeader->width;
-				image.height = infoHeader->height;
+				width = infoHeader->width;
+				height = infoHeader->height;
 				bitsPerPixel = infoHeader->bitsPerPixel;
 			} break;
 				case sizeof(BMPInfoHeaderV3) : {
 					// Version 3
 					BMPInfoHeaderV3* v3 = (BMPInfoHeaderV3*)infoHeader;
-					if (infoHeader->height < 0) {
+					if (v3->height < 0) {
 						bottomUp = false;
-						image.height = (uint32)hpm::Abs(v3->height);
+						height = (uint32)hpm::Abs(v3->height);
 					}
 					else {
-						image.height = v3->height;
+						height = v3->height;
 					}
-					image.width = v3->width;
+					width = v3->width;
 					bitsPerPixel = v3->bitsPerPixel;
 
 				} break;
@@ -48,12 +48,12 @@ namespace AB {
 						BMPInfoHeaderV4* v4 = (BMPInfoHeaderV4*)infoHeader;
 						if (v4->height < 0) {
 							bottomUp = false;
-							image.height = (uint32)hpm::Abs(v4->height);
+							height = (uint32)hpm::Abs(v4->height);
 						}
 						else {
-							image.height = v4->height;
+							height = v4->height;
 						}
-						image.width = v4->width;
+						width = v4->width;
 						bitsPerPixel = v4->bitsPerPixel;
 					} break;
 					default: {
@@ -68,76 +68,130 @@ namespace AB {
 							//if (((uint32)(std::abs(v3c->height) * v3c->width)) == (header->size / (v3c->bitsPerPixel / 8))) {
 								if (v3c->height < 0) {
 									bottomUp = false;
-									image.height = (uint32)std::abs(v3c->height);
+									height = (uint32)std::abs(v3c->height);
 								}
 								else {
-									image.height = v3c->height;
+									height = v3c->height;
 								}
-								image.width = v3c->width;
+								width = v3c->width;
 								bitsPerPixel = v3c->bitsPerPixel;
 							//}
 							AB_CORE_WARN("WARNING: Unknown version of BMP header in file: %s", filename);
-							//memset(&image, 0, sizeof(Image));
-							//AB::DebugFreeFileMemory(data);
-							//return image;
-
 						}
 						else {
 							AB_CORE_WARN("Failed to load BMP image: %s. Unknown format version", filename);
-							memset(&image, 0, sizeof(Image));
-							AB::DebugFreeFileMemory(data);
-							return image;
+							return false;
 						}
 					} break;
 		}
 
-		// TODO: TEMPORARY: Abort loading if pixel order is top->down 
-		if (!bottomUp) {
-			AB_CORE_WARN("Failed to load BMP image: %s. Wrong data order.", filename);
-			memset(&image, 0, sizeof(Image));
-			AB::DebugFreeFileMemory(data);
-			return image;
+		if (bitsPerPixel != 32 && bitsPerPixel != 24) {
+			AB_CORE_WARN("Failed to load BMP image: %s. Wrong pixel size.", filename);
+			return false;
+		}
+
+		// NOTE: Rows are padded to 4 bytes. Padding is kept, it matches default GL unpack alignment
+		uint64 stride = ((uint64)width * (bitsPerPixel / 8) + 3) & ~3ull;
+		if (header->offsetToBitmap < sizeof(BMPHeader) + sizeof(uintptr) || header->offsetToBitmap + stride * height > dataSize) {
+			AB_CORE_WARN("Failed to load BMP image: %s. File is truncated.", filename);
+			return false;
 		}
 
-		image.bitmap = (byte*)data + header->offsetToBitmap;
-		// TODO: TEMPORARY: Store pointer to a beginning of block right before bitmap
-		*((uintptr*)image.bitmap - 1) = (uintptr)data;
+		info->width = width;
+		info->height = height;
+		info->bits_per_pixel = bitsPerPixel;
+		info->bottom_up = bottomUp;
+		info->stride = stride;
+		info->pixels_offset = header->offsetToBitmap;
+		return true;
+	}
 
-		if (bitsPerPixel == 32) {
-			image.format = PixelFormat::RGBA;
-			image.bit_per_pixel = bitsPerPixel;
-			for (int64 i = 0; i < image.height * image.width; i++) {
-				uint32 tmp;
-				uint32* pixel = ((uint32*)image.bitmap) + i;
-				//uint32 a = *pixel & 0xff000000;
-				//uint32 r = *pixel & 0x00ff0000;
-				//uint32 g = *pixel & 0x0000ff00;
-				//uint32 b = *pixel & 0x000000ff;
-				//*pixel = a | (r >> 16) | g | (b << 16);
-				tmp = 0xff00ff00 & *pixel;
-				*pixel = tmp | ((*pixel & 0x000000ff) << 16) | ((*pixel & 0x00ff0000) >> 16);
+	// NOTE: src and dst may be the same, then pixels are decoded in place
+	static void _DecodeBMPPixels(const byte* src, byte* dst, const BMPInfo* info) {
+		PixelSwizzleKernel kernel = PixelSwizzleBestKernel();
+		uint64 rowSize = (uint64)info->width * (info->bits_per_pixel / 8);
+		if (src == dst) {
+			if (!info->bottom_up) {
+				FlipRows(dst, info->stride, info->height, kernel);
 			}
-		}
-		else if (bitsPerPixel == 24) {
-			image.format = PixelFormat::RGB;
-			image.bit_per_pixel = bitsPerPixel;
-			for (int64 i = 0; i < (image.height * image.width * 3) - 3; i += 3) {
-				byte* pixel = ((byte*)image.bitmap) + i;
-				byte red = *(pixel);
-				*pixel = *(pixel + 2);
-				*(pixel + 2) = red;
+			if (info->bits_per_pixel == 32) {
+				SwapRedBlue32(dst, (uint64)info->width * info->height, kernel);
+			} else if (info->stride == rowSize) {
+				SwapRedBlue24(dst, (uint64)info->width * info->height, kernel);
+			} else {
+				for (uint32 y = 0; y < info->height; y++) {
+					SwapRedBlue24(dst + y * info->stride, info->width, kernel);
+				}
+			}
+		} else {
+			// NOTE: Swizzling row by row right after copy while it's still in cache
+			for (uint32 y = 0; y < info->height; y++) {
+				uint32 srcRow = info->bottom_up ? y : info->height - 1 - y;
+				byte* row = dst + y * info->stride;
+				memcpy(row, src + srcRow * info->stride, info->stride);
+				if (info->bits_per_pixel == 32) {
+					SwapRedBlue32(row, info->width, kernel);
+				} else {
+					SwapRedBlue24(row, info->width, kernel);
+				}
 			}
-
 		}
-		else {
-			AB_CORE_WARN("Failed to load BMP image: %s. Wrong pixel size.", filename);
-			memset(&image, 0, sizeof(Image));
+	}
+
+	static Image _ImageFromBMPInfo(const BMPInfo* info, byte* bitmap) {
+		Image image = {};
+		image.width = info->width;
+		image.height = info->height;
+		image.bit_per_pixel = info->bits_per_pixel;
+		image.format = info->bits_per_pixel == 32 ? PixelFormat::RGBA : PixelFormat::RGB;
+		image.mip_count = 1;
+		image.bitmap = bitmap;
+		return image;
+	}
+
+	// NOTE: Takes ownership of data. It should be allocated with DebugAllocFileMemory
+	static Image _DecodeBMP(byte* data, uint32 dataSize, const char* filename) {
+		Image image = {};
+		BMPInfo info;
+		if (ReadBMPInfo(data, dataSize, filename, &info)) {
+			image = _ImageFromBMPInfo(&info, data + info.pixels_offset);
+			// TODO: TEMPORARY: Store pointer to a beginning of block right before bitmap
+			*((uintptr*)image.bitmap - 1) = (uintptr)data;
+			_DecodeBMPPixels(image.bitmap, image.bitmap, &info);
+		} else {
 			AB::DebugFreeFileMemory(data);
-			return image;
 		}
 		return image;
 	}
 
+	Image DecodeBMPInto(const void* data, const BMPInfo* info, byte* dest) {
+		_DecodeBMPPixels((const byte*)data + info->pixels_offset, dest, info);
+		return _ImageFromBMPInfo(info, dest);
+	}
+
+	Image LoadBMP(const char* filename) {
+		Image image = {};
+		uint32 dataSize;
+		byte* data = (byte*)AB::DebugReadFile(filename, &dataSize);
+		if (!data) {
+			AB_CORE_WARN("Failed to load BMP image: %s. Failed to open file.", filename);
+			return image;
+		}
+		return _DecodeBMP(data, dataSize, filename);
+	}
+
+	Image LoadBMPFromMemory(const void* data, uint64 size, const char* name) {
+		Image image = {};
+		// NOTE: Decoding is done in place, so source is copied
+		byte* copy = (byte*)AB::DebugAllocFileMemory(size);
+		if (!copy) {
+			AB_CORE_WARN("Failed to load BMP image: %s. Memory allocation failed.", name);
+			return image;
+		}
+		memcpy(copy, data, size);
+		return _DecodeBMP(copy, (uint32)size, name);
+	}
+
 	void DeleteBitmap(void* ptr) {
 		void* actualMemory = (void*)*((uintptr*)ptr - 1);
 		AB::DebugFreeFileMemory(actualMemory);
@@ -6,7 +6,10 @@ namespace AB {
 	enum class PixelFormat : uint32 {
 		RGB = 0,
 		RGBA,
-		RED
+		RED,
+		// Block compressed. See ABT in FileFormats.h
+		BC1,
+		BC3
 	};
 
 	struct Image {
@@ -14,10 +17,29 @@ namespace AB {
 		uint32 height;
 		uint32 bit_per_pixel;
 		PixelFormat format;
+		// NOTE: Mips are stored in bitmap one after another. Decoded BMPs have single level
+		uint32 mip_count;
 		byte* bitmap;
 	};
 
+	// NOTE: Layout of BMP pixel data. Rows are padded to 4 bytes
+	struct BMPInfo {
+		uint32 width;
+		uint32 height;
+		uint32 bits_per_pixel;
+		bool32 bottom_up;
+		uint64 stride;
+		uint64 pixels_offset;
+	};
+
 	AB_API Image LoadBMP(const char* filename);
+	// Decodes BMP file image from memory. Source data is not modified
+	AB_API Image LoadBMPFromMemory(const void* data, uint64 size, const char* name);
+	// Parses and validates BMP header without touching pixel data. Returns false if image can't be decoded
+	AB_API bool32 ReadBMPInfo(const void* data, uint64 size, const char* name, BMPInfo* info);
+	// Decodes pixels of parsed BMP to dest which should hold info->stride * info->height bytes.
+	// Image doesn't own dest, so it should not be passed to DeleteBitmap. Source data is not modified
+	AB_API Image DecodeBMPInto(const void* data, const BMPInfo* info, byte* dest);
 	void DeleteBitmap(void* ptr);
 
 #pragma pack(push, 1)
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "AB.h"
+#include "CPUFeatures.h"
+#include <cstring>
+#include <immintrin.h>
+
+// NOTE: Channel swizzles used by BMP decoding. Everything is inline so tools can use it without linking the engine.
+// Every function has scalar, SSE2, SSSE3 and AVX2 kernels. Kernel is picked by the caller,
+// PixelSwizzleBestKernel returns the fastest one which is supported by CPU.
+// Kernels which are not implemented for some operation fall back to the best lower one.
+// Wide kernels are compiled with target attributes, so they don't require global compiler flags.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AB_SWIZZLE_TARGET(name)
+#else
+#define AB_SWIZZLE_TARGET(name) __attribute__((target(name)))
+#endif
+
+namespace AB {
+	enum class PixelSwizzleKernel : uint32 {
+		Scalar = 0,
+		SSE2,
+		SSSE3,
+		AVX2,
+		_Count
+	};
+
+	inline const char* PixelSwizzleKernelName(PixelSwizzleKernel kernel) {
+		switch (kernel) {
+		case PixelSwizzleKernel::Scalar: { return "scalar"; }
+		case PixelSwizzleKernel::SSE2: { return "SSE2"; }
+		case PixelSwizzleKernel::SSSE3: { return "SSSE3"; }
+		case PixelSwizzleKernel::AVX2: { return "AVX2"; }
+		default: { return "unknown"; }
+		}
+	}
+
+	// NOTE: SSE2 is the x86-64 baseline. Safe to call from any thread
+	inline PixelSwizzleKernel PixelSwizzleBestKernel() {
+		const CPUFeatures* cpu = CPUGetFeatures();
+		PixelSwizzleKernel result = PixelSwizzleKernel::SSE2;
+		if (cpu->avx2) {
+			result = PixelSwizzleKernel::AVX2;
+		} else if (cpu->ssse3) {
+			result = PixelSwizzleKernel::SSSE3;
+		}
+		return result;
+	}
+
+	inline void _SwapRedBlue32Scalar(byte* pixels, uint64 count) {
+		for (uint64 i = 0; i < count; i++) {
+			uint32 pixel;
+			memcpy(&pixel, pixels + i * 4, sizeof(uint32));
+			pixel = (pixel & 0xff00ff00) | ((pixel & 0x000000ff) << 16) | ((pixel & 0x00ff0000) >> 16);
+			memcpy(pixels + i * 4, &pixel, sizeof(uint32));
+		}
+	}
+
+	inline void _SwapRedBlue32SSE2(byte* pixels, uint64 count) {
+		__m128i ag_mask = _mm_set1_epi32((int32)0xff00ff00);
+		__m128i low_mask = _mm_set1_epi32(0x000000ff);
+		uint64 i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128i v = _mm_loadu_si128((__m128i*)(pixels + i * 4));
+			__m128i ag = _mm_and_si128(v, ag_mask);
+			__m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low_mask);
+			__m128i b = _mm_slli_epi32(_mm_and_si128(v, low_mask), 16);
+			_mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_or_si128(ag, _mm_or_si128(r, b)));
+		}
+		_SwapRedBlue32Scalar(pixels + i * 4, count - i);
+	}
+
+	AB_SWIZZLE_TARGET("avx2")
+	inline void _SwapRedBlue32AVX2(byte* pixels, uint64 count) {
+		__m256i shuffle = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		uint64 i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256i v = _mm256_loadu_si256((__m256i*)(pixels + i * 4));
+			_mm256_storeu_si256((__m256i*)(pixels + i * 4), _mm256_shuffle_epi8(v, shuffle));
+		}
+		_SwapRedBlue32SSE2(pixels + i * 4, count - i);
+	}
+
+	// BGRA <-> RGBA in place
+	inline void SwapRedBlue32(byte* pixels, uint64 count, PixelSwizzleKernel kernel) {
+		switch (kernel) {
+		case PixelSwizzleKernel::Scalar: { _SwapRedBlue32Scalar(pixels, count); } break;
+		case PixelSwizzleKernel::AVX2: { _SwapRedBlue32AVX2(pixels, count); } break;
+		default: { _SwapRedBlue32SSE2(pixels, count); } break;
+		}
+	}
+
+	inline void _SwapRedBlue24Scalar(byte* pixels, uint64 count) {
+		for (uint64 i = 0; i < count; i++) {
+			byte* pixel = pixels + i * 3;
+			byte red = pixel[0];
+			pixel[0] = pixel[2];
+			pixel[2] = red;
+		}
+	}
+
+	// NOTE: 16 pixels are 3 registers. Pixels 5 and 10 cross register boundaries,
+	// their bytes which go to another register are moved by separate shuffles.
+	// Loads and stores don't overlap, so there are no store forwarding stalls
+	AB_SWIZZLE_TARGET("ssse3")
+	inline void _SwapRedBlue24SSSE3(byte* pixels, uint64 count) {
+		__m128i shuffle_a = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1);
+		__m128i shuffle_b_to_a = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1);
+		__m128i shuffle_a_to_b = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m128i shuffle_b = _mm_setr_epi8(0, -1, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -1, 15);
+		__m128i shuffle_c_to_b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1);
+		__m128i shuffle_b_to_c = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m128i shuffle_c = _mm_setr_epi8(-1, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+		uint64 i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m128i* at = (__m128i*)(pixels + i * 3);
+			__m128i a = _mm_loadu_si128(at);
+			__m128i b = _mm_loadu_si128(at + 1);
+			__m128i c = _mm_loadu_si128(at + 2);
+			_mm_storeu_si128(at, _mm_or_si128(_mm_shuffle_epi8(a, shuffle_a), _mm_shuffle_epi8(b, shuffle_b_to_a)));
+			_mm_storeu_si128(at + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, shuffle_b), _mm_shuffle_epi8(a, shuffle_a_to_b)), _mm_shuffle_epi8(c, shuffle_c_to_b)));
+			_mm_storeu_si128(at + 2, _mm_or_si128(_mm_shuffle_epi8(c, shuffle_c), _mm_shuffle_epi8(b, shuffle_b_to_c)));
+		}
+		_SwapRedBlue24Scalar(pixels + i * 3, count - i);
+	}
+
+	// NOTE: Same as SSSE3 kernel, 128 bit lanes hold two consecutive groups of 16 pixels
+	AB_SWIZZLE_TARGET("avx2")
+	inline void _SwapRedBlue24AVX2(byte* pixels, uint64 count) {
+		__m256i shuffle_a = _mm256_setr_epi8(
+			2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1,
+			2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1);
+		__m256i shuffle_b_to_a = _mm256_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1);
+		__m256i shuffle_a_to_b = _mm256_setr_epi8(
+			-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m256i shuffle_b = _mm256_setr_epi8(
+			0, -1, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -1, 15,
+			0, -1, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -1, 15);
+		__m256i shuffle_c_to_b = _mm256_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1);
+		__m256i shuffle_b_to_c = _mm256_setr_epi8(
+			14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m256i shuffle_c = _mm256_setr_epi8(
+			-1, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13,
+			-1, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+		uint64 i = 0;
+		for (; i + 32 <= count; i += 32) {
+			__m128i* at = (__m128i*)(pixels + i * 3);
+			__m256i a = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(at)), _mm_loadu_si128(at + 3), 1);
+			__m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(at + 1)), _mm_loadu_si128(at + 4), 1);
+			__m256i c = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(at + 2)), _mm_loadu_si128(at + 5), 1);
+			__m256i out_a = _mm256_or_si256(_mm256_shuffle_epi8(a, shuffle_a), _mm256_shuffle_epi8(b, shuffle_b_to_a));
+			__m256i out_b = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(b, shuffle_b), _mm256_shuffle_epi8(a, shuffle_a_to_b)), _mm256_shuffle_epi8(c, shuffle_c_to_b));
+			__m256i out_c = _mm256_or_si256(_mm256_shuffle_epi8(c, shuffle_c), _mm256_shuffle_epi8(b, shuffle_b_to_c));
+			_mm_storeu_si128(at, _mm256_castsi256_si128(out_a));
+			_mm_storeu_si128(at + 1, _mm256_castsi256_si128(out_b));
+			_mm_storeu_si128(at + 2, _mm256_castsi256_si128(out_c));
+			_mm_storeu_si128(at + 3, _mm256_extracti128_si256(out_a, 1));
+			_mm_storeu_si128(at + 4, _mm256_extracti128_si256(out_b, 1));
+			_mm_storeu_si128(at + 5, _mm256_extracti128_si256(out_c, 1));
+		}
+		_SwapRedBlue24SSSE3(pixels + i * 3, count - i);
+	}
+
+	// BGR <-> RGB in place. There is no SSE2 kernel, it uses scalar one
+	inline void SwapRedBlue24(byte* pixels, uint64 count, PixelSwizzleKernel kernel) {
+		switch (kernel) {
+		case PixelSwizzleKernel::SSSE3: { _SwapRedBlue24SSSE3(pixels, count); } break;
+		case PixelSwizzleKernel::AVX2: { _SwapRedBlue24AVX2(pixels, count); } break;
+		default: { _SwapRedBlue24Scalar(pixels, count); } break;
+		}
+	}
+
+	inline void _ExpandBGRToRGBAScalar(const byte* src, byte* dest, uint64 count) {
+		for (uint64 i = 0; i < count; i++) {
+			dest[i * 4 + 0] = src[i * 3 + 2];
+			dest[i * 4 + 1] = src[i * 3 + 1];
+			dest[i * 4 + 2] = src[i * 3 + 0];
+			dest[i * 4 + 3] = 0xff;
+		}
+	}
+
+	// NOTE: 4 pixels per 16 byte load. Last pixels are done by scalar loop, so loads never go past the source
+	AB_SWIZZLE_TARGET("ssse3")
+	inline void _ExpandBGRToRGBASSSE3(const byte* src, byte* dest, uint64 count) {
+		__m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		__m128i alpha = _mm_set1_epi32((int32)0xff000000);
+		uint64 i = 0;
+		for (; i + 6 <= count; i += 4) {
+			__m128i v = _mm_loadu_si128((__m128i*)(src + i * 3));
+			_mm_storeu_si128((__m128i*)(dest + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+		}
+		_ExpandBGRToRGBAScalar(src + i * 3, dest + i * 4, count - i);
+	}
+
+	AB_SWIZZLE_TARGET("avx2")
+	inline void _ExpandBGRToRGBAAVX2(const byte* src, byte* dest, uint64 count) {
+		__m256i shuffle = _mm256_setr_epi8(
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		__m256i alpha = _mm256_set1_epi32((int32)0xff000000);
+		uint64 i = 0;
+		for (; i + 10 <= count; i += 8) {
+			const byte* at = src + i * 3;
+			__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i*)at)), _mm_loadu_si128((__m128i*)(at + 12)), 1);
+			_mm256_storeu_si256((__m256i*)(dest + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+		}
+		_ExpandBGRToRGBASSSE3(src + i * 3, dest + i * 4, count - i);
+	}
+
+	// 24 bit BGR -> 32 bit opaque RGBA. Buffers should not overlap. There is no SSE2 kernel, it uses scalar one
+	inline void ExpandBGRToRGBA(const byte* src, byte* dest, uint64 count, PixelSwizzleKernel kernel) {
+		switch (kernel) {
+		case PixelSwizzleKernel::SSSE3: { _ExpandBGRToRGBASSSE3(src, dest, count); } break;
+		case PixelSwizzleKernel::AVX2: { _ExpandBGRToRGBAAVX2(src, dest, count); } break;
+		default: { _ExpandBGRToRGBAScalar(src, dest, count); } break;
+		}
+	}
+
+	inline void _SwapBytesScalar(byte* a, byte* b, uint64 size) {
+		for (uint64 i = 0; i < size; i++) {
+			byte tmp = a[i];
+			a[i] = b[i];
+			b[i] = tmp;
+		}
+	}
+
+	inline void _SwapBytesSSE2(byte* a, byte* b, uint64 size) {
+		uint64 i = 0;
+		for (; i + 16 <= size; i += 16) {
+			__m128i va = _mm_loadu_si128((__m128i*)(a + i));
+			__m128i vb = _mm_loadu_si128((__m128i*)(b + i));
+			_mm_storeu_si128((__m128i*)(a + i), vb);
+			_mm_storeu_si128((__m128i*)(b + i), va);
+		}
+		_SwapBytesScalar(a + i, b + i, size - i);
+	}
+
+	AB_SWIZZLE_TARGET("avx2")
+	inline void _SwapBytesAVX2(byte* a, byte* b, uint64 size) {
+		uint64 i = 0;
+		for (; i + 32 <= size; i += 32) {
+			__m256i va = _mm256_loadu_si256((__m256i*)(a + i));
+			__m256i vb = _mm256_loadu_si256((__m256i*)(b + i));
+			_mm256_storeu_si256((__m256i*)(a + i), vb);
+			_mm256_storeu_si256((__m256i*)(b + i), va);
+		}
+		_SwapBytesSSE2(a + i, b + i, size - i);
+	}
+
+	// Reverses order of rows in place
+	inline void FlipRows(byte* data, uint64 stride, uint32 rows, PixelSwizzleKernel kernel) {
+		for (uint32 y = 0; y < rows / 2; y++) {
+			byte* a = data + y * stride;
+			byte* b = data + (rows - 1 - y) * stride;
+			switch (kernel) {
+			case PixelSwizzleKernel::Scalar: { _SwapBytesScalar(a, b, stride); } break;
+			case PixelSwizzleKernel::AVX2: { _SwapBytesAVX2(a, b, stride); } break;
+			default: { _SwapBytesSSE2(a, b, stride); } break;
+			}
+		}
+	}
+}
@@ -6,17 +6,6 @@ out vec4 color;
 
 #define POINT_LIGHTS_NUMBER  2
 
-struct Material {
-	bool use_diff_map;
-	bool use_spec_map;
-	sampler2D diffuse_map;
-	sampler2D spec_map;
-	float shininess;
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
 struct PointLight {
 	Vector3 position;
 	Vector3 ambient;
@@ -33,7 +22,17 @@ struct DirLight {
 	vec3 specular;
 };
 
-uniform Material material;
+// NOTE: Layout matches _MaterialStd140 in Renderer3D.cpp
+layout (std140) uniform materialData {
+	Vector3 ambient;
+	float32 shininess;
+	Vector3 diffuse;
+	int use_diff_map;
+	Vector3 specular;
+	int use_spec_map;
+} material;
+uniform sampler2D diffuse_map;
+uniform sampler2D spec_map;
 layout (std140) uniform pointLightsData {
 	PointLight pointLights[POINT_LIGHTS_NUMBER];
 };
@@ -76,8 +75,8 @@ void main()
 
 	vec3 diffSample;
 	float32 alpha;
-	if (material.use_diff_map) {
-		Vector4 _sample = texture(material.diffuse_map, f_UV); 
+	if (material.use_diff_map != 0) {
+		Vector4 _sample = texture(diffuse_map, f_UV); 
 		diffSample = _sample.rgb;
 		alpha = _sample.a;
 	} else {
@@ -86,8 +85,8 @@ void main()
 	}
 
 	vec3 specSample;
-	if (material.use_spec_map) {
-		specSample = texture(material.spec_map, f_UV).xyz;
+	if (material.use_spec_map != 0) {
+		specSample = texture(spec_map, f_UV).xyz;
 	} else {
 		specSample = material.specular;
 	}
@@ -12,8 +12,9 @@ LibDefines="-DAB_BUILD_DLL"
 CommonCompilerFlags="-std=c++17 -ffast-math -fno-rtti -fno-exceptions -static-libgcc -static-libstdc++ -fno-strict-aliasing -Werror -march=x86-64 -fPIC -Wl,-rpath=./"
 DebugCompilerFlags="-O0 -fno-inline-functions -g"
 ReleaseCompilerFlags="-O2 -finline-functions -g"
-LibLinkerFlags="-lGL -lX11"
+LibLinkerFlags="-lGL -lX11 -lpthread"
 AppLinkerFlags="-L$BinOutDir -laberration"
+ToolLinkerFlags="-lpthread"
 
 ConfigCompilerFlags=$DebugCompilerFlags
 
@@ -26,7 +27,7 @@ clang++ -save-temps=obj -o $BinOutDir/Sandbox $CommonDefines $IncludeDirs $Commo
 
 if [[ "$BuildTools" = true ]];
 then
-clang++ -save-temps=obj -o $BinOutDir/AssetBuilder $CommonDefines $IncludeDirs $CommonCompilerFlags $ConfigCompilerFlags tools/AssetBuilder/AssetBuilder.cpp
+clang++ -save-temps=obj -o $BinOutDir/AssetBuilder $CommonDefines $IncludeDirs $CommonCompilerFlags $ConfigCompilerFlags tools/AssetBuilder/AssetBuilder.cpp $ToolLinkerFlags
 clang++ -save-temps=obj -o $BinOutDir/FontPreprocessor $CommonDefines $IncludeDirs $CommonCompilerFlags $ConfigCompilerFlags tools/FontPreprocessor/FontPreprocessor.cpp
 fi
 #project/ctime -end _misc/ab_ctime.ctm
@@ -123,21 +123,21 @@ void Init() {
 	g_Renderer = AB::RendererInit();
 	g_Input = AB::InputInitialize();
 	auto asset_mgr = AB::AssetInitialize();
-	mesh = AB::AssetCreateMeshAAB(asset_mgr, "../assets/barrels/barrel1.aab");
-	mesh2 = AB::AssetCreateMeshAAB(asset_mgr, "../assets/barrels/barrel2.aab");
-	mesh3 = AB::AssetCreateMeshAAB(asset_mgr, "../assets/barrels/barrel3.aab");
-	plane = AB::AssetCreateMeshAAB(asset_mgr, "../assets/Plane.aab");
+	// NOTE: Pack is optional. Loose files are used if it's missing
+	AB::AssetMountPack(asset_mgr, "../assets/assets.abp", "../assets/");
+	mesh = AB::AssetCreateMeshAABAsync(asset_mgr, "../assets/barrels/barrel1.aab", false);
+	mesh2 = AB::AssetCreateMeshAABAsync(asset_mgr, "../assets/barrels/barrel2.aab", false);
+	mesh3 = AB::AssetCreateMeshAABAsync(asset_mgr, "../assets/barrels/barrel3.aab", false);
+	plane = AB::AssetCreateMeshAABAsync(asset_mgr, "../assets/Plane.aab", false);
 	Subscribe();
 
-	AB::Image px = AB::LoadBMP("../assets/cubemap/posx.bmp");
-	AB::Image nx = AB::LoadBMP("../assets/cubemap/negx.bmp");
-	AB::Image py = AB::LoadBMP("../assets/cubemap/posy.bmp");
-	AB::Image ny = AB::LoadBMP("../assets/cubemap/negy.bmp");
-	AB::Image pz = AB::LoadBMP("../assets/cubemap/posz.bmp");
-	AB::Image nz = AB::LoadBMP("../assets/cubemap/negz.bmp");
-
+	const char* cubemap_faces[AB::API::CUBEMAP_FACE_COUNT] = {
+		"../assets/cubemap/posx.bmp", "../assets/cubemap/negx.bmp",
+		"../assets/cubemap/posy.bmp", "../assets/cubemap/negy.bmp",
+		"../assets/cubemap/posz.bmp", "../assets/cubemap/negz.bmp"
+	};
 	AB::API::TextureParameters p = {AB::API::TextureFilter::Linear, AB::API:: TextureWrapMode::ClampToEdge};
-	uint32 cubemap = AB::API::CreateCubemap(p, px, nx, py, ny, pz, nz);
+	uint32 cubemap = AB::AssetCreateCubemapBMP(asset_mgr, cubemap_faces, p);
 	AB::RendererSetSkybox(g_Renderer, cubemap);
 	
 	AB::EventQuery tab_q = {};
@@ -231,6 +231,12 @@ void Render() {
 	AB::RendererSubmit(g_Renderer, mesh2, material, &tr);
 	AB::RendererSubmit(g_Renderer, mesh3, material, &tr);
 
+	AB::RendererStats render_stats = AB::RendererGetStats(g_Renderer);
+	DEBUG_OVERLAY_PUSH_VAR("visible", render_stats.visible);
+	DEBUG_OVERLAY_PUSH_VAR("culled", render_stats.culled);
+	DEBUG_OVERLAY_PUSH_VAR("state changes", render_stats.state_changes);
+	DEBUG_OVERLAY_PUSH_VAR("state changes avoided", render_stats.state_changes_avoided);
+
 	DEBUG_OVERLAY_PUSH_SLIDER("x", &light.direction.x, -1, 1);
 	DEBUG_OVERLAY_PUSH_SLIDER("y", &light.direction.y, -1, 1);
 	DEBUG_OVERLAY_PUSH_SLIDER("z", &light.direction.z, -1, 1);
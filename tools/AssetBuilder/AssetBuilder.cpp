@@ -1,11 +1,23 @@
 #include <cstdint>
 #include <cassert>
 #include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cfloat>
 
 #include "../../aberration/FileFormats.h"
+#include "../../aberration/Compression.h"
 #include <hypermath.h>
 
 #include "OBJLoader.cpp"
+#include "MeshOptimizer.cpp"
+#include "MeshSimplifier.cpp"
+#include "MeshletBuilder.cpp"
+#include "TextureCooker.cpp"
+#include "BuildCache.cpp"
+
+#include <atomic>
+#include <mutex>
 
 namespace AB {
 	
@@ -18,8 +30,15 @@ namespace AB {
 		uint32 num_vertices;
 		uint32 num_indices;
 
+		// NOTE: Index buffer is lod 0 followed by coarser lods.
+		// Zero lods means that whole index buffer is lod 0
 		uint32* indices;
 		int32 material_index;
+		uint32 num_lods;
+		AB::AABMeshLOD lods[AB::AAB_MAX_LODS];
+		// NOTE: Sorted by lod. Null if no lod is big enough to be split
+		AB::AABMeshlet* meshlets;
+		uint32 num_meshlets;
 	};
 
 	void FreeABMesh(ABMesh* mesh) {
@@ -35,11 +54,120 @@ namespace AB {
 		if (mesh->indices) {
 			free(mesh->indices);
 		}
+		if (mesh->meshlets) {
+			free(mesh->meshlets);
+		}
 
 		*mesh = {};
 	}
 
-	ABMesh GenABMesh(Mesh* mesh, std::vector<Material>* material_stack) {
+	// Welded vertex key. 3 position, 2 uv and 3 normal components
+	constexpr uint32 WELD_KEY_COMPONENTS = 8;
+	constexpr uint32 WELD_EMPTY_SLOT = 0xffffffff;
+
+	static int32 WeldKeyComponent(float32 value, float32 epsilon) {
+		int32 result;
+		if (epsilon > 0.0f) {
+			// NOTE: Snapping to epsilon grid. Values which are closer than epsilon
+			// but fall into different cells are not welded
+			result = (int32)floorf(value / epsilon + 0.5f);
+		} else {
+			// NOTE: -0.0f and 0.0f should produce same key
+			if (value == 0.0f) {
+				value = 0.0f;
+			}
+			memcpy(&result, &value, sizeof(int32));
+		}
+		return result;
+	}
+
+	static uint32 WeldKeyHash(const int32* key) {
+		// FNV-1a
+		uint32 hash = 2166136261u;
+		const byte* bytes = (const byte*)key;
+		for (uint32 i = 0; i < WELD_KEY_COMPONENTS * sizeof(int32); i++) {
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	// NOTE: Deduplicates identical (position, uv, normal) tuples and rebuilds index buffer.
+	// Welded vertex keeps attributes of first occurence
+	void WeldABMesh(ABMesh* mesh, float32 epsilon) {
+		uint32 num_vertices = mesh->num_vertices;
+		if (!num_vertices) {
+			return;
+		}
+
+		uint32 table_size = 1;
+		while (table_size < num_vertices * 2) {
+			table_size <<= 1;
+		}
+
+		uint32* table = (uint32*)malloc(table_size * sizeof(uint32));
+		int32* keys = (int32*)malloc((uint64)num_vertices * WELD_KEY_COMPONENTS * sizeof(int32));
+		uint32* remap = (uint32*)malloc(num_vertices * sizeof(uint32));
+		assert(table && keys && remap); // malloc failed
+		memset(table, 0xff, table_size * sizeof(uint32));
+
+		uint32 unique_count = 0;
+		for (uint32 i = 0; i < num_vertices; i++) {
+			int32* key = keys + (uint64)unique_count * WELD_KEY_COMPONENTS;
+			hpm::Vector2 uv = mesh->uv ? mesh->uv[i] : hpm::Vector2{};
+			key[0] = WeldKeyComponent(mesh->vertices[i].x, epsilon);
+			key[1] = WeldKeyComponent(mesh->vertices[i].y, epsilon);
+			key[2] = WeldKeyComponent(mesh->vertices[i].z, epsilon);
+			key[3] = WeldKeyComponent(uv.x, epsilon);
+			key[4] = WeldKeyComponent(uv.y, epsilon);
+			key[5] = WeldKeyComponent(mesh->normals[i].x, epsilon);
+			key[6] = WeldKeyComponent(mesh->normals[i].y, epsilon);
+			key[7] = WeldKeyComponent(mesh->normals[i].z, epsilon);
+
+			uint32 slot = WeldKeyHash(key) & (table_size - 1);
+			while (true) {
+				uint32 entry = table[slot];
+				if (entry == WELD_EMPTY_SLOT) {
+					table[slot] = unique_count;
+					remap[i] = unique_count;
+					mesh->vertices[unique_count] = mesh->vertices[i];
+					mesh->normals[unique_count] = mesh->normals[i];
+					if (mesh->uv) {
+						mesh->uv[unique_count] = mesh->uv[i];
+					}
+					unique_count++;
+					break;
+				}
+				if (memcmp(keys + (uint64)entry * WELD_KEY_COMPONENTS, key, WELD_KEY_COMPONENTS * sizeof(int32)) == 0) {
+					remap[i] = entry;
+					break;
+				}
+				slot = (slot + 1) & (table_size - 1);
+			}
+		}
+
+		for (uint32 i = 0; i < mesh->num_indices; i++) {
+			assert(mesh->indices[i] < num_vertices); // Out of range
+			mesh->indices[i] = remap[mesh->indices[i]];
+		}
+
+		// NOTE: Streams are compacted in place so just shrinking them
+		mesh->vertices = (hpm::Vector3*)realloc(mesh->vertices, unique_count * sizeof(hpm::Vector3));
+		mesh->normals = (hpm::Vector3*)realloc(mesh->normals, unique_count * sizeof(hpm::Vector3));
+		if (mesh->uv) {
+			mesh->uv = (hpm::Vector2*)realloc(mesh->uv, unique_count * sizeof(hpm::Vector2));
+		}
+		mesh->num_vertices = unique_count;
+
+		free(table);
+		free(keys);
+		free(remap);
+
+		printf("Vertex welding: %u -> %u vertices (%.1f%%)\n",
+			num_vertices, unique_count, (float32)unique_count / (float32)num_vertices * 100.0f);
+	}
+
+	ABMesh GenABMesh(Mesh* mesh, std::vector<Material>* material_stack, bool32 weld, float32 weld_epsilon) {
 		ABMesh ab_mesh = {};
 		assert(mesh->vertices != 0);
 		assert(mesh->num_vertex_indices % 3 == 0); // Mesh has non triangle faces
@@ -137,11 +265,354 @@ namespace AB {
 		ab_mesh.num_indices = (uint32)indices_at;
 		ab_mesh.material_index = material_index;
 
+		if (weld) {
+			WeldABMesh(&ab_mesh, weld_epsilon);
+		}
+
 		return ab_mesh;
 	}
 
+	// NOTE: Reorders triangles for vertex cache, optionally clusters them to reduce overdraw,
+	// then reorders vertices in order of first use for fetch locality
+	void OptimizeABMesh(ABMesh* mesh, bool32 optimize_overdraw) {
+		uint32 num_indices = mesh->num_indices;
+		uint32 num_vertices = mesh->num_vertices;
+		if (!num_indices) {
+			return;
+		}
+
+		VertexCacheStats before = AnalyzeVertexCache(mesh->indices, num_indices, num_vertices, VCACHE_ANALYZER_SIZE);
+
+		uint32* optimized = (uint32*)malloc(num_indices * sizeof(uint32));
+		assert(optimized); // malloc failed
+		OptimizeVertexCache(optimized, mesh->indices, num_indices, num_vertices);
+
+		if (optimize_overdraw) {
+			OptimizeOverdraw(mesh->indices, optimized, num_indices, mesh->vertices, num_vertices, OVERDRAW_DEFAULT_THRESHOLD);
+		} else {
+			memcpy(mesh->indices, optimized, num_indices * sizeof(uint32));
+		}
+		free(optimized);
+
+		uint32* remap = (uint32*)malloc(num_vertices * sizeof(uint32));
+		assert(remap); // malloc failed
+		uint32 used_vertices = OptimizeVertexFetchRemap(remap, mesh->indices, num_indices, num_vertices);
+
+		hpm::Vector3* vertices = (hpm::Vector3*)malloc(used_vertices * sizeof(hpm::Vector3));
+		hpm::Vector3* normals = (hpm::Vector3*)malloc(used_vertices * sizeof(hpm::Vector3));
+		assert(vertices && normals); // malloc failed
+		RemapVertexStream(vertices, mesh->vertices, num_vertices, sizeof(hpm::Vector3), remap);
+		RemapVertexStream(normals, mesh->normals, num_vertices, sizeof(hpm::Vector3), remap);
+		free(mesh->vertices);
+		free(mesh->normals);
+		mesh->vertices = vertices;
+		mesh->normals = normals;
+		if (mesh->uv) {
+			hpm::Vector2* uvs = (hpm::Vector2*)malloc(used_vertices * sizeof(hpm::Vector2));
+			assert(uvs); // malloc failed
+			RemapVertexStream(uvs, mesh->uv, num_vertices, sizeof(hpm::Vector2), remap);
+			free(mesh->uv);
+			mesh->uv = uvs;
+		}
+		mesh->num_vertices = used_vertices;
+		free(remap);
+
+		VertexCacheStats after = AnalyzeVertexCache(mesh->indices, num_indices, used_vertices, VCACHE_ANALYZER_SIZE);
+		printf("Vertex cache (%u entries FIFO): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+			VCACHE_ANALYZER_SIZE, before.acmr, after.acmr, before.atvr, after.atvr);
+	}
+
+	static uint64 AlignOffset(uint64 offset, uint64 aligment) {
+		return (offset + aligment - 1) & ~(aligment - 1);
+	}
+
+	struct MeshBounds {
+		hpm::Vector3 aabb_min;
+		hpm::Vector3 aabb_max;
+		hpm::Vector3 bsphere_center;
+		float32 bsphere_radius;
+	};
+
+	// NOTE: Sphere is centered at AABB center. Not minimal, but good enough for culling
+	MeshBounds CalculateMeshBounds(hpm::Vector3* vertices, uint32 num_vertices) {
+		MeshBounds bounds = {};
+		if (num_vertices) {
+			bounds.aabb_min = vertices[0];
+			bounds.aabb_max = vertices[0];
+			for (uint32 i = 1; i < num_vertices; i++) {
+				for (uint32 c = 0; c < 3; c++) {
+					if (vertices[i].data[c] < bounds.aabb_min.data[c]) bounds.aabb_min.data[c] = vertices[i].data[c];
+					if (vertices[i].data[c] > bounds.aabb_max.data[c]) bounds.aabb_max.data[c] = vertices[i].data[c];
+				}
+			}
+			for (uint32 c = 0; c < 3; c++) {
+				bounds.bsphere_center.data[c] = (bounds.aabb_min.data[c] + bounds.aabb_max.data[c]) * 0.5f;
+			}
+			float32 radius_sq = 0.0f;
+			for (uint32 i = 0; i < num_vertices; i++) {
+				float32 dx = vertices[i].x - bounds.bsphere_center.x;
+				float32 dy = vertices[i].y - bounds.bsphere_center.y;
+				float32 dz = vertices[i].z - bounds.bsphere_center.z;
+				float32 dist_sq = dx * dx + dy * dy + dz * dz;
+				if (dist_sq > radius_sq) radius_sq = dist_sq;
+			}
+			bounds.bsphere_radius = sqrtf(radius_sq);
+		}
+		return bounds;
+	}
+
+	// Each lod targets this fraction of previous lod indices
+	constexpr float32 LOD_REDUCTION_RATIO = 0.5f;
+	// Chain stops when lod has more than this fraction of previous lod indices
+	constexpr float32 LOD_MIN_REDUCTION = 0.85f;
+	// Simplification error limit relative to bounding sphere radius
+	constexpr float32 LOD_MAX_RELATIVE_ERROR = 0.05f;
+	constexpr uint32 LOD_MIN_INDICES = 3 * 16;
+
+	// NOTE: Every lod is simplified from lod 0, so errors are measured against the original surface.
+	// Lods share vertices with lod 0 and are appended to the index buffer.
+	// Should be called after OptimizeABMesh because simplified lods don't survive vertex reordering
+	void GenABMeshLODs(ABMesh* mesh, uint32 max_lods) {
+		uint32 lod0_count = mesh->num_indices;
+		mesh->num_lods = 1;
+		mesh->lods[0] = { 0, lod0_count, 0.0f };
+		if (!lod0_count || max_lods < 2) {
+			return;
+		}
+
+		MeshBounds bounds = CalculateMeshBounds(mesh->vertices, mesh->num_vertices);
+		float32 error_limit = bounds.bsphere_radius * LOD_MAX_RELATIVE_ERROR;
+
+		std::vector<uint32> indices(mesh->indices, mesh->indices + lod0_count);
+		uint32* simplified = (uint32*)malloc(lod0_count * sizeof(uint32));
+		uint32* optimized = (uint32*)malloc(lod0_count * sizeof(uint32));
+		assert(simplified && optimized); // malloc failed
+
+		uint32 prev_count = lod0_count;
+		float32 prev_error = 0.0f;
+		for (uint32 lod = 1; lod < max_lods && lod < AB::AAB_MAX_LODS; lod++) {
+			uint32 target = (uint32)(prev_count * LOD_REDUCTION_RATIO) / 3 * 3;
+			if (target < LOD_MIN_INDICES) {
+				break;
+			}
+			float32 error = 0.0f;
+			uint32 count = SimplifyMesh(simplified, mesh->indices, lod0_count, mesh->vertices, mesh->num_vertices, target, error_limit, &error);
+			if (!count || count > prev_count * LOD_MIN_REDUCTION) {
+				break;
+			}
+			OptimizeVertexCache(optimized, simplified, count, mesh->num_vertices);
+
+			// NOTE: Keeping errors monotonic so runtime can pick the last acceptable lod
+			prev_error = error > prev_error ? error : prev_error;
+			mesh->lods[lod] = { (uint32)indices.size(), count, prev_error };
+			indices.insert(indices.end(), optimized, optimized + count);
+			mesh->num_lods++;
+			prev_count = count;
+		}
+		free(simplified);
+		free(optimized);
+
+		if (mesh->num_lods > 1) {
+			mesh->indices = (uint32*)realloc(mesh->indices, indices.size() * sizeof(uint32));
+			assert(mesh->indices); // realloc failed
+			memcpy(mesh->indices, indices.data(), indices.size() * sizeof(uint32));
+			mesh->num_indices = (uint32)indices.size();
+		}
+
+		printf("LODs:");
+		for (uint32 i = 0; i < mesh->num_lods; i++) {
+			printf(" %u (%g)", mesh->lods[i].indices_count / 3, mesh->lods[i].error);
+		}
+		printf(" triangles\n");
+	}
+
+	// Lods with less triangles are drawn as a whole
+	constexpr uint32 MESHLET_MIN_LOD_TRIANGLES = 1024;
+
+	// NOTE: Clustering breaks vertex cache order, so triangles are reordered again inside meshlet.
+	// Meshlet vertices are remapped to local indices to keep optimizer tables small
+	static void OptimizeMeshletVertexCache(uint32* indices, uint32 num_indices) {
+		uint32 vertices[AB::AAB_MESHLET_MAX_VERTICES];
+		uint32 local[AB::AAB_MESHLET_MAX_TRIANGLES * 3];
+		uint32 optimized[AB::AAB_MESHLET_MAX_TRIANGLES * 3];
+		uint32 num_vertices = 0;
+		for (uint32 i = 0; i < num_indices; i++) {
+			uint32 v = 0;
+			while (v < num_vertices && vertices[v] != indices[i]) {
+				v++;
+			}
+			if (v == num_vertices) {
+				assert(num_vertices < AB::AAB_MESHLET_MAX_VERTICES);
+				vertices[num_vertices++] = indices[i];
+			}
+			local[i] = v;
+		}
+		OptimizeVertexCache(optimized, local, num_indices, num_vertices);
+		for (uint32 i = 0; i < num_indices; i++) {
+			indices[i] = vertices[optimized[i]];
+		}
+	}
+
+	// NOTE: Splits every big enough lod into meshlets. Triangles of lod are reordered in place,
+	// so should be called after GenABMeshLODs
+	void GenABMeshMeshlets(ABMesh* mesh) {
+		if (!mesh->num_lods) {
+			mesh->num_lods = 1;
+			mesh->lods[0] = { 0, mesh->num_indices, 0.0f };
+		}
+
+		uint32 capacity = 0;
+		for (uint32 i = 0; i < mesh->num_lods; i++) {
+			if (mesh->lods[i].indices_count / 3 >= MESHLET_MIN_LOD_TRIANGLES) {
+				capacity += mesh->lods[i].indices_count / 3;
+			}
+		}
+		if (!capacity) {
+			return;
+		}
+
+		AB::AABMeshlet* meshlets = (AB::AABMeshlet*)malloc(capacity * sizeof(AB::AABMeshlet));
+		uint32* clustered = (uint32*)malloc(mesh->lods[0].indices_count * sizeof(uint32));
+		assert(meshlets && clustered); // malloc failed
+
+		VertexCacheStats before = AnalyzeVertexCache(mesh->indices, mesh->lods[0].indices_count, mesh->num_vertices, VCACHE_ANALYZER_SIZE);
+		uint32 count = 0;
+		for (uint32 i = 0; i < mesh->num_lods; i++) {
+			AB::AABMeshLOD* lod = mesh->lods + i;
+			if (lod->indices_count / 3 < MESHLET_MIN_LOD_TRIANGLES) {
+				continue;
+			}
+			uint32* lod_indices = mesh->indices + lod->indices_offset;
+			uint32 lod_meshlets = BuildMeshlets(meshlets + count, clustered, lod_indices, lod->indices_count, mesh->vertices, mesh->num_vertices, AB::AAB_MESHLET_MAX_VERTICES, AB::AAB_MESHLET_MAX_TRIANGLES);
+			memcpy(lod_indices, clustered, lod->indices_count * sizeof(uint32));
+			for (uint32 m = 0; m < lod_meshlets; m++) {
+				AB::AABMeshlet* meshlet = meshlets + count + m;
+				meshlet->indices_offset += lod->indices_offset;
+				OptimizeMeshletVertexCache(mesh->indices + meshlet->indices_offset, meshlet->indices_count);
+			}
+			printf("Meshlets: lod %u, %u meshlets, %.1f triangles per meshlet\n", i, lod_meshlets, (float32)lod->indices_count / 3.0f / (float32)lod_meshlets);
+			count += lod_meshlets;
+		}
+		free(clustered);
+
+		if (count) {
+			VertexCacheStats after = AnalyzeVertexCache(mesh->indices, mesh->lods[0].indices_count, mesh->num_vertices, VCACHE_ANALYZER_SIZE);
+			printf("Vertex cache after clustering: ACMR %.3f -> %.3f\n", before.acmr, after.acmr);
+			mesh->meshlets = meshlets;
+			mesh->num_meshlets = count;
+		} else {
+			free(meshlets);
+		}
+	}
+
+	// NOTE: Vertex streams in the form they are written to file
+	struct PackedMeshStreams {
+		AB::AABVertexFormat format;
+		void* vertices;
+		void* normals;
+		void* uvs;
+		void* indices;
+		uint64 vertices_size;
+		uint64 normals_size;
+		uint64 uvs_size;
+		uint64 indices_size;
+	};
+
+	// NOTE: Quantized format is 16 bytes per vertex against 32 for float:
+	// positions are 16 bit relative to AABB (padded to 4 components to keep 8 byte stride),
+	// normals are octahedral snorm16, uvs are half floats.
+	// Indices are 16 bit if mesh has less than 65536 vertices.
+	PackedMeshStreams PackMeshStreams(ABMesh* mesh, MeshBounds* bounds, bool32 quantize) {
+		PackedMeshStreams streams = {};
+		uint32 num_vertices = mesh->num_vertices;
+		bool32 has_uv = mesh->uv != nullptr;
+
+		if (quantize) {
+			streams.format.position_format = AB::AAB_VERTEX_ATTRIB_UNORM16;
+			streams.format.position_components = 4;
+			streams.format.normal_format = AB::AAB_VERTEX_ATTRIB_OCT_SNORM16;
+			streams.format.normal_components = 2;
+			streams.format.uv_format = has_uv ? AB::AAB_VERTEX_ATTRIB_FLOAT16 : AB::AAB_VERTEX_ATTRIB_NONE;
+			streams.format.uv_components = has_uv ? 2 : 0;
+			streams.format.index_format = num_vertices < 65536 ? AB::AAB_INDEX_FORMAT_UINT16 : AB::AAB_INDEX_FORMAT_UINT32;
+		} else {
+			streams.format.position_format = AB::AAB_VERTEX_ATTRIB_FLOAT32;
+			streams.format.position_components = 3;
+			streams.format.normal_format = AB::AAB_VERTEX_ATTRIB_FLOAT32;
+			streams.format.normal_components = 3;
+			streams.format.uv_format = has_uv ? AB::AAB_VERTEX_ATTRIB_FLOAT32 : AB::AAB_VERTEX_ATTRIB_NONE;
+			streams.format.uv_components = has_uv ? 2 : 0;
+			streams.format.index_format = AB::AAB_INDEX_FORMAT_UINT32;
+		}
+
+		streams.vertices_size = (uint64)AB::AABVertexAttribFormatSize(streams.format.position_format) * streams.format.position_components * num_vertices;
+		streams.normals_size = (uint64)AB::AABVertexAttribFormatSize(streams.format.normal_format) * streams.format.normal_components * num_vertices;
+		streams.uvs_size = (uint64)AB::AABVertexAttribFormatSize(streams.format.uv_format) * streams.format.uv_components * num_vertices;
+		streams.indices_size = (uint64)AB::AABIndexFormatSize(streams.format.index_format) * mesh->num_indices;
+
+		streams.vertices = malloc(streams.vertices_size);
+		streams.normals = malloc(streams.normals_size);
+		streams.uvs = streams.uvs_size ? malloc(streams.uvs_size) : nullptr;
+		streams.indices = malloc(streams.indices_size);
+		assert(streams.vertices && streams.normals && streams.indices); // malloc failed
+
+		if (quantize) {
+			hpm::Vector3 extent = hpm::Subtract(bounds->aabb_max, bounds->aabb_min);
+			uint16* positions = (uint16*)streams.vertices;
+			for (uint32 i = 0; i < num_vertices; i++) {
+				for (uint32 c = 0; c < 3; c++) {
+					float32 t = extent.data[c] > 0.0f ? (mesh->vertices[i].data[c] - bounds->aabb_min.data[c]) / extent.data[c] : 0.0f;
+					t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+					positions[i * 4 + c] = (uint16)roundf(t * 65535.0f);
+				}
+				positions[i * 4 + 3] = 0;
+			}
+
+			int16* normals = (int16*)streams.normals;
+			for (uint32 i = 0; i < num_vertices; i++) {
+				AB::AABOctEncode(mesh->normals[i], normals + i * 2);
+			}
+
+			if (has_uv) {
+				uint16* uvs = (uint16*)streams.uvs;
+				for (uint32 i = 0; i < num_vertices; i++) {
+					uvs[i * 2 + 0] = AB::AABFloatToHalf(mesh->uv[i].x);
+					uvs[i * 2 + 1] = AB::AABFloatToHalf(mesh->uv[i].y);
+				}
+			}
+
+			if (streams.format.index_format == AB::AAB_INDEX_FORMAT_UINT16) {
+				uint16* indices = (uint16*)streams.indices;
+				for (uint32 i = 0; i < mesh->num_indices; i++) {
+					indices[i] = (uint16)mesh->indices[i];
+				}
+			} else {
+				memcpy(streams.indices, mesh->indices, streams.indices_size);
+			}
+		} else {
+			memcpy(streams.vertices, mesh->vertices, streams.vertices_size);
+			memcpy(streams.normals, mesh->normals, streams.normals_size);
+			if (has_uv) {
+				memcpy(streams.uvs, mesh->uv, streams.uvs_size);
+			}
+			memcpy(streams.indices, mesh->indices, streams.indices_size);
+		}
+
+		return streams;
+	}
+
+	void FreePackedMeshStreams(PackedMeshStreams* streams) {
+		free(streams->vertices);
+		free(streams->normals);
+		if (streams->uvs) {
+			free(streams->uvs);
+		}
+		free(streams->indices);
+		*streams = {};
+	}
+
 	// NOTE: This is crappy temporary solution
-	void WriteAABMesh(const char* file_name, ABMesh* mesh, std::vector<Material>* material_stack) {
+	void WriteAABMesh(const char* file_name, ABMesh* mesh, std::vector<Material>* material_stack, bool32 quantize, bool32 compress) {
 		// TODO: Temporary: writing matrial to mesh asset
 		uint64 material_name_size = 0;
 		uint64 material_props_size = 0;
@@ -152,10 +623,12 @@ namespace AB {
 		uint64 material_spec_name_size = 0;
 		char* material_spec_map_name = nullptr;
 
+		bool32 has_material = mesh->material_index != -1;
 		Material* material = {};
-		if (mesh->material_index != -1) { // has material
+		if (has_material) {
 			material = &(*material_stack)[mesh->material_index];
 			material_name_size = strlen(material->name) + 1;
+			material_props_size = sizeof(AB::AABMeshMaterialProperties);
 			if (material->spec_map_name) {
 				material_spec_map_name = material->spec_map_name;
 				material_spec_name_size = strlen(material->spec_map_name) + 1;
@@ -170,147 +643,812 @@ namespace AB {
 				material_diff_map_name = material->diff_map_name;
 			}
 		}
-		material_props_size = sizeof(AB::AABMeshMaterialProperties);
 
 		bool32 has_uv = mesh->uv != nullptr;
 		uint32 num_uv = has_uv ? mesh->num_vertices : 0;
 
-		uint64 data_size = sizeof(hpm::Vector3) * mesh->num_vertices
-			+ sizeof(hpm::Vector2) * num_uv
-			+ sizeof(hpm::Vector3) * mesh->num_vertices
-			+ sizeof(uint32) * mesh->num_indices
-			+ material_name_size
-			+ material_props_size
-			+ material_diff_name_size
-			+ material_spec_name_size;
+		MeshBounds bounds = CalculateMeshBounds(mesh->vertices, mesh->num_vertices);
+		PackedMeshStreams streams = PackMeshStreams(mesh, &bounds, quantize);
+
+		uint64 vertices_size = streams.vertices_size;
+		uint64 normals_size = streams.normals_size;
+		uint64 uvs_size = streams.uvs_size;
+		uint64 indices_size = streams.indices_size;
+
+		// NOTE: Calculating layout first. Padding is zeroed
+		uint64 at = AlignOffset(sizeof(AB::AABMeshHeader), AB::AAB_FIRST_STREAM_ALIGMENT);
+		uint64 vertices_offset = at;
+		at = AlignOffset(at + vertices_size, AB::AAB_SECTION_ALIGMENT);
+		uint64 normals_offset = at;
+		at = AlignOffset(at + normals_size, AB::AAB_SECTION_ALIGMENT);
+		uint64 uvs_offset = has_uv ? at : 0;
+		at = AlignOffset(at + uvs_size, AB::AAB_SECTION_ALIGMENT);
+		uint64 indices_offset = at;
+		at = AlignOffset(at + indices_size, AB::AAB_SECTION_ALIGMENT);
+		uint32 lods_count = mesh->num_lods ? mesh->num_lods : 1;
+		uint64 lods_offset = at;
+		at = AlignOffset(at + lods_count * sizeof(AB::AABMeshLOD), AB::AAB_SECTION_ALIGMENT);
+		uint64 meshlets_offset = mesh->num_meshlets ? at : 0;
+		at = AlignOffset(at + mesh->num_meshlets * sizeof(AB::AABMeshlet), AB::AAB_SECTION_ALIGMENT);
+		uint64 material_props_offset = has_material ? at : 0;
+		at += material_props_size;
+		uint64 material_name_offset = has_material ? at : 0;
+		at += material_name_size;
+		uint64 material_diff_name_offset = material_diff_name_size ? at : 0;
+		at += material_diff_name_size;
+		uint64 material_spec_name_offset = material_spec_name_size ? at : 0;
+		at += material_spec_name_size;
 
-		uint64 file_size = data_size + sizeof(AB::AABMeshHeader);
+		uint64 file_size = at;
 
-		void* file_buffer = malloc(file_size);
+		byte* file_buffer = (byte*)calloc(1, file_size);
 		assert(file_buffer); // malloc failed
 
 		AB::AABMeshHeader* header_ptr = (AB::AABMeshHeader*)file_buffer;
 		header_ptr->magic_value = AB::AAB_FILE_MAGIC_VALUE;
 		header_ptr->version = AB::AAB_FILE_VERSION;
-		header_ptr->asset_size = data_size;
+		header_ptr->asset_size = file_size - vertices_offset;
 		header_ptr->asset_type = AB::AAB_FILE_TYPE_MESH;
 		header_ptr->vertices_count = mesh->num_vertices;
 		header_ptr->normals_count = mesh->num_vertices;
 		header_ptr->uvs_count = num_uv;
 		header_ptr->indices_count = mesh->num_indices;
 
-		void* vertices_ptr = (void*)(header_ptr + 1);
-		uint64 vertices_size = sizeof(hpm::Vector3) * mesh->num_vertices;
-		memcpy(vertices_ptr, mesh->vertices, vertices_size);
+		header_ptr->vertex_format = streams.format;
 
+		header_ptr->vertices_offset = vertices_offset;
+		header_ptr->normals_offset = normals_offset;
+		header_ptr->uvs_offset = uvs_offset;
+		header_ptr->indices_offset = indices_offset;
+		header_ptr->material_properties_offset = material_props_offset;
+		header_ptr->material_name_offset = material_name_offset;
+		header_ptr->material_diff_bitmap_name_offset = material_diff_name_offset;
+		header_ptr->material_spec_bitmap_name_offset = material_spec_name_offset;
 
-		void* normals_ptr = (void*)((byte*)vertices_ptr + vertices_size);
-		uint64 normals_size = sizeof(hpm::Vector3) * mesh->num_vertices;
-		memcpy(normals_ptr, mesh->normals, normals_size);
+		header_ptr->aabb_min = bounds.aabb_min;
+		header_ptr->aabb_max = bounds.aabb_max;
+		header_ptr->bsphere_center = bounds.bsphere_center;
+		header_ptr->bsphere_radius = bounds.bsphere_radius;
+		header_ptr->lods_count = lods_count;
+		header_ptr->lods_offset = lods_offset;
+		header_ptr->meshlets_count = mesh->num_meshlets;
+		header_ptr->meshlets_offset = meshlets_offset;
 
-		void* uvs_ptr = (void*)((byte*)normals_ptr + normals_size);
-		uint64 uvs_size = sizeof(hpm::Vector2) * num_uv;
+		memcpy(file_buffer + vertices_offset, streams.vertices, vertices_size);
+		memcpy(file_buffer + normals_offset, streams.normals, normals_size);
 		if (uvs_size) {
-			memcpy(uvs_ptr, mesh->uv, uvs_size);
+			memcpy(file_buffer + uvs_offset, streams.uvs, uvs_size);
 		}
+		memcpy(file_buffer + indices_offset, streams.indices, indices_size);
+		FreePackedMeshStreams(&streams);
 
-		void* indices_ptr = (void*)((byte*)uvs_ptr + uvs_size);
-		uint64 indices_size = sizeof(uint32) * mesh->num_indices;
-		memcpy(indices_ptr, mesh->indices, indices_size);
-
-		if (mesh->material_index != -1) {
-			// TODO: Strings in the middle of file can break aligment.
-			// Should write strings at the end of file or introduce padding
-			void* mat_ptr = (void*)((byte*)indices_ptr + indices_size);
-			memcpy(mat_ptr, material->name, material_name_size);
-			mat_ptr = (void*)((byte*)mat_ptr + material_name_size);
+		if (mesh->num_lods) {
+			memcpy(file_buffer + lods_offset, mesh->lods, lods_count * sizeof(AB::AABMeshLOD));
+		} else {
+			AB::AABMeshLOD lod = { 0, mesh->num_indices, 0.0f };
+			memcpy(file_buffer + lods_offset, &lod, sizeof(AB::AABMeshLOD));
+		}
+		if (mesh->num_meshlets) {
+			memcpy(file_buffer + meshlets_offset, mesh->meshlets, mesh->num_meshlets * sizeof(AB::AABMeshlet));
+		}
 
+		if (has_material) {
 			AB::AABMeshMaterialProperties aab_material = {};
 			aab_material.k_a = material->ka;
 			aab_material.k_d = material->kd;
 			aab_material.k_s = material->ks;
 			aab_material.k_e = material->ke;
 			aab_material.shininess = material->shininess;
+			memcpy(file_buffer + material_props_offset, &aab_material, sizeof(aab_material));
 
-			memcpy(mat_ptr, &aab_material, sizeof(aab_material));
-
+			memcpy(file_buffer + material_name_offset, material->name, material_name_size);
 			if (material_diff_name_size) {
-				mat_ptr = (void*)((byte*)mat_ptr + material_props_size);
-				memcpy(mat_ptr, material_diff_map_name, material_diff_name_size);
+				memcpy(file_buffer + material_diff_name_offset, material_diff_map_name, material_diff_name_size);
 			}
-
 			if (material_spec_name_size) {
-				mat_ptr = (void*)((byte*)mat_ptr + material_diff_name_size);
-				memcpy(mat_ptr, material_spec_map_name, material_spec_name_size);
+				memcpy(file_buffer + material_spec_name_offset, material_spec_map_name, material_spec_name_size);
 			}
 		}
 
-		header_ptr->vertices_offset = sizeof(AB::AABMeshHeader);
-		header_ptr->normals_offset = header_ptr->vertices_offset + vertices_size;
-		header_ptr->uvs_offset = header_ptr->normals_offset + normals_size;
-		header_ptr->indices_offset = header_ptr->uvs_offset + uvs_size;
+		if (compress) {
+			uint64 compressed_capacity = ABZCompressBound(file_size);
+			byte* compressed = (byte*)malloc(compressed_capacity);
+			assert(compressed); // malloc failed
+			uint64 compressed_size = ABZCompress(file_buffer, file_size, compressed, compressed_capacity);
+			assert(compressed_size); // Compression failed
+			printf("Compressed %s: %llu -> %llu bytes (%.1f%%)\n", file_name, (unsigned long long)file_size,
+				(unsigned long long)compressed_size, 100.0 * (float64)compressed_size / (float64)file_size);
+			free(file_buffer);
+			file_buffer = compressed;
+			file_size = compressed_size;
+		}
+
+		assert(file_size < 0xffffffff); // Can`t write bigger than 4gb
+		bool32 result = WriteFile(file_name, file_buffer, (uint32)file_size);
+		assert(result); // Failed to write file
+
+		free(file_buffer);
+	}
+}
 
-		if (mesh->material_index != -1) {
-			header_ptr->material_name_offset = header_ptr->indices_offset + indices_size;
-			header_ptr->material_properties_offset = header_ptr->material_name_offset + material_name_size;
-			if (material_diff_map_name) {
-				header_ptr->material_diff_bitmap_name_offset = header_ptr->material_properties_offset + material_props_size;
+#include "PackBuilder.cpp"
+
+using namespace AB;
+
+// This is not POD! Do not memset it to 0
+struct BuilderOptions {
+	// Files or directories. Directories are searched for .obj files recursively
+	std::vector<const char*> inputs;
+	// Skip inputs which didn't change since the last build. See BuildCache.h
+	bool32 incremental;
+	// Non null in pack mode. Inputs are packed instead of being built
+	const char* pack_path;
+	bool32 quantize;
+	// Compress output with ABZ block compression. See Compression.h
+	bool32 compress;
+	bool32 no_optimize;
+	bool32 optimize_overdraw;
+	bool32 no_weld;
+	float32 weld_epsilon;
+	bool32 no_lods;
+	bool32 no_meshlets;
+	// Cook BMP material maps to ABT textures with mips and block compression. See TextureCooker.h
+	bool32 cook_textures;
+	// 0 means hardware concurrency
+	uint32 num_threads;
+	bool32 bench_parse;
+	bool32 bench_numbers;
+	bool32 bench_bmp;
+};
+
+static bool32 ParseBuilderOptions(int argc, char** argv, BuilderOptions* options) {
+	*options = {};
+	bool32 result = true;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--quantize") == 0) {
+			options->quantize = true;
+		} else if (strcmp(argv[i], "--compress") == 0) {
+			options->compress = true;
+		} else if (strcmp(argv[i], "--no-optimize") == 0) {
+			options->no_optimize = true;
+		} else if (strcmp(argv[i], "--overdraw") == 0) {
+			options->optimize_overdraw = true;
+		} else if (strcmp(argv[i], "--no-weld") == 0) {
+			options->no_weld = true;
+		} else if (strcmp(argv[i], "--no-lods") == 0) {
+			options->no_lods = true;
+		} else if (strcmp(argv[i], "--no-meshlets") == 0) {
+			options->no_meshlets = true;
+		} else if (strcmp(argv[i], "--textures") == 0) {
+			options->cook_textures = true;
+		} else if (strcmp(argv[i], "--weld-epsilon") == 0) {
+			if (i + 1 < argc) {
+				i++;
+				options->weld_epsilon = (float32)atof(argv[i]);
+			} else {
+				printf("Missing value for --weld-epsilon\n");
+				result = false;
 			}
-			else {
-				header_ptr->material_diff_bitmap_name_offset = 0;
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			if (i + 1 < argc) {
+				i++;
+				options->num_threads = (uint32)atoi(argv[i]);
+			} else {
+				printf("Missing value for --threads\n");
+				result = false;
+			}
+		} else if (strcmp(argv[i], "--pack") == 0) {
+			if (i + 1 < argc) {
+				i++;
+				options->pack_path = argv[i];
+			} else {
+				printf("Missing value for --pack\n");
+				result = false;
 			}
+		} else if (strcmp(argv[i], "--incremental") == 0) {
+			options->incremental = true;
+		} else if (strcmp(argv[i], "--bench-numbers") == 0) {
+			options->bench_numbers = true;
+		} else if (strcmp(argv[i], "--bench-parse") == 0) {
+			options->bench_parse = true;
+		} else if (strcmp(argv[i], "--bench-bmp") == 0) {
+			options->bench_bmp = true;
+		} else if (argv[i][0] == '-' && argv[i][1] == '-') {
+			printf("Unknown option: %s\n", argv[i]);
+			result = false;
+		} else {
+			options->inputs.push_back(argv[i]);
+		}
+	}
+	return result && (options->inputs.size() || options->bench_numbers);
+}
+
+static bool32 CompareParsedMeshes(std::vector<Mesh>* a, std::vector<Mesh>* b) {
+	if (a->size() != b->size()) {
+		return false;
+	}
+	for (uint32 i = 0; i < a->size(); i++) {
+		Mesh* ma = &(*a)[i];
+		Mesh* mb = &(*b)[i];
+		if (ma->num_vertices != mb->num_vertices || ma->num_normals != mb->num_normals ||
+			ma->num_uv != mb->num_uv || ma->num_vertex_indices != mb->num_vertex_indices ||
+			ma->num_normal_indices != mb->num_normal_indices || ma->num_uv_indices != mb->num_uv_indices) {
+			return false;
+		}
+		if (strcmp(ma->name, mb->name) != 0) {
+			return false;
+		}
+		if ((ma->material_name == nullptr) != (mb->material_name == nullptr) ||
+			(ma->material_name && strcmp(ma->material_name, mb->material_name) != 0)) {
+			return false;
+		}
+		if ((ma->num_vertices && memcmp(ma->vertices, mb->vertices, ma->num_vertices * sizeof(hpm::Vector3)) != 0) ||
+			(ma->num_normals && memcmp(ma->normals, mb->normals, ma->num_normals * sizeof(hpm::Vector3)) != 0) ||
+			(ma->num_uv && memcmp(ma->uv, mb->uv, ma->num_uv * sizeof(hpm::Vector2)) != 0) ||
+			(ma->num_vertex_indices && memcmp(ma->vertex_indices, mb->vertex_indices, ma->num_vertex_indices * sizeof(uint32)) != 0) ||
+			(ma->num_normal_indices && memcmp(ma->normal_indices, mb->normal_indices, ma->num_normal_indices * sizeof(uint32)) != 0) ||
+			(ma->num_uv_indices && memcmp(ma->uv_indices, mb->uv_indices, ma->num_uv_indices * sizeof(uint32)) != 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// NOTE: Compares ParseFloat32 and ParseUInt32 against libc on generated text.
+// Reports throughput and number of results which are not bit exact
+static void BenchmarkNumberParsingSet(const char* name, const char* text, uint64 text_size, uint32 count, bool32 floats) {
+	float64 size_mb = (float64)text_size / (1024.0 * 1024.0);
+	uint32* libc_results = (uint32*)malloc(count * sizeof(uint32));
+	uint32* fast_results = (uint32*)malloc(count * sizeof(uint32));
+	assert(libc_results && fast_results); // malloc failed
+
+	auto libc_begin = std::chrono::steady_clock::now();
+	const char* at = text;
+	for (uint32 i = 0; i < count; i++) {
+		char* next;
+		if (floats) {
+			float32 value = strtof(at, &next);
+			memcpy(&libc_results[i], &value, sizeof(uint32));
+		} else {
+			libc_results[i] = (uint32)strtoul(at, &next, 10);
+		}
+		at = next;
+	}
+	auto libc_end = std::chrono::steady_clock::now();
+
+	auto fast_begin = std::chrono::steady_clock::now();
+	at = text;
+	for (uint32 i = 0; i < count; i++) {
+		char* next;
+		if (floats) {
+			float32 value = ParseFloat32(at, &next);
+			memcpy(&fast_results[i], &value, sizeof(uint32));
+		} else {
+			fast_results[i] = ParseUInt32(at, &next);
+		}
+		at = next;
+	}
+	auto fast_end = std::chrono::steady_clock::now();
+
+	uint32 mismatches = 0;
+	for (uint32 i = 0; i < count; i++) {
+		if (libc_results[i] != fast_results[i]) {
+			mismatches++;
+		}
+	}
+
+	float64 libc_sec = std::chrono::duration<float64>(libc_end - libc_begin).count();
+	float64 fast_sec = std::chrono::duration<float64>(fast_end - fast_begin).count();
+	printf("%s: %u numbers, %.2f MB\n", name, count, size_mb);
+	printf("  %s: %.2f MB/s\n", floats ? "strtof " : "strtoul", size_mb / libc_sec);
+	printf("  %s: %.2f MB/s\n", floats ? "ParseFloat32" : "ParseUInt32 ", size_mb / fast_sec);
+	printf("  mismatches: %u\n", mismatches);
 
-			if (material_spec_map_name) {
-				header_ptr->material_spec_bitmap_name_offset = header_ptr->material_diff_bitmap_name_offset + material_diff_name_size;
+	free(libc_results);
+	free(fast_results);
+}
+
+static void BenchmarkNumberParsing() {
+	constexpr uint32 count = 1 << 20;
+	constexpr uint32 max_number_length = 32;
+	uint64 buffer_size = (uint64)count * max_number_length + TEXT_FILE_PADDING + 1;
+	char* text = (char*)malloc(buffer_size);
+	assert(text); // malloc failed
+
+	// NOTE: Fixed seed so runs are comparable
+	srand(1);
+	auto random_unit = []() { return (float32)rand() / (float32)RAND_MAX; };
+
+	const char* set_names[] = { "Mesh coordinates (%f)", "Shortest round trip (%.9g)", "Face indices", "Double precision coordinates (%.17g, %.15e)" };
+	for (uint32 set = 0; set < 4; set++) {
+		uint64 at = 0;
+		for (uint32 i = 0; i < count; i++) {
+			int written = 0;
+			if (set == 0) {
+				written = snprintf(text + at, max_number_length, "%f ", (random_unit() - 0.5f) * 2000.0f);
+			} else if (set == 1) {
+				// NOTE: Random finite float bit patterns
+				uint32 bits = ((uint32)rand() << 16) ^ (uint32)rand();
+				if (((bits >> 23) & 0xff) == 0xff) {
+					bits &= ~(1u << 30);
+				}
+				float32 value;
+				memcpy(&value, &bits, sizeof(float32));
+				written = snprintf(text + at, max_number_length, "%.9g ", value);
+			} else if (set == 2) {
+				written = snprintf(text + at, max_number_length, "%u/", (uint32)(random_unit() * 1000000.0f) + 1);
 			} else {
-				header_ptr->material_spec_bitmap_name_offset = 0;
+				// NOTE: 16-17 significant digits, as written by exporters which print doubles.
+				// Odd entries are near the midpoint between two floats, where rounding to float64 first
+				// and then to float32 gives wrong result
+				float64 value = ((float64)rand() / RAND_MAX + (float64)rand() / RAND_MAX / RAND_MAX - 0.5) * 2000.0;
+				if (i & 1) {
+					float32 low = (float32)value;
+					value = ((float64)low + (float64)nextafterf(low, low < 0.0f ? -INFINITY : INFINITY)) * 0.5;
+				}
+				written = snprintf(text + at, max_number_length, (i & 1) ? "%.15e " : "%.17g ", value);
 			}
+			at += written;
 		}
-		else {
-			header_ptr->material_name_offset = 0;
-			header_ptr->material_properties_offset = 0;
-			header_ptr->material_diff_bitmap_name_offset = 0;
-			header_ptr->material_spec_bitmap_name_offset = 0;
+		memset(text + at, 0, TEXT_FILE_PADDING + 1);
+		if (set == 2) {
+			// NOTE: Separators are skipped same way as ParseFace does
+			for (uint64 i = 0; i < at; i++) {
+				if (text[i] == '/') text[i] = ' ';
+			}
 		}
+		BenchmarkNumberParsingSet(set_names[set], text, at, count, set != 2);
+	}
 
-		assert(file_size < 0xffffffff); // Can`t write bigger than 4gb
-		bool32 result = WriteFile(file_name, file_buffer, (uint32)file_size);
-		assert(result); // Failed to write file
+	free(text);
+}
 
-		free(file_buffer);
+// NOTE: Parses file serially and in parallel, reports throughput and checks that outputs match
+static void BenchmarkOBJParsing(const char* path, uint32 num_threads) {
+	auto[data, size] = ReadEntireFileAsText(path);
+	if (!data) {
+		printf("Failed to read file: %s\n", path);
+		return;
+	}
+	FreeFileMemory(data);
+	float64 size_mb = (float64)size / (1024.0 * 1024.0);
+
+	std::vector<Mesh> serial_meshes;
+	std::vector<Material> serial_materials;
+	auto serial_begin = std::chrono::steady_clock::now();
+	ParseOBJ(path, &serial_meshes, &serial_materials);
+	auto serial_end = std::chrono::steady_clock::now();
+
+	std::vector<Mesh> parallel_meshes;
+	std::vector<Material> parallel_materials;
+	auto parallel_begin = std::chrono::steady_clock::now();
+	ParseOBJParallel(path, &parallel_meshes, &parallel_materials, num_threads);
+	auto parallel_end = std::chrono::steady_clock::now();
+
+	float64 serial_sec = std::chrono::duration<float64>(serial_end - serial_begin).count();
+	float64 parallel_sec = std::chrono::duration<float64>(parallel_end - parallel_begin).count();
+	printf("OBJ parsing %.2f MB\n", size_mb);
+	printf("  serial:   %.3f s, %.2f MB/s\n", serial_sec, size_mb / serial_sec);
+	printf("  parallel: %.3f s, %.2f MB/s (%u threads)\n", parallel_sec, size_mb / parallel_sec, num_threads);
+	printf("  outputs %s\n", CompareParsedMeshes(&serial_meshes, &parallel_meshes) ? "match" : "DIFFER");
+
+	for (uint32 i = 0; i < serial_meshes.size(); i++) {
+		FreeMesh(&serial_meshes[i]);
+	}
+	for (uint32 i = 0; i < parallel_meshes.size(); i++) {
+		FreeMesh(&parallel_meshes[i]);
 	}
 }
 
-using namespace AB;
-int main(int argc, char** argv) {
-	if (argc > 1) {
-		constexpr uint32 file_dir_sz = 512;
-		char file_dir[file_dir_sz];
-		auto[success, written] = GetDirectory(argv[1], file_dir, file_dir_sz);
-
-		if (success) {
-			std::vector<Mesh> mesh_stack;
-			std::vector<Material> material_stack;
-
-			ParseOBJ(argv[1], &mesh_stack, &material_stack);
-			for (uint32 i = 0; i < mesh_stack.size(); i++) {
-				ABMesh mesh = GenABMesh(&(mesh_stack[i]), &material_stack);
-				char* file_name = (char*)malloc(strlen(mesh_stack[i].name) + 4 + 2);
-				strcpy(file_name, mesh_stack[i].name);
-				strcat(file_name, ".aab");
-				WriteAABMesh(file_name, &mesh, &material_stack);
-				free(file_name);
-				FreeMesh(&(mesh_stack[i]));
-				FreeABMesh(&mesh);
-
-			}
-			//VertexData vertex_data = ParseOBJ((char*)data, size, file_dir);
-			//WriteAABMesh(vertex_data);
+// NOTE: Runs every supported swizzle kernel over pixels of BMP file. Reports throughput of
+// in place swizzle done by the engine loader, row flip and 24 -> 32 bit expansion, and checks that outputs match scalar kernel
+static void BenchmarkBMPSwizzle(const char* path) {
+	auto[data, size] = ReadEntireFile(path);
+	if (!data) {
+		printf("Failed to read file: %s\n", path);
+		return;
+	}
+	BMPLayout layout;
+	if (!ParseBMPLayout((const byte*)data, size, path, &layout)) {
+		FreeFileMemory(data);
+		return;
+	}
+	uint64 pixels_size = layout.stride * layout.height;
+	uint64 pixel_count = (uint64)layout.width * layout.height;
+	const byte* pixels = (const byte*)data + layout.pixels_offset;
+	// NOTE: Swizzle is done for whole image, so rows shouldn't be padded
+	bool32 packed_rows = layout.stride == (uint64)layout.width * (layout.bits_per_pixel / 8);
+	byte* reference = (byte*)malloc(pixels_size);
+	byte* work = (byte*)malloc(pixels_size);
+	byte* expanded_reference = (byte*)malloc(pixel_count * 4);
+	byte* expanded = (byte*)malloc(pixel_count * 4);
+	assert(reference && work && expanded_reference && expanded); // malloc failed
+
+	float64 size_mb = (float64)pixels_size / (1024.0 * 1024.0);
+	// NOTE: About 512 MB per measurement
+	uint32 repeats = (uint32)(512.0 / size_mb) + 1;
+	printf("%s: %ux%u, %u bit, %.2f MB, best kernel: %s\n", path, layout.width, layout.height, layout.bits_per_pixel,
+		size_mb, PixelSwizzleKernelName(PixelSwizzleBestKernel()));
+
+	memcpy(reference, pixels, pixels_size);
+	if (packed_rows) {
+		if (layout.bits_per_pixel == 32) {
+			SwapRedBlue32(reference, pixel_count, PixelSwizzleKernel::Scalar);
+		} else {
+			SwapRedBlue24(reference, pixel_count, PixelSwizzleKernel::Scalar);
+		}
+	}
+	if (layout.bits_per_pixel == 24) {
+		for (uint32 y = 0; y < layout.height; y++) {
+			ExpandBGRToRGBA(pixels + y * layout.stride, expanded_reference + (uint64)y * layout.width * 4, layout.width, PixelSwizzleKernel::Scalar);
+		}
+	}
+
+	for (uint32 k = 0; k <= (uint32)PixelSwizzleBestKernel(); k++) {
+		PixelSwizzleKernel kernel = (PixelSwizzleKernel)k;
+		bool32 match = true;
+		printf("  %s:\n", PixelSwizzleKernelName(kernel));
+
+		if (packed_rows) {
+			memcpy(work, pixels, pixels_size);
+			auto begin = std::chrono::steady_clock::now();
+			for (uint32 i = 0; i < repeats; i++) {
+				if (layout.bits_per_pixel == 32) {
+					SwapRedBlue32(work, pixel_count, kernel);
+				} else {
+					SwapRedBlue24(work, pixel_count, kernel);
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+			// NOTE: Every second pass restores source
+			if (repeats % 2 == 0) {
+				match &= memcmp(work, pixels, pixels_size) == 0;
+			} else {
+				match &= memcmp(work, reference, pixels_size) == 0;
+			}
+			float64 sec = std::chrono::duration<float64>(end - begin).count();
+			printf("    swizzle: %.2f MB/s\n", size_mb * repeats / sec);
+		}
+
+		{
+			memcpy(work, pixels, pixels_size);
+			auto begin = std::chrono::steady_clock::now();
+			for (uint32 i = 0; i < repeats; i++) {
+				FlipRows(work, layout.stride, layout.height, kernel);
+			}
+			auto end = std::chrono::steady_clock::now();
+			if (repeats % 2 == 0) {
+				match &= memcmp(work, pixels, pixels_size) == 0;
+			} else {
+				for (uint32 y = 0; y < layout.height; y++) {
+					match &= memcmp(work + y * layout.stride, pixels + (layout.height - 1 - y) * layout.stride, layout.stride) == 0;
+				}
+			}
+			float64 sec = std::chrono::duration<float64>(end - begin).count();
+			printf("    flip:    %.2f MB/s\n", size_mb * repeats / sec);
+		}
+
+		if (layout.bits_per_pixel == 24) {
+			auto begin = std::chrono::steady_clock::now();
+			for (uint32 i = 0; i < repeats; i++) {
+				for (uint32 y = 0; y < layout.height; y++) {
+					ExpandBGRToRGBA(pixels + y * layout.stride, expanded + (uint64)y * layout.width * 4, layout.width, kernel);
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+			match &= memcmp(expanded, expanded_reference, pixel_count * 4) == 0;
+			float64 sec = std::chrono::duration<float64>(end - begin).count();
+			printf("    expand:  %.2f MB/s\n", size_mb * repeats / sec);
+		}
+		printf("    outputs %s\n", match ? "match" : "DIFFER");
+	}
+
+	free(reference);
+	free(work);
+	free(expanded_reference);
+	free(expanded);
+	FreeFileMemory(data);
+}
+
+// NOTE: Hash of options which affect builder output
+static uint64 HashBuilderOptions(BuilderOptions* options) {
+	uint64 hash = HashBytes64(nullptr, 0);
+	hash = HashBytes64(&options->quantize, sizeof(options->quantize), hash);
+	hash = HashBytes64(&options->compress, sizeof(options->compress), hash);
+	hash = HashBytes64(&options->no_optimize, sizeof(options->no_optimize), hash);
+	hash = HashBytes64(&options->optimize_overdraw, sizeof(options->optimize_overdraw), hash);
+	hash = HashBytes64(&options->no_weld, sizeof(options->no_weld), hash);
+	hash = HashBytes64(&options->weld_epsilon, sizeof(options->weld_epsilon), hash);
+	hash = HashBytes64(&options->no_lods, sizeof(options->no_lods), hash);
+	hash = HashBytes64(&options->no_meshlets, sizeof(options->no_meshlets), hash);
+	hash = HashBytes64(&options->cook_textures, sizeof(options->cook_textures), hash);
+	uint32 file_version = AAB_FILE_VERSION;
+	hash = HashBytes64(&file_version, sizeof(file_version), hash);
+	uint32 texture_version = ABT_FILE_VERSION;
+	hash = HashBytes64(&texture_version, sizeof(texture_version), hash);
+	return hash;
+}
+
+enum class BuildJobStatus : uint32 {
+	Failed = 0, Built, UpToDate
+};
+
+// This is not POD! Do not memset it to 0
+struct BuildJob {
+	const char* input;
+	BuildJobStatus status;
+	// Filled when job was built
+	BuildManifestEntry entry;
+};
+
+struct BuildContext {
+	BuilderOptions* options;
+	uint64 options_hash;
+	// null if not incremental. Read only while jobs are running
+	BuildManifest* manifest;
+	// Threads used by OBJ parser of each job
+	uint32 parse_threads;
+	std::vector<BuildJob>* jobs;
+	std::atomic<uint32> next_job;
+	// Source paths of textures claimed for cooking. Every texture is cooked by the first job which references it
+	std::mutex cooked_textures_lock;
+	std::vector<char*> cooked_textures;
+};
+
+static void AddMaterialMapDependency(BuildManifestEntry* entry, const char* obj_dir, const char* map_name) {
+	if (map_name) {
+		char* path = JoinPath(obj_dir, map_name, '/');
+		AddBuildDependency(entry, path);
+		free(path);
+	}
+}
+
+// NOTE: Material always references cooked texture, even if it was cooked by another job or cooking failed.
+// Returns false if this job cooked the texture and cooking failed
+static bool32 CookMaterialMap(BuildContext* context, BuildManifestEntry* entry, const char* obj_dir, char** map_name, bool32 srgb) {
+	if (!*map_name || !HasExtension(*map_name, ".bmp")) {
+		return true;
+	}
+	char* path = JoinPath(obj_dir, *map_name, '/');
+	bool32 claimed = true;
+	{
+		std::lock_guard<std::mutex> lock(context->cooked_textures_lock);
+		for (uint32 i = 0; i < context->cooked_textures.size(); i++) {
+			if (strcmp(context->cooked_textures[i], path) == 0) {
+				claimed = false;
+				break;
+			}
+		}
+		if (claimed) {
+			context->cooked_textures.push_back(CopyString(path));
+		}
+	}
+
+	bool32 result = true;
+	if (claimed) {
+		char* out_path = ReplaceExtension(path, ".abt");
+		result = CookTexture(path, out_path, srgb, context->options->compress);
+		if (result) {
+			entry->outputs.push_back(out_path);
 		} else {
-			printf("Too long file path.\n");
+			free(out_path);
+		}
+	}
+	char* cooked_name = ReplaceExtension(*map_name, ".abt");
+	free(*map_name);
+	*map_name = cooked_name;
+	free(path);
+	return result;
+}
+
+static void RunBuildJob(BuildContext* context, BuildJob* job) {
+	BuilderOptions* options = context->options;
+	uint64 input_hash = HashFile(job->input);
+	if (input_hash == BUILD_MISSING_FILE_HASH) {
+		printf("Failed to read input: %s\n", job->input);
+		job->status = BuildJobStatus::Failed;
+		return;
+	}
+
+	if (context->manifest) {
+		BuildManifestEntry* cached = FindBuildManifestEntry(context->manifest, job->input);
+		if (cached && IsBuildUpToDate(cached, input_hash, context->options_hash)) {
+			printf("Up to date: %s\n", job->input);
+			job->status = BuildJobStatus::UpToDate;
+			return;
+		}
+	}
+
+	constexpr uint32 file_dir_sz = 512;
+	char file_dir[file_dir_sz];
+	auto[success, written] = GetDirectory(job->input, file_dir, file_dir_sz);
+	if (!success) {
+		printf("Too long file path: %s\n", job->input);
+		job->status = BuildJobStatus::Failed;
+		return;
+	}
+
+	printf("Building: %s\n", job->input);
+	std::vector<Mesh> mesh_stack;
+	std::vector<Material> material_stack;
+	std::vector<char*> mtl_libs;
+	ParseOBJParallel(job->input, &mesh_stack, &material_stack, context->parse_threads, &mtl_libs);
+
+	BuildManifestEntry* entry = &job->entry;
+	entry->input = CopyString(job->input);
+	entry->input_hash = input_hash;
+	entry->options_hash = context->options_hash;
+	entry->tool_version = ASSET_BUILDER_VERSION;
+	for (uint32 i = 0; i < mtl_libs.size(); i++) {
+		AddBuildDependency(entry, mtl_libs[i]);
+		free(mtl_libs[i]);
+	}
+	for (uint32 i = 0; i < material_stack.size(); i++) {
+		AddMaterialMapDependency(entry, file_dir, material_stack[i].diff_map_name);
+		AddMaterialMapDependency(entry, file_dir, material_stack[i].spec_map_name);
+		AddMaterialMapDependency(entry, file_dir, material_stack[i].amb_map_name);
+	}
+
+	bool32 textures_cooked = true;
+	if (options->cook_textures) {
+		// NOTE: Specular maps are not colors, so their mips are filtered as is.
+		// Ambient map is used as diffuse if there is no diffuse map
+		for (uint32 i = 0; i < material_stack.size(); i++) {
+			textures_cooked &= CookMaterialMap(context, entry, file_dir, &material_stack[i].diff_map_name, true);
+			textures_cooked &= CookMaterialMap(context, entry, file_dir, &material_stack[i].amb_map_name, true);
+			textures_cooked &= CookMaterialMap(context, entry, file_dir, &material_stack[i].spec_map_name, false);
+		}
+	}
+
+	for (uint32 i = 0; i < mesh_stack.size(); i++) {
+		ABMesh mesh = GenABMesh(&(mesh_stack[i]), &material_stack, !options->no_weld, options->weld_epsilon);
+		if (!options->no_optimize) {
+			printf("Optimizing mesh: %s\n", mesh_stack[i].name);
+			OptimizeABMesh(&mesh, options->optimize_overdraw);
+		}
+		if (!options->no_lods) {
+			GenABMeshLODs(&mesh, AB::AAB_MAX_LODS);
+		}
+		if (!options->no_meshlets) {
+			GenABMeshMeshlets(&mesh);
+		}
+		char* file_name = (char*)malloc(strlen(mesh_stack[i].name) + 4 + 2);
+		strcpy(file_name, mesh_stack[i].name);
+		strcat(file_name, ".aab");
+		WriteAABMesh(file_name, &mesh, &material_stack, options->quantize, options->compress);
+		entry->outputs.push_back(file_name);
+		FreeMesh(&(mesh_stack[i]));
+		FreeABMesh(&mesh);
+	}
+
+	job->status = mesh_stack.size() && textures_cooked ? BuildJobStatus::Built : BuildJobStatus::Failed;
+}
+
+static void BuildWorkerProc(BuildContext* context) {
+	while (true) {
+		uint32 index = context->next_job.fetch_add(1);
+		if (index >= context->jobs->size()) {
+			break;
+		}
+		RunBuildJob(context, &(*context->jobs)[index]);
+	}
+}
+
+static void BuildAssets(BuilderOptions* options, uint32 num_threads) {
+	auto build_begin = std::chrono::steady_clock::now();
+
+	std::vector<char*> inputs;
+	for (uint32 i = 0; i < options->inputs.size(); i++) {
+		if (IsDirectory(options->inputs[i])) {
+			ListFilesRecursive(options->inputs[i], ".obj", &inputs);
+		} else {
+			inputs.push_back(CopyString(options->inputs[i]));
+		}
+	}
+	// NOTE: Directory listing order is not defined. Sorting so builds and manifest are stable
+	std::sort(inputs.begin(), inputs.end(), [](const char* a, const char* b) { return strcmp(a, b) < 0; });
+
+	std::vector<BuildJob> jobs(inputs.size());
+	for (uint32 i = 0; i < inputs.size(); i++) {
+		jobs[i].input = inputs[i];
+		jobs[i].status = BuildJobStatus::Failed;
+	}
+
+	BuildManifest manifest;
+	if (options->incremental) {
+		LoadBuildManifest(BUILD_MANIFEST_FILE_NAME, &manifest);
+	}
+
+	BuildContext context;
+	context.options = options;
+	context.options_hash = HashBuilderOptions(options);
+	context.manifest = options->incremental ? &manifest : nullptr;
+	context.jobs = &jobs;
+	context.next_job = 0;
+
+	// NOTE: Many inputs are built in parallel, single input uses all threads for parsing
+	uint32 worker_count = num_threads < jobs.size() ? num_threads : (uint32)jobs.size();
+	context.parse_threads = worker_count > 1 ? 1 : num_threads;
+
+	std::vector<std::thread> workers;
+	for (uint32 i = 1; i < worker_count; i++) {
+		workers.push_back(std::thread(BuildWorkerProc, &context));
+	}
+	BuildWorkerProc(&context);
+	for (uint32 i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+
+	uint32 built = 0;
+	uint32 up_to_date = 0;
+	uint32 failed = 0;
+	for (uint32 i = 0; i < jobs.size(); i++) {
+		switch (jobs[i].status) {
+		case BuildJobStatus::Built: {
+			built++;
+			PutBuildManifestEntry(&manifest, &jobs[i].entry);
+		} break;
+		case BuildJobStatus::UpToDate: { up_to_date++; } break;
+		case BuildJobStatus::Failed: {
+			failed++;
+			FreeBuildManifestEntry(&jobs[i].entry);
+		} break;
+		}
+		free(inputs[i]);
+	}
+
+	if (options->incremental) {
+		SaveBuildManifest(BUILD_MANIFEST_FILE_NAME, &manifest);
+	}
+	FreeBuildManifest(&manifest);
+	for (uint32 i = 0; i < context.cooked_textures.size(); i++) {
+		free(context.cooked_textures[i]);
+	}
+
+	auto build_end = std::chrono::steady_clock::now();
+	float64 build_sec = std::chrono::duration<float64>(build_end - build_begin).count();
+	printf("Build finished in %.3f s: %u built, %u up to date, %u failed (%u threads)\n",
+		build_sec, built, up_to_date, failed, worker_count);
+}
+
+int main(int argc, char** argv) {
+	BuilderOptions options;
+	bool32 options_valid = ParseBuilderOptions(argc, argv, &options);
+	uint32 num_threads = options.num_threads;
+	if (!num_threads) {
+		num_threads = std::thread::hardware_concurrency();
+	}
+	if (!num_threads) {
+		num_threads = 1;
+	}
+
+	if (options_valid && options.bench_numbers) {
+		BenchmarkNumberParsing();
+	} else if (options_valid && options.bench_parse) {
+		for (uint32 i = 0; i < options.inputs.size(); i++) {
+			BenchmarkOBJParsing(options.inputs[i], num_threads);
+		}
+	} else if (options_valid && options.bench_bmp) {
+		std::vector<char*> bmps;
+		for (uint32 i = 0; i < options.inputs.size(); i++) {
+			if (IsDirectory(options.inputs[i])) {
+				ListFilesRecursive(options.inputs[i], ".bmp", &bmps);
+			} else {
+				bmps.push_back(CopyString(options.inputs[i]));
+			}
+		}
+		for (uint32 i = 0; i < bmps.size(); i++) {
+			BenchmarkBMPSwizzle(bmps[i]);
+			free(bmps[i]);
+		}
+	} else if (options_valid && options.pack_path) {
+		if (!BuildAssetPack(options.pack_path, &options.inputs)) {
+			return 1;
 		}
+	} else if (options_valid) {
+		BuildAssets(&options, num_threads);
 	} else {
-		printf("No input.\n");
+		printf("No input.\nUsage: AssetBuilder [--pack <out.abp>] [--incremental] [--quantize] [--compress] [--no-optimize] [--overdraw] [--no-weld] [--weld-epsilon <value>] [--no-lods] [--no-meshlets] [--textures] [--threads <n>] [--bench-parse] [--bench-numbers] [--bench-bmp] <file.obj | file.bmp | directory>...\n");
 	}
 	return 0;
 }
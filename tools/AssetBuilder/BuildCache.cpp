@@ -0,0 +1,189 @@
+#include "BuildCache.h"
+
+namespace AB {
+	static constexpr uint32 BUILD_MANIFEST_LINE_SIZE = 1024;
+	static constexpr uint64 BUILD_HASH_READ_CHUNK_SIZE = 1024 * 1024;
+
+	uint64 HashBytes64(const void* data, uint64 size, uint64 hash) {
+		const byte* bytes = (const byte*)data;
+		for (uint64 i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64 HashFile(const char* path) {
+		uint64 hash = BUILD_MISSING_FILE_HASH;
+		FILE* file = fopen(path, "rb");
+		if (file) {
+			byte* buffer = (byte*)malloc(BUILD_HASH_READ_CHUNK_SIZE);
+			assert(buffer); // malloc failed
+			hash = HashBytes64(nullptr, 0);
+			uint64 read = fread(buffer, 1, BUILD_HASH_READ_CHUNK_SIZE, file);
+			while (read) {
+				hash = HashBytes64(buffer, read, hash);
+				read = fread(buffer, 1, BUILD_HASH_READ_CHUNK_SIZE, file);
+			}
+			free(buffer);
+			fclose(file);
+		}
+		return hash;
+	}
+
+	bool32 FileExists(const char* path) {
+		FILE* file = fopen(path, "rb");
+		if (file) {
+			fclose(file);
+		}
+		return file != nullptr;
+	}
+
+	static char* CopyString(const char* string) {
+		uint64 size = strlen(string) + 1;
+		char* result = (char*)malloc(size);
+		assert(result); // malloc failed
+		memcpy(result, string, size);
+		return result;
+	}
+
+	void AddBuildDependency(BuildManifestEntry* entry, const char* path) {
+		for (uint32 i = 0; i < entry->dependencies.size(); i++) {
+			if (strcmp(entry->dependencies[i].path, path) == 0) {
+				return;
+			}
+		}
+		BuildDependency dependency;
+		dependency.path = CopyString(path);
+		dependency.hash = HashFile(path);
+		entry->dependencies.push_back(dependency);
+	}
+
+	void FreeBuildManifestEntry(BuildManifestEntry* entry) {
+		free(entry->input);
+		for (uint32 i = 0; i < entry->dependencies.size(); i++) {
+			free(entry->dependencies[i].path);
+		}
+		for (uint32 i = 0; i < entry->outputs.size(); i++) {
+			free(entry->outputs[i]);
+		}
+		*entry = BuildManifestEntry();
+	}
+
+	// NOTE: Manifest is a text file:
+	// ABManifest <manifest version>
+	// input <input hash> <options hash> <tool version> <path>
+	// dep <hash> <path>
+	// output <path>
+	// dep and output lines belong to the last input line
+	void LoadBuildManifest(const char* path, BuildManifest* manifest) {
+		FILE* file = fopen(path, "rb");
+		if (file) {
+			char line[BUILD_MANIFEST_LINE_SIZE];
+			bool32 valid = false;
+			if (fgets(line, BUILD_MANIFEST_LINE_SIZE, file)) {
+				valid = strncmp(line, "ABManifest ", 11) == 0 && strtoul(line + 11, nullptr, 10) == BUILD_MANIFEST_VERSION;
+			}
+			if (!valid) {
+				printf("Warning: unsupported build manifest %s. Rebuilding everything.\n", path);
+			}
+
+			BuildManifestEntry* entry = nullptr;
+			while (valid && fgets(line, BUILD_MANIFEST_LINE_SIZE, file)) {
+				uint64 len = strlen(line);
+				while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+					line[--len] = '\0';
+				}
+
+				char* at = line;
+				if (strncmp(at, "input ", 6) == 0) {
+					manifest->entries.push_back(BuildManifestEntry());
+					entry = &manifest->entries.back();
+					entry->input_hash = strtoull(at + 6, &at, 16);
+					entry->options_hash = strtoull(at, &at, 16);
+					entry->tool_version = (uint32)strtoul(at, &at, 10);
+					entry->input = CopyString(at + 1);
+				} else if (entry && strncmp(at, "dep ", 4) == 0) {
+					BuildDependency dependency;
+					dependency.hash = strtoull(at + 4, &at, 16);
+					dependency.path = CopyString(at + 1);
+					entry->dependencies.push_back(dependency);
+				} else if (entry && strncmp(at, "output ", 7) == 0) {
+					entry->outputs.push_back(CopyString(at + 7));
+				}
+			}
+			fclose(file);
+		}
+	}
+
+	bool32 SaveBuildManifest(const char* path, BuildManifest* manifest) {
+		bool32 result = false;
+		FILE* file = fopen(path, "wb");
+		if (file) {
+			fprintf(file, "ABManifest %u\n", BUILD_MANIFEST_VERSION);
+			for (uint32 i = 0; i < manifest->entries.size(); i++) {
+				BuildManifestEntry* entry = &manifest->entries[i];
+				fprintf(file, "input %016llx %016llx %u %s\n", (unsigned long long)entry->input_hash,
+					(unsigned long long)entry->options_hash, entry->tool_version, entry->input);
+				for (uint32 j = 0; j < entry->dependencies.size(); j++) {
+					fprintf(file, "dep %016llx %s\n", (unsigned long long)entry->dependencies[j].hash, entry->dependencies[j].path);
+				}
+				for (uint32 j = 0; j < entry->outputs.size(); j++) {
+					fprintf(file, "output %s\n", entry->outputs[j]);
+				}
+			}
+			result = fclose(file) == 0;
+		}
+		if (!result) {
+			printf("Failed to write build manifest: %s\n", path);
+		}
+		return result;
+	}
+
+	void FreeBuildManifest(BuildManifest* manifest) {
+		for (uint32 i = 0; i < manifest->entries.size(); i++) {
+			FreeBuildManifestEntry(&manifest->entries[i]);
+		}
+		manifest->entries.clear();
+	}
+
+	BuildManifestEntry* FindBuildManifestEntry(BuildManifest* manifest, const char* input) {
+		BuildManifestEntry* result = nullptr;
+		for (uint32 i = 0; i < manifest->entries.size(); i++) {
+			if (strcmp(manifest->entries[i].input, input) == 0) {
+				result = &manifest->entries[i];
+				break;
+			}
+		}
+		return result;
+	}
+
+	void PutBuildManifestEntry(BuildManifest* manifest, BuildManifestEntry* entry) {
+		BuildManifestEntry* existing = FindBuildManifestEntry(manifest, entry->input);
+		if (existing) {
+			FreeBuildManifestEntry(existing);
+			*existing = *entry;
+		} else {
+			manifest->entries.push_back(*entry);
+		}
+		*entry = BuildManifestEntry();
+	}
+
+	bool32 IsBuildUpToDate(BuildManifestEntry* entry, uint64 input_hash, uint64 options_hash) {
+		if (entry->tool_version != ASSET_BUILDER_VERSION || entry->options_hash != options_hash ||
+			entry->input_hash != input_hash) {
+			return false;
+		}
+		for (uint32 i = 0; i < entry->dependencies.size(); i++) {
+			if (HashFile(entry->dependencies[i].path) != entry->dependencies[i].hash) {
+				return false;
+			}
+		}
+		for (uint32 i = 0; i < entry->outputs.size(); i++) {
+			if (!FileExists(entry->outputs[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
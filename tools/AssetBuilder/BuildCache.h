@@ -0,0 +1,49 @@
+#pragma once
+
+namespace AB {
+	// Bump when builder output changes for the same input and options
+	constexpr uint32 ASSET_BUILDER_VERSION = 3;
+	constexpr uint32 BUILD_MANIFEST_VERSION = 1;
+	constexpr const char* BUILD_MANIFEST_FILE_NAME = "AssetBuilder.manifest";
+	// Hash recorded for dependencies which don't exist
+	constexpr uint64 BUILD_MISSING_FILE_HASH = 0;
+
+	struct BuildDependency {
+		char* path;
+		uint64 hash;
+	};
+
+	// This is not POD! Do not memset it to 0
+	struct BuildManifestEntry {
+		char* input;
+		uint64 input_hash;
+		uint64 options_hash;
+		uint32 tool_version;
+		std::vector<BuildDependency> dependencies;
+		std::vector<char*> outputs;
+	};
+
+	struct BuildManifest {
+		std::vector<BuildManifestEntry> entries;
+	};
+
+	// FNV-1a
+	uint64 HashBytes64(const void* data, uint64 size, uint64 hash = 14695981039346656037ull);
+	// Returns BUILD_MISSING_FILE_HASH if file can't be read
+	uint64 HashFile(const char* path);
+	bool32 FileExists(const char* path);
+
+	void AddBuildDependency(BuildManifestEntry* entry, const char* path);
+	void FreeBuildManifestEntry(BuildManifestEntry* entry);
+
+	void LoadBuildManifest(const char* path, BuildManifest* manifest);
+	bool32 SaveBuildManifest(const char* path, BuildManifest* manifest);
+	void FreeBuildManifest(BuildManifest* manifest);
+	BuildManifestEntry* FindBuildManifestEntry(BuildManifest* manifest, const char* input);
+	// Replaces entry with the same input. Takes ownership of entry data
+	void PutBuildManifestEntry(BuildManifest* manifest, BuildManifestEntry* entry);
+
+	// Entry is up to date if tool version, options, input and all dependency hashes match
+	// and all outputs exist
+	bool32 IsBuildUpToDate(BuildManifestEntry* entry, uint64 input_hash, uint64 options_hash);
+}
@@ -0,0 +1,334 @@
+#include "MeshOptimizer.h"
+
+namespace AB {
+
+	static constexpr uint32 INVALID_INDEX = 0xffffffff;
+
+	VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint32 num_indices, uint32 num_vertices, uint32 cache_size) {
+		VertexCacheStats stats = {};
+		// NOTE: FIFO cache. Vertex is in cache if it was inserted less than cache_size misses ago
+		uint32* cache_timestamps = (uint32*)calloc(num_vertices, sizeof(uint32));
+		assert(cache_timestamps); // malloc failed
+		uint32 timestamp = cache_size + 1;
+
+		for (uint32 i = 0; i < num_indices; i++) {
+			uint32 index = indices[i];
+			assert(index < num_vertices);
+			if (timestamp - cache_timestamps[index] > cache_size) {
+				cache_timestamps[index] = timestamp;
+				timestamp++;
+				stats.misses++;
+			}
+		}
+
+		free(cache_timestamps);
+
+		uint32 num_triangles = num_indices / 3;
+		uint32 used_vertices = 0;
+		bool32* used = (bool32*)calloc(num_vertices, sizeof(bool32));
+		assert(used); // malloc failed
+		for (uint32 i = 0; i < num_indices; i++) {
+			if (!used[indices[i]]) {
+				used[indices[i]] = true;
+				used_vertices++;
+			}
+		}
+		free(used);
+
+		stats.acmr = num_triangles ? (float32)stats.misses / num_triangles : 0.0f;
+		stats.atvr = used_vertices ? (float32)stats.misses / used_vertices : 0.0f;
+		return stats;
+	}
+
+	// NOTE: Scoring from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	static constexpr float32 FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	static constexpr float32 FORSYTH_LAST_TRI_SCORE = 0.75f;
+	static constexpr float32 FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	static constexpr float32 FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	static float32 ForsythVertexScore(int32 cache_position, uint32 remaining_triangles) {
+		float32 score = 0.0f;
+		if (remaining_triangles) {
+			if (cache_position >= 0) {
+				if (cache_position < 3) {
+					// NOTE: Vertices of the last triangle get fixed score
+					// so algorithm doesn't prefer to reuse the same triangle edge
+					score = FORSYTH_LAST_TRI_SCORE;
+				} else {
+					float32 scaler = 1.0f / (VCACHE_OPTIMIZER_SIZE - 3);
+					score = 1.0f - (cache_position - 3) * scaler;
+					score = powf(score, FORSYTH_CACHE_DECAY_POWER);
+				}
+			}
+			// NOTE: Boost vertices with few triangles left so lone triangles don't stay behind
+			score += FORSYTH_VALENCE_BOOST_SCALE * powf((float32)remaining_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+		}
+		return score;
+	}
+
+	void OptimizeVertexCache(uint32* dest, const uint32* indices, uint32 num_indices, uint32 num_vertices) {
+		assert(dest != indices);
+		assert(num_indices % 3 == 0);
+		uint32 num_triangles = num_indices / 3;
+		if (!num_triangles) {
+			return;
+		}
+
+		// NOTE: Vertex -> triangles adjacency in CSR form
+		uint32* adjacency_offsets = (uint32*)calloc(num_vertices + 1, sizeof(uint32));
+		uint32* remaining = (uint32*)calloc(num_vertices, sizeof(uint32));
+		uint32* adjacency = (uint32*)malloc(num_indices * sizeof(uint32));
+		int32* cache_positions = (int32*)malloc(num_vertices * sizeof(int32));
+		float32* vertex_scores = (float32*)malloc(num_vertices * sizeof(float32));
+		float32* triangle_scores = (float32*)malloc(num_triangles * sizeof(float32));
+		bool32* emitted = (bool32*)calloc(num_triangles, sizeof(bool32));
+		assert(adjacency_offsets && remaining && adjacency && cache_positions && vertex_scores && triangle_scores && emitted); // malloc failed
+
+		for (uint32 i = 0; i < num_indices; i++) {
+			assert(indices[i] < num_vertices);
+			remaining[indices[i]]++;
+		}
+		for (uint32 v = 0; v < num_vertices; v++) {
+			adjacency_offsets[v + 1] = adjacency_offsets[v] + remaining[v];
+		}
+		uint32* fill = (uint32*)malloc(num_vertices * sizeof(uint32));
+		assert(fill); // malloc failed
+		memcpy(fill, adjacency_offsets, num_vertices * sizeof(uint32));
+		for (uint32 t = 0; t < num_triangles; t++) {
+			for (uint32 k = 0; k < 3; k++) {
+				uint32 v = indices[t * 3 + k];
+				adjacency[fill[v]++] = t;
+			}
+		}
+		free(fill);
+
+		for (uint32 v = 0; v < num_vertices; v++) {
+			cache_positions[v] = -1;
+			vertex_scores[v] = ForsythVertexScore(-1, remaining[v]);
+		}
+		for (uint32 t = 0; t < num_triangles; t++) {
+			triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+		}
+
+		// NOTE: Three extra slots for vertices pushed out of cache by the new triangle
+		uint32 cache[VCACHE_OPTIMIZER_SIZE + 3];
+		uint32 new_cache[VCACHE_OPTIMIZER_SIZE + 3];
+		uint32 cache_count = 0;
+
+		uint32 best_triangle = INVALID_INDEX;
+		float32 best_score = -1.0f;
+		for (uint32 t = 0; t < num_triangles; t++) {
+			if (triangle_scores[t] > best_score) {
+				best_score = triangle_scores[t];
+				best_triangle = t;
+			}
+		}
+
+		uint32 dest_at = 0;
+		// NOTE: Used for linear scan when cache has no candidates
+		uint32 scan_at = 0;
+
+		while (best_triangle != INVALID_INDEX) {
+			emitted[best_triangle] = true;
+			const uint32* tri = indices + best_triangle * 3;
+			dest[dest_at++] = tri[0];
+			dest[dest_at++] = tri[1];
+			dest[dest_at++] = tri[2];
+
+			// NOTE: Emitted triangle vertices go to the front of LRU cache
+			uint32 new_count = 0;
+			for (uint32 k = 0; k < 3; k++) {
+				new_cache[new_count++] = tri[k];
+			}
+			for (uint32 i = 0; i < cache_count; i++) {
+				uint32 v = cache[i];
+				if (v != tri[0] && v != tri[1] && v != tri[2]) {
+					new_cache[new_count++] = v;
+				}
+			}
+
+			// NOTE: Removing emitted triangle from adjacency of its vertices
+			for (uint32 k = 0; k < 3; k++) {
+				uint32 v = tri[k];
+				uint32* list = adjacency + adjacency_offsets[v];
+				uint32 count = remaining[v];
+				for (uint32 i = 0; i < count; i++) {
+					if (list[i] == best_triangle) {
+						list[i] = list[count - 1];
+						break;
+					}
+				}
+				remaining[v]--;
+			}
+
+			for (uint32 i = 0; i < new_count; i++) {
+				uint32 v = new_cache[i];
+				cache_positions[v] = i < VCACHE_OPTIMIZER_SIZE ? (int32)i : -1;
+				vertex_scores[v] = ForsythVertexScore(cache_positions[v], remaining[v]);
+			}
+
+			cache_count = new_count < VCACHE_OPTIMIZER_SIZE ? new_count : VCACHE_OPTIMIZER_SIZE;
+			memcpy(cache, new_cache, cache_count * sizeof(uint32));
+
+			// NOTE: Only triangles touching cached vertices could change their score
+			best_triangle = INVALID_INDEX;
+			best_score = -1.0f;
+			for (uint32 i = 0; i < new_count; i++) {
+				uint32 v = new_cache[i];
+				uint32* list = adjacency + adjacency_offsets[v];
+				for (uint32 j = 0; j < remaining[v]; j++) {
+					uint32 t = list[j];
+					const uint32* candidate = indices + t * 3;
+					float32 score = vertex_scores[candidate[0]] + vertex_scores[candidate[1]] + vertex_scores[candidate[2]];
+					triangle_scores[t] = score;
+					if (score > best_score) {
+						best_score = score;
+						best_triangle = t;
+					}
+				}
+			}
+
+			if (best_triangle == INVALID_INDEX) {
+				// NOTE: Cache is dead end. Take next not emitted triangle.
+				// Forsyth suggests full rescan here, but first remaining triangle is good enough
+				while (scan_at < num_triangles && emitted[scan_at]) {
+					scan_at++;
+				}
+				if (scan_at < num_triangles) {
+					best_triangle = scan_at;
+				}
+			}
+		}
+
+		assert(dest_at == num_indices);
+
+		free(adjacency_offsets);
+		free(remaining);
+		free(adjacency);
+		free(cache_positions);
+		free(vertex_scores);
+		free(triangle_scores);
+		free(emitted);
+	}
+
+	struct _OverdrawCluster {
+		uint32 begin;
+		uint32 count;
+		float32 sort_key;
+	};
+
+	void OptimizeOverdraw(uint32* dest, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions, uint32 num_vertices, float32 threshold) {
+		assert(dest != indices);
+		uint32 num_triangles = num_indices / 3;
+		if (!num_triangles) {
+			return;
+		}
+
+		// NOTE: Clusters are split only at hard boundaries, where triangle misses all three vertices,
+		// so reordering clusters costs almost nothing in cache efficiency. Boundary is used only if
+		// cluster is not worse than threshold * mesh ACMR, otherwise it keeps growing
+		float32 target_acmr = AnalyzeVertexCache(indices, num_indices, num_vertices, VCACHE_ANALYZER_SIZE).acmr * threshold;
+		uint32* cache_timestamps = (uint32*)calloc(num_vertices, sizeof(uint32));
+		_OverdrawCluster* clusters = (_OverdrawCluster*)malloc(num_triangles * sizeof(_OverdrawCluster));
+		assert(cache_timestamps && clusters); // malloc failed
+		uint32 timestamp = VCACHE_ANALYZER_SIZE + 1;
+		uint32 num_clusters = 0;
+
+		uint32 cluster_begin = 0;
+		uint32 cluster_misses = 0;
+		for (uint32 t = 0; t < num_triangles; t++) {
+			uint32 misses = 0;
+			for (uint32 k = 0; k < 3; k++) {
+				uint32 v = indices[t * 3 + k];
+				if (timestamp - cache_timestamps[v] > VCACHE_ANALYZER_SIZE) {
+					cache_timestamps[v] = timestamp;
+					timestamp++;
+					misses++;
+				}
+			}
+			uint32 cluster_triangles = t - cluster_begin;
+			if (cluster_triangles && misses == 3) {
+				float32 acmr = (float32)cluster_misses / cluster_triangles;
+				if (acmr <= target_acmr) {
+					clusters[num_clusters++] = { cluster_begin, cluster_triangles, 0.0f };
+					cluster_begin = t;
+					cluster_misses = 0;
+				}
+			}
+			cluster_misses += misses;
+		}
+		clusters[num_clusters++] = { cluster_begin, num_triangles - cluster_begin, 0.0f };
+		free(cache_timestamps);
+
+		hpm::Vector3 mesh_center = {};
+		for (uint32 i = 0; i < num_indices; i++) {
+			mesh_center = hpm::Add(mesh_center, positions[indices[i]]);
+		}
+		mesh_center = hpm::Multiply(mesh_center, 1.0f / num_indices);
+
+		// NOTE: Sort key is how much cluster faces outwards from mesh center.
+		// Outer facing clusters occlude the rest, so they go first
+		for (uint32 c = 0; c < num_clusters; c++) {
+			hpm::Vector3 center = {};
+			hpm::Vector3 normal = {};
+			for (uint32 t = clusters[c].begin; t < clusters[c].begin + clusters[c].count; t++) {
+				hpm::Vector3 p0 = positions[indices[t * 3]];
+				hpm::Vector3 p1 = positions[indices[t * 3 + 1]];
+				hpm::Vector3 p2 = positions[indices[t * 3 + 2]];
+				// NOTE: Area weighted normal
+				hpm::Vector3 n = hpm::Cross(hpm::Subtract(p1, p0), hpm::Subtract(p2, p0));
+				normal = hpm::Add(normal, n);
+				center = hpm::Add(center, hpm::Add(hpm::Add(p0, p1), p2));
+			}
+			center = hpm::Multiply(center, 1.0f / (clusters[c].count * 3));
+			float32 normal_length = hpm::Length(normal);
+			if (normal_length > 0.0f) {
+				normal = hpm::Multiply(normal, 1.0f / normal_length);
+			}
+			clusters[c].sort_key = hpm::Dot(hpm::Subtract(center, mesh_center), normal);
+		}
+
+		// NOTE: Insertion sort. Stable, and cluster count is small
+		for (uint32 i = 1; i < num_clusters; i++) {
+			_OverdrawCluster cluster = clusters[i];
+			int32 j = (int32)i - 1;
+			while (j >= 0 && clusters[j].sort_key < cluster.sort_key) {
+				clusters[j + 1] = clusters[j];
+				j--;
+			}
+			clusters[j + 1] = cluster;
+		}
+
+		uint32 dest_at = 0;
+		for (uint32 c = 0; c < num_clusters; c++) {
+			memcpy(dest + dest_at, indices + clusters[c].begin * 3, clusters[c].count * 3 * sizeof(uint32));
+			dest_at += clusters[c].count * 3;
+		}
+		assert(dest_at == num_triangles * 3);
+
+		free(clusters);
+	}
+
+	uint32 OptimizeVertexFetchRemap(uint32* remap, uint32* indices, uint32 num_indices, uint32 num_vertices) {
+		for (uint32 v = 0; v < num_vertices; v++) {
+			remap[v] = INVALID_INDEX;
+		}
+		uint32 next_vertex = 0;
+		for (uint32 i = 0; i < num_indices; i++) {
+			uint32 index = indices[i];
+			if (remap[index] == INVALID_INDEX) {
+				remap[index] = next_vertex++;
+			}
+			indices[i] = remap[index];
+		}
+		return next_vertex;
+	}
+
+	void RemapVertexStream(void* dest, const void* src, uint32 num_vertices, uint64 stride, const uint32* remap) {
+		for (uint32 v = 0; v < num_vertices; v++) {
+			if (remap[v] != INVALID_INDEX) {
+				memcpy((byte*)dest + remap[v] * stride, (const byte*)src + v * stride, stride);
+			}
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace AB {
+	// Cache size used by Forsyth scoring
+	constexpr uint32 VCACHE_OPTIMIZER_SIZE = 32;
+	// FIFO cache size used for ACMR/ATVR statistics. Typical for desktop GPUs
+	constexpr uint32 VCACHE_ANALYZER_SIZE = 16;
+	// Cluster is split when its ACMR exceeds best possible one by this factor
+	constexpr float32 OVERDRAW_DEFAULT_THRESHOLD = 1.05f;
+
+	struct VertexCacheStats {
+		uint32 misses;
+		// Average cache miss ratio. Misses per triangle. 0.5 is the best, 3.0 is the worst
+		float32 acmr;
+		// Average transformed vertex ratio. Misses per vertex. 1.0 is the best
+		float32 atvr;
+	};
+
+	VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint32 num_indices, uint32 num_vertices, uint32 cache_size);
+
+	// Reorders triangles for post-transform vertex cache. Forsyth linear-speed algorithm.
+	// dest and indices must not overlap
+	void OptimizeVertexCache(uint32* dest, const uint32* indices, uint32 num_indices, uint32 num_vertices);
+
+	// Splits cache optimized index buffer into clusters and sorts them front to back
+	// relative to mesh center so outer facing clusters are drawn first.
+	// dest and indices must not overlap
+	void OptimizeOverdraw(uint32* dest, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions, uint32 num_vertices, float32 threshold);
+
+	// Fills remap table with new vertex indices in order of first use and rewrites index buffer.
+	// Returns number of referenced vertices. Unreferenced vertices get 0xffffffff
+	uint32 OptimizeVertexFetchRemap(uint32* remap, uint32* indices, uint32 num_indices, uint32 num_vertices);
+
+	// dest and src must not overlap
+	void RemapVertexStream(void* dest, const void* src, uint32 num_vertices, uint64 stride, const uint32* remap);
+}
@@ -0,0 +1,320 @@
+#include "MeshSimplifier.h"
+
+namespace AB {
+	static constexpr uint32 SIMPLIFIER_INVALID_INDEX = 0xffffffff;
+	static constexpr uint32 SIMPLIFIER_MAX_PASSES = 64;
+
+	enum SimplifierVertexKind : byte {
+		SIMPLIFIER_VERTEX_FREE = 0,
+		// Unique position on border or non-manifold edge. Can't move, but other vertices can collapse into it
+		SIMPLIFIER_VERTEX_BORDER,
+		// Shares position with other vertices. Can't move and can't be collapse target
+		SIMPLIFIER_VERTEX_SEAM
+	};
+
+	// NOTE: Quadric is Q(p) = p * A * p + 2 * b * p + c where A is symmetric.
+	// Plane quadrics are weighted by triangle area, weight is accumulated
+	// to get mean squared distance
+	struct Quadric {
+		float64 a00, a11, a22, a01, a02, a12;
+		float64 b0, b1, b2;
+		float64 c;
+		float64 weight;
+	};
+
+	struct CollapseCandidate {
+		uint32 source;
+		uint32 target;
+		float32 error;
+	};
+
+	static void QuadricAdd(Quadric* dest, const Quadric* q) {
+		dest->a00 += q->a00; dest->a11 += q->a11; dest->a22 += q->a22;
+		dest->a01 += q->a01; dest->a02 += q->a02; dest->a12 += q->a12;
+		dest->b0 += q->b0; dest->b1 += q->b1; dest->b2 += q->b2;
+		dest->c += q->c;
+		dest->weight += q->weight;
+	}
+
+	static float32 QuadricError(const Quadric* q, const Quadric* r, hpm::Vector3 p) {
+		float64 x = p.x, y = p.y, z = p.z;
+		float64 a00 = q->a00 + r->a00, a11 = q->a11 + r->a11, a22 = q->a22 + r->a22;
+		float64 a01 = q->a01 + r->a01, a02 = q->a02 + r->a02, a12 = q->a12 + r->a12;
+		float64 b0 = q->b0 + r->b0, b1 = q->b1 + r->b1, b2 = q->b2 + r->b2;
+		float64 value = a00 * x * x + a11 * y * y + a22 * z * z
+			+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z)
+			+ q->c + r->c;
+		float64 weight = q->weight + r->weight;
+		value = weight > 0.0 ? value / weight : 0.0;
+		return value > 0.0 ? (float32)sqrt(value) : 0.0f;
+	}
+
+	static hpm::Vector3 TriangleNormal(hpm::Vector3 a, hpm::Vector3 b, hpm::Vector3 c) {
+		return hpm::Cross(hpm::Subtract(b, a), hpm::Subtract(c, a));
+	}
+
+	static uint32 PositionHash(hpm::Vector3 p) {
+		uint32 bits[3];
+		memcpy(bits, p.data, sizeof(bits));
+		// NOTE: -0.0f and 0.0f should produce same hash
+		for (uint32 i = 0; i < 3; i++) {
+			if ((bits[i] << 1) == 0) bits[i] = 0;
+		}
+		return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+	}
+
+	// Maps every vertex to the first vertex with the same position
+	static void BuildPositionRemap(uint32* remap, const hpm::Vector3* positions, uint32 num_vertices) {
+		uint32 table_size = 1;
+		while (table_size < num_vertices * 2) {
+			table_size <<= 1;
+		}
+		uint32* table = (uint32*)malloc(table_size * sizeof(uint32));
+		assert(table); // malloc failed
+		memset(table, 0xff, table_size * sizeof(uint32));
+
+		for (uint32 i = 0; i < num_vertices; i++) {
+			uint32 slot = PositionHash(positions[i]) & (table_size - 1);
+			while (true) {
+				uint32 entry = table[slot];
+				if (entry == SIMPLIFIER_INVALID_INDEX) {
+					table[slot] = i;
+					remap[i] = i;
+					break;
+				}
+				hpm::Vector3 p = positions[entry];
+				if (p.x == positions[i].x && p.y == positions[i].y && p.z == positions[i].z) {
+					remap[i] = entry;
+					break;
+				}
+				slot = (slot + 1) & (table_size - 1);
+			}
+		}
+		free(table);
+	}
+
+	// NOTE: Edges which don't have exactly two triangles are borders
+	static void ClassifyVertices(byte* kinds, const uint32* position_remap, const uint32* indices, uint32 num_indices, uint32 num_vertices) {
+		for (uint32 i = 0; i < num_vertices; i++) {
+			if (position_remap[i] != i) {
+				kinds[i] = SIMPLIFIER_VERTEX_SEAM;
+				kinds[position_remap[i]] = SIMPLIFIER_VERTEX_SEAM;
+			}
+		}
+
+		std::vector<uint64> edges(num_indices);
+		for (uint32 i = 0; i < num_indices; i += 3) {
+			for (uint32 e = 0; e < 3; e++) {
+				uint32 a = position_remap[indices[i + e]];
+				uint32 b = position_remap[indices[i + (e + 1) % 3]];
+				uint64 lo = a < b ? a : b;
+				uint64 hi = a < b ? b : a;
+				edges[i + e] = (lo << 32) | hi;
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for (uint32 i = 0; i < num_indices;) {
+			uint32 run = 1;
+			while (i + run < num_indices && edges[i + run] == edges[i]) {
+				run++;
+			}
+			if (run != 2) {
+				uint32 a = (uint32)(edges[i] >> 32);
+				uint32 b = (uint32)(edges[i] & 0xffffffff);
+				if (kinds[a] == SIMPLIFIER_VERTEX_FREE) kinds[a] = SIMPLIFIER_VERTEX_BORDER;
+				if (kinds[b] == SIMPLIFIER_VERTEX_FREE) kinds[b] = SIMPLIFIER_VERTEX_BORDER;
+			}
+			i += run;
+		}
+	}
+
+	static void ComputeQuadrics(Quadric* quadrics, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions) {
+		for (uint32 i = 0; i < num_indices; i += 3) {
+			hpm::Vector3 p0 = positions[indices[i + 0]];
+			hpm::Vector3 normal = TriangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+			float32 length = hpm::Length(normal);
+			if (length <= 0.0f) {
+				continue;
+			}
+			float64 area = length * 0.5;
+			float64 nx = normal.x / length, ny = normal.y / length, nz = normal.z / length;
+			float64 d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+
+			Quadric q;
+			q.a00 = nx * nx * area; q.a11 = ny * ny * area; q.a22 = nz * nz * area;
+			q.a01 = nx * ny * area; q.a02 = nx * nz * area; q.a12 = ny * nz * area;
+			q.b0 = nx * d * area; q.b1 = ny * d * area; q.b2 = nz * d * area;
+			q.c = d * d * area;
+			q.weight = area;
+			for (uint32 k = 0; k < 3; k++) {
+				QuadricAdd(quadrics + indices[i + k], &q);
+			}
+		}
+	}
+
+	// NOTE: Collapse is rejected if any remaining triangle around source flips.
+	// Triangles which are already degenerate are skipped
+	static bool32 IsCollapseValid(uint32 source, uint32 target, const uint32* indices, const uint32* adjacency, uint32 adjacency_begin, uint32 adjacency_end, const hpm::Vector3* positions) {
+		for (uint32 a = adjacency_begin; a < adjacency_end; a++) {
+			const uint32* tri = indices + adjacency[a] * 3;
+			if (tri[0] == target || tri[1] == target || tri[2] == target) {
+				continue;
+			}
+			if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+				continue;
+			}
+			hpm::Vector3 p[3];
+			hpm::Vector3 moved[3];
+			for (uint32 k = 0; k < 3; k++) {
+				p[k] = positions[tri[k]];
+				moved[k] = tri[k] == source ? positions[target] : p[k];
+			}
+			hpm::Vector3 before = TriangleNormal(p[0], p[1], p[2]);
+			hpm::Vector3 after = TriangleNormal(moved[0], moved[1], moved[2]);
+			if (hpm::Dot(before, before) > 0.0f && hpm::Dot(before, after) <= 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	uint32 SimplifyMesh(uint32* dest, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions, uint32 num_vertices, uint32 target_index_count, float32 target_error, float32* result_error) {
+		*result_error = 0.0f;
+		if (!num_indices || !num_vertices) {
+			return 0;
+		}
+
+		uint32* position_remap = (uint32*)malloc(num_vertices * sizeof(uint32));
+		byte* kinds = (byte*)calloc(num_vertices, sizeof(byte));
+		bool32* touched = (bool32*)malloc(num_vertices * sizeof(bool32));
+		Quadric* quadrics = (Quadric*)calloc(num_vertices, sizeof(Quadric));
+		uint32* adjacency_offsets = (uint32*)malloc((num_vertices + 1) * sizeof(uint32));
+		uint32* adjacency = (uint32*)malloc(num_indices * sizeof(uint32));
+		assert(position_remap && kinds && touched && quadrics && adjacency_offsets && adjacency); // malloc failed
+
+		memcpy(dest, indices, num_indices * sizeof(uint32));
+		BuildPositionRemap(position_remap, positions, num_vertices);
+		ClassifyVertices(kinds, position_remap, dest, num_indices, num_vertices);
+		ComputeQuadrics(quadrics, dest, num_indices, positions);
+
+		std::vector<CollapseCandidate> candidates;
+		uint32 index_count = num_indices;
+		float32 max_error = 0.0f;
+
+		for (uint32 pass = 0; pass < SIMPLIFIER_MAX_PASSES && index_count > target_index_count; pass++) {
+			uint32 triangle_count = index_count / 3;
+
+			// NOTE: Vertex -> triangles adjacency for the current triangles
+			memset(adjacency_offsets, 0, (num_vertices + 1) * sizeof(uint32));
+			for (uint32 i = 0; i < index_count; i++) {
+				adjacency_offsets[dest[i] + 1]++;
+			}
+			for (uint32 i = 0; i < num_vertices; i++) {
+				adjacency_offsets[i + 1] += adjacency_offsets[i];
+			}
+			for (uint32 i = 0; i < index_count; i++) {
+				adjacency[adjacency_offsets[dest[i]]++] = i / 3;
+			}
+			for (uint32 i = num_vertices; i > 0; i--) {
+				adjacency_offsets[i] = adjacency_offsets[i - 1];
+			}
+			adjacency_offsets[0] = 0;
+
+			// NOTE: Every edge gets its cheapest direction. Free vertices and targets have unique position,
+			// so replacing source index with target never changes attributes of other triangles
+			candidates.clear();
+			for (uint32 i = 0; i < index_count; i += 3) {
+				for (uint32 e = 0; e < 3; e++) {
+					uint32 a = dest[i + e];
+					uint32 b = dest[i + (e + 1) % 3];
+					// NOTE: Edges of free vertices always have two triangles, taking them once
+					if (position_remap[a] > position_remap[b]) {
+						continue;
+					}
+					bool32 a_to_b = kinds[a] == SIMPLIFIER_VERTEX_FREE && kinds[b] != SIMPLIFIER_VERTEX_SEAM;
+					bool32 b_to_a = kinds[b] == SIMPLIFIER_VERTEX_FREE && kinds[a] != SIMPLIFIER_VERTEX_SEAM;
+					float32 a_error = a_to_b ? QuadricError(quadrics + a, quadrics + b, positions[b]) : FLT_MAX;
+					float32 b_error = b_to_a ? QuadricError(quadrics + a, quadrics + b, positions[a]) : FLT_MAX;
+					if (a_to_b || b_to_a) {
+						if (a_error <= b_error) {
+							candidates.push_back({ a, b, a_error });
+						} else {
+							candidates.push_back({ b, a, b_error });
+						}
+					}
+				}
+			}
+			std::sort(candidates.begin(), candidates.end(), [](const CollapseCandidate& l, const CollapseCandidate& r) { return l.error < r.error; });
+
+			// NOTE: Vertices are collapsed at most once per pass, so costs stay valid
+			memset(touched, 0, num_vertices * sizeof(bool32));
+			uint32 collapses = 0;
+			for (uint32 c = 0; c < candidates.size() && triangle_count * 3 > target_index_count; c++) {
+				CollapseCandidate* candidate = &candidates[c];
+				if (candidate->error > target_error) {
+					break;
+				}
+				uint32 source = candidate->source;
+				uint32 target = candidate->target;
+				if (touched[source] || touched[target]) {
+					continue;
+				}
+				uint32 adjacency_begin = adjacency_offsets[source];
+				uint32 adjacency_end = adjacency_offsets[source + 1];
+				if (!IsCollapseValid(source, target, dest, adjacency, adjacency_begin, adjacency_end, positions)) {
+					continue;
+				}
+
+				QuadricAdd(quadrics + target, quadrics + source);
+				for (uint32 a = adjacency_begin; a < adjacency_end; a++) {
+					uint32* tri = dest + adjacency[a] * 3;
+					bool32 alive = tri[0] != tri[1] && tri[1] != tri[2] && tri[0] != tri[2];
+					for (uint32 k = 0; k < 3; k++) {
+						if (tri[k] == source) tri[k] = target;
+					}
+					if (alive && (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])) {
+						triangle_count--;
+					}
+				}
+				// NOTE: Target adjacency is stale until the next pass
+				touched[source] = true;
+				touched[target] = true;
+				if (candidate->error > max_error) {
+					max_error = candidate->error;
+				}
+				collapses++;
+			}
+
+			// NOTE: Removing degenerate triangles
+			uint32 write = 0;
+			for (uint32 i = 0; i < index_count; i += 3) {
+				uint32 p0 = position_remap[dest[i + 0]];
+				uint32 p1 = position_remap[dest[i + 1]];
+				uint32 p2 = position_remap[dest[i + 2]];
+				if (p0 != p1 && p1 != p2 && p0 != p2) {
+					dest[write + 0] = dest[i + 0];
+					dest[write + 1] = dest[i + 1];
+					dest[write + 2] = dest[i + 2];
+					write += 3;
+				}
+			}
+			index_count = write;
+
+			if (!collapses) {
+				break;
+			}
+		}
+
+		free(position_remap);
+		free(kinds);
+		free(touched);
+		free(quadrics);
+		free(adjacency_offsets);
+		free(adjacency);
+
+		*result_error = max_error;
+		return index_count;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace AB {
+	// Simplifies triangle list with quadric error metric edge collapses (Garland-Heckbert).
+	// Edges collapse into one of their end points, so result references subset of input vertices
+	// and shares vertex buffer with the source mesh. Vertices on borders, non-manifold edges
+	// and attribute seams (several vertices at the same position) are never removed.
+	// Stops when index count reaches target_index_count or no collapse has error below target_error.
+	// result_error receives the largest error of performed collapses: root mean square distance
+	// from collapsed vertex to the planes of original triangles around it, in mesh units.
+	// Returns number of indices written to dest. dest should have space for num_indices
+	uint32 SimplifyMesh(uint32* dest, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions, uint32 num_vertices, uint32 target_index_count, float32 target_error, float32* result_error);
+}
@@ -0,0 +1,220 @@
+#include "MeshletBuilder.h"
+
+namespace AB {
+	static constexpr uint32 MESHLET_INVALID_INDEX = 0xffffffff;
+	// Normal cone is not stored if triangles deviate from the axis by more than acos of this value
+	static constexpr float32 MESHLET_MIN_CONE_DOT = 0.1f;
+	// Spatial term of candidate score reaches one half at squared distance equal to this number of average triangle areas
+	static constexpr float32 MESHLET_SPREAD_TRIANGLES = 16.0f;
+
+	struct MeshletCandidate {
+		uint32 triangle;
+		uint32 new_vertices;
+		float32 score;
+	};
+
+	// NOTE: Triangles are removed from adjacency of their vertices when emitted,
+	// so only the first live_counts[v] entries of vertex adjacency are valid
+	struct MeshletAdjacency {
+		uint32* offsets;
+		uint32* live_counts;
+		uint32* triangles;
+	};
+
+	static void MeshletAdjacencyRemove(MeshletAdjacency* adjacency, uint32 vertex, uint32 triangle) {
+		uint32* list = adjacency->triangles + adjacency->offsets[vertex];
+		uint32 count = adjacency->live_counts[vertex];
+		for (uint32 i = 0; i < count; i++) {
+			if (list[i] == triangle) {
+				list[i] = list[count - 1];
+				adjacency->live_counts[vertex]--;
+				break;
+			}
+		}
+	}
+
+	// NOTE: Sphere is centered at AABB center of meshlet vertices.
+	// Cone axis is the average of unit triangle normals, degenerate triangles are ignored
+	static AABMeshlet ComputeMeshletBounds(const uint32* meshlet_indices, uint32 num_indices, const hpm::Vector3* positions, const hpm::Vector3* triangle_normals, const uint32* meshlet_triangles) {
+		AABMeshlet meshlet = {};
+		meshlet.indices_count = num_indices;
+
+		hpm::Vector3 min = positions[meshlet_indices[0]];
+		hpm::Vector3 max = min;
+		for (uint32 i = 1; i < num_indices; i++) {
+			hpm::Vector3 p = positions[meshlet_indices[i]];
+			for (uint32 c = 0; c < 3; c++) {
+				if (p.data[c] < min.data[c]) min.data[c] = p.data[c];
+				if (p.data[c] > max.data[c]) max.data[c] = p.data[c];
+			}
+		}
+		meshlet.center = hpm::Multiply(hpm::Add(min, max), 0.5f);
+		float32 radius_sq = 0.0f;
+		for (uint32 i = 0; i < num_indices; i++) {
+			hpm::Vector3 d = hpm::Subtract(positions[meshlet_indices[i]], meshlet.center);
+			float32 dist_sq = hpm::Dot(d, d);
+			radius_sq = dist_sq > radius_sq ? dist_sq : radius_sq;
+		}
+		meshlet.radius = sqrtf(radius_sq);
+
+		uint32 num_triangles = num_indices / 3;
+		hpm::Vector3 normal_sum = {};
+		for (uint32 i = 0; i < num_triangles; i++) {
+			normal_sum = hpm::Add(normal_sum, triangle_normals[meshlet_triangles[i]]);
+		}
+		float32 length = hpm::Length(normal_sum);
+		float32 min_dot = -1.0f;
+		if (length > 1e-6f) {
+			meshlet.cone_axis = hpm::Multiply(normal_sum, 1.0f / length);
+			min_dot = 1.0f;
+			for (uint32 i = 0; i < num_triangles; i++) {
+				hpm::Vector3 n = triangle_normals[meshlet_triangles[i]];
+				if (n.x != 0.0f || n.y != 0.0f || n.z != 0.0f) {
+					float32 dot = hpm::Dot(n, meshlet.cone_axis);
+					min_dot = dot < min_dot ? dot : min_dot;
+				}
+			}
+		}
+		if (min_dot <= MESHLET_MIN_CONE_DOT) {
+			meshlet.cone_cutoff = 1.0f;
+		} else {
+			// NOTE: Cone of view directions which see only back faces is the normal cone
+			// widened by 90 degrees on each side and inverted, so its cutoff is sin of the normal cone angle
+			meshlet.cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+		}
+		return meshlet;
+	}
+
+	uint32 BuildMeshlets(AABMeshlet* meshlets, uint32* dest, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions, uint32 num_vertices, uint32 max_vertices, uint32 max_triangles) {
+		assert(max_vertices >= 3 && max_vertices <= AAB_MESHLET_MAX_VERTICES);
+		assert(max_triangles >= 1 && max_triangles <= AAB_MESHLET_MAX_TRIANGLES);
+		uint32 num_triangles = num_indices / 3;
+		if (!num_triangles) {
+			return 0;
+		}
+
+		MeshletAdjacency adjacency;
+		adjacency.offsets = (uint32*)calloc(num_vertices + 1, sizeof(uint32));
+		adjacency.live_counts = (uint32*)calloc(num_vertices, sizeof(uint32));
+		adjacency.triangles = (uint32*)malloc(num_triangles * 3 * sizeof(uint32));
+		uint32* vertex_meshlet = (uint32*)malloc(num_vertices * sizeof(uint32));
+		byte* emitted = (byte*)calloc(num_triangles, sizeof(byte));
+		hpm::Vector3* triangle_normals = (hpm::Vector3*)malloc(num_triangles * sizeof(hpm::Vector3));
+		hpm::Vector3* triangle_centroids = (hpm::Vector3*)malloc(num_triangles * sizeof(hpm::Vector3));
+		assert(adjacency.offsets && adjacency.live_counts && adjacency.triangles && vertex_meshlet && emitted && triangle_normals && triangle_centroids); // malloc failed
+		memset(vertex_meshlet, 0xff, num_vertices * sizeof(uint32));
+
+		for (uint32 i = 0; i < num_triangles * 3; i++) {
+			adjacency.offsets[indices[i] + 1]++;
+		}
+		for (uint32 i = 0; i < num_vertices; i++) {
+			adjacency.offsets[i + 1] += adjacency.offsets[i];
+		}
+		for (uint32 i = 0; i < num_triangles * 3; i++) {
+			uint32 v = indices[i];
+			adjacency.triangles[adjacency.offsets[v] + adjacency.live_counts[v]++] = i / 3;
+		}
+
+		float64 area_sum = 0.0;
+		for (uint32 i = 0; i < num_triangles; i++) {
+			hpm::Vector3 a = positions[indices[i * 3 + 0]];
+			hpm::Vector3 b = positions[indices[i * 3 + 1]];
+			hpm::Vector3 c = positions[indices[i * 3 + 2]];
+			hpm::Vector3 n = hpm::Cross(hpm::Subtract(b, a), hpm::Subtract(c, a));
+			float32 length = hpm::Length(n);
+			triangle_normals[i] = length > 0.0f ? hpm::Multiply(n, 1.0f / length) : hpm::Vector3{};
+			area_sum += length * 0.5f;
+			triangle_centroids[i] = hpm::Multiply(hpm::Add(hpm::Add(a, b), c), 1.0f / 3.0f);
+		}
+
+		float32 spread_scale = (float32)(area_sum / num_triangles) * MESHLET_SPREAD_TRIANGLES;
+		spread_scale = spread_scale > 0.0f ? spread_scale : 1.0f;
+
+		uint32 meshlet_vertices[AAB_MESHLET_MAX_VERTICES];
+		uint32 meshlet_triangles[AAB_MESHLET_MAX_TRIANGLES];
+		uint32 meshlet_count = 0;
+		uint32 written = 0;
+		uint32 seed = 0;
+
+		while (written < num_triangles * 3) {
+			while (emitted[seed]) {
+				seed++;
+			}
+
+			uint32 begin = written;
+			uint32 vertex_count = 0;
+			uint32 triangle_count = 0;
+			hpm::Vector3 centroid_sum = {};
+			hpm::Vector3 normal_sum = {};
+			uint32 triangle = seed;
+
+			while (triangle != MESHLET_INVALID_INDEX) {
+				const uint32* tri = indices + triangle * 3;
+				for (uint32 k = 0; k < 3; k++) {
+					uint32 v = tri[k];
+					if (vertex_meshlet[v] != meshlet_count) {
+						vertex_meshlet[v] = meshlet_count;
+						meshlet_vertices[vertex_count++] = v;
+					}
+					dest[written++] = v;
+					MeshletAdjacencyRemove(&adjacency, v, triangle);
+				}
+				emitted[triangle] = 1;
+				meshlet_triangles[triangle_count++] = triangle;
+				centroid_sum = hpm::Add(centroid_sum, triangle_centroids[triangle]);
+				normal_sum = hpm::Add(normal_sum, triangle_normals[triangle]);
+
+				if (triangle_count == max_triangles) {
+					break;
+				}
+
+				// NOTE: Candidates are live triangles which share at least one vertex with the meshlet.
+				// Fewer new vertices wins, then score
+				hpm::Vector3 centroid = hpm::Multiply(centroid_sum, 1.0f / (float32)triangle_count);
+				float32 normal_length = hpm::Length(normal_sum);
+				hpm::Vector3 normal = normal_length > 0.0f ? hpm::Multiply(normal_sum, 1.0f / normal_length) : hpm::Vector3{};
+				MeshletCandidate best = { MESHLET_INVALID_INDEX, 4, FLT_MAX };
+				for (uint32 i = 0; i < vertex_count; i++) {
+					uint32 v = meshlet_vertices[i];
+					const uint32* list = adjacency.triangles + adjacency.offsets[v];
+					for (uint32 t = 0; t < adjacency.live_counts[v]; t++) {
+						uint32 candidate = list[t];
+						const uint32* ctri = indices + candidate * 3;
+						uint32 new_vertices = (vertex_meshlet[ctri[0]] != meshlet_count)
+							+ (vertex_meshlet[ctri[1]] != meshlet_count && ctri[1] != ctri[0])
+							+ (vertex_meshlet[ctri[2]] != meshlet_count && ctri[2] != ctri[0] && ctri[2] != ctri[1]);
+						if (vertex_count + new_vertices > max_vertices || new_vertices > best.new_vertices) {
+							continue;
+						}
+						// NOTE: Integer part is the number of live triangles around candidate vertices. Picking triangles
+						// which finish off vertices keeps meshlet boundary short, so meshlets get more triangles per vertex.
+						// Spatial term is mapped to [0, 1) and only breaks ties
+						hpm::Vector3 d = hpm::Subtract(triangle_centroids[candidate], centroid);
+						float32 spread = hpm::Dot(d, d) * (2.0f - hpm::Dot(triangle_normals[candidate], normal));
+						uint32 live = adjacency.live_counts[ctri[0]] + adjacency.live_counts[ctri[1]] + adjacency.live_counts[ctri[2]];
+						float32 score = (float32)live + spread / (spread + spread_scale);
+						if (new_vertices < best.new_vertices || score < best.score) {
+							best = { candidate, new_vertices, score };
+						}
+					}
+				}
+				triangle = best.triangle;
+			}
+
+			AABMeshlet* meshlet = meshlets + meshlet_count;
+			*meshlet = ComputeMeshletBounds(dest + begin, written - begin, positions, triangle_normals, meshlet_triangles);
+			meshlet->indices_offset = begin;
+			meshlet_count++;
+		}
+
+		free(adjacency.offsets);
+		free(adjacency.live_counts);
+		free(adjacency.triangles);
+		free(vertex_meshlet);
+		free(emitted);
+		free(triangle_normals);
+		free(triangle_centroids);
+
+		return meshlet_count;
+	}
+}
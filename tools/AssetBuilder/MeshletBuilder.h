@@ -0,0 +1,11 @@
+#pragma once
+
+namespace AB {
+	// Splits triangle list into meshlets (see AABMeshlet in FileFormats.h).
+	// Meshlets are grown greedily over shared vertices, preferring triangles which add fewer vertices
+	// and which are close to the meshlet both in position and orientation, so clusters stay compact for culling.
+	// Triangles are written to dest reordered so every meshlet is contiguous range.
+	// Meshlet indices_offset is relative to dest. dest should have space for num_indices.
+	// meshlets should have space for num_indices / 3 entries. Returns number of meshlets
+	uint32 BuildMeshlets(AABMeshlet* meshlets, uint32* dest, const uint32* indices, uint32 num_indices, const hpm::Vector3* positions, uint32 num_vertices, uint32 max_vertices, uint32 max_triangles);
+}
@@ -0,0 +1,360 @@
+#include "NumberParser.h"
+
+#include <locale.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AB_NUMBER_PARSER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace AB {
+	// NOTE: Eisel-Lemire. 5^q is stored as 128 bit value truncated to its highest bits, 2^q goes to the exponent.
+	// Product of it and normalized mantissa of at most 19 digits always has enough bits
+	// to round to float32 correctly (Mushtak, Lemire), so there is no fallback for such numbers.
+	// Only integer arithmetic is used, so result does not depend on -ffast-math or /fp:fast.
+	// Longer mantissas, inf and nan fall back to strtof with "C" locale
+	// NOTE: Any mantissa times 10^-66 rounds to zero, 10^39 overflows
+	static constexpr int32 NUMBER_PARSER_MIN_POW10 = -65;
+	static constexpr int32 NUMBER_PARSER_MAX_POW10 = 38;
+	static const uint64 NUMBER_PARSER_POW5_128[NUMBER_PARSER_MAX_POW10 - NUMBER_PARSER_MIN_POW10 + 1][2] = {
+		{ 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull }, { 0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull },
+		{ 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull }, { 0x83a3eeeef9153e89ull, 0x1953cf68300424acull },
+		{ 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull }, { 0xcdb02555653131b6ull, 0x3792f412cb06794dull },
+		{ 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull }, { 0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull },
+		{ 0xc8de047564d20a8bull, 0xf245825a5a445275ull }, { 0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull },
+		{ 0x9ced737bb6c4183dull, 0x55464dd69685606bull }, { 0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull },
+		{ 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull }, { 0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull },
+		{ 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull }, { 0xef73d256a5c0f77cull, 0x963e66858f6d4440ull },
+		{ 0x95a8637627989aadull, 0xdde7001379a44aa8ull }, { 0xbb127c53b17ec159ull, 0x5560c018580d5d52ull },
+		{ 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull }, { 0x9226712162ab070dull, 0xcab3961304ca70e8ull },
+		{ 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull }, { 0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull },
+		{ 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull }, { 0xb267ed1940f1c61cull, 0x55f038b237591ed3ull },
+		{ 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull }, { 0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull },
+		{ 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull }, { 0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull },
+		{ 0x881cea14545c7575ull, 0x7e50d64177da2e54ull }, { 0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull },
+		{ 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull }, { 0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull },
+		{ 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull }, { 0xcfb11ead453994baull, 0x67de18eda5814af2ull },
+		{ 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull }, { 0xa2425ff75e14fc31ull, 0xa1258379a94d028dull },
+		{ 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull }, { 0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull },
+		{ 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull }, { 0xc612062576589ddaull, 0x95364afe032a819eull },
+		{ 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull }, { 0x9abe14cd44753b52ull, 0xc4926a9672793543ull },
+		{ 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull }, { 0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull },
+		{ 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull }, { 0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull },
+		{ 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull }, { 0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull },
+		{ 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull }, { 0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull },
+		{ 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull }, { 0xb424dc35095cd80full, 0x538484c19ef38c95ull },
+		{ 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull }, { 0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull },
+		{ 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull }, { 0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull },
+		{ 0x89705f4136b4a597ull, 0x31680a88f8953031ull }, { 0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull },
+		{ 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull }, { 0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull },
+		{ 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull }, { 0xd1b71758e219652bull, 0xd3c36113404ea4a9ull },
+		{ 0x83126e978d4fdf3bull, 0x645a1cac083126eaull }, { 0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull },
+		{ 0xccccccccccccccccull, 0xcccccccccccccccdull }, { 0x8000000000000000ull, 0x0000000000000000ull },
+		{ 0xa000000000000000ull, 0x0000000000000000ull }, { 0xc800000000000000ull, 0x0000000000000000ull },
+		{ 0xfa00000000000000ull, 0x0000000000000000ull }, { 0x9c40000000000000ull, 0x0000000000000000ull },
+		{ 0xc350000000000000ull, 0x0000000000000000ull }, { 0xf424000000000000ull, 0x0000000000000000ull },
+		{ 0x9896800000000000ull, 0x0000000000000000ull }, { 0xbebc200000000000ull, 0x0000000000000000ull },
+		{ 0xee6b280000000000ull, 0x0000000000000000ull }, { 0x9502f90000000000ull, 0x0000000000000000ull },
+		{ 0xba43b74000000000ull, 0x0000000000000000ull }, { 0xe8d4a51000000000ull, 0x0000000000000000ull },
+		{ 0x9184e72a00000000ull, 0x0000000000000000ull }, { 0xb5e620f480000000ull, 0x0000000000000000ull },
+		{ 0xe35fa931a0000000ull, 0x0000000000000000ull }, { 0x8e1bc9bf04000000ull, 0x0000000000000000ull },
+		{ 0xb1a2bc2ec5000000ull, 0x0000000000000000ull }, { 0xde0b6b3a76400000ull, 0x0000000000000000ull },
+		{ 0x8ac7230489e80000ull, 0x0000000000000000ull }, { 0xad78ebc5ac620000ull, 0x0000000000000000ull },
+		{ 0xd8d726b7177a8000ull, 0x0000000000000000ull }, { 0x878678326eac9000ull, 0x0000000000000000ull },
+		{ 0xa968163f0a57b400ull, 0x0000000000000000ull }, { 0xd3c21bcecceda100ull, 0x0000000000000000ull },
+		{ 0x84595161401484a0ull, 0x0000000000000000ull }, { 0xa56fa5b99019a5c8ull, 0x0000000000000000ull },
+		{ 0xcecb8f27f4200f3aull, 0x0000000000000000ull }, { 0x813f3978f8940984ull, 0x4000000000000000ull },
+		{ 0xa18f07d736b90be5ull, 0x5000000000000000ull }, { 0xc9f2c9cd04674edeull, 0xa400000000000000ull },
+		{ 0xfc6f7c4045812296ull, 0x4d00000000000000ull }, { 0x9dc5ada82b70b59dull, 0xf020000000000000ull },
+		{ 0xc5371912364ce305ull, 0x6c28000000000000ull }, { 0xf684df56c3e01bc6ull, 0xc732000000000000ull },
+		{ 0x9a130b963a6c115cull, 0x3c7f400000000000ull }, { 0xc097ce7bc90715b3ull, 0x4b9f100000000000ull },
+		{ 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull }, { 0x96769950b50d88f4ull, 0x1314448000000000ull },
+	};
+	static constexpr uint32 FLOAT32_MANTISSA_BITS = 23;
+	static constexpr uint32 FLOAT32_EXPONENT_BIAS = 127;
+	static constexpr uint32 FLOAT32_INFINITE_EXPONENT = 0xff;
+	// Any 19 digit number fits in uint64
+	static constexpr uint32 NUMBER_PARSER_MAX_DIGITS = 19;
+
+	static const uint32 NUMBER_PARSER_POW10_U32[] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+	};
+
+	inline static bool32 IsNumberSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	inline static bool32 IsDecimalDigit(char c) {
+		return (uint32)(c - '0') < 10;
+	}
+
+	inline static uint32 CountTrailingZeros32(uint32 value) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return (uint32)index;
+#else
+		return (uint32)__builtin_ctz(value);
+#endif
+	}
+
+	inline static uint32 CountLeadingZeros64(uint64 value) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return 63 - (uint32)index;
+#else
+		return (uint32)__builtin_clzll(value);
+#endif
+	}
+
+	// Returns high 64 bits of the product
+	inline static uint64 Multiply128(uint64 a, uint64 b, uint64* low) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		uint64 high;
+		*low = _umul128(a, b, &high);
+		return high;
+#else
+		unsigned __int128 product = (unsigned __int128)a * b;
+		*low = (uint64)product;
+		return (uint64)(product >> 64);
+#endif
+	}
+
+	// Returns length of decimal digit run starting at at
+	inline static uint32 CountDigits(const char* at) {
+#if defined(AB_NUMBER_PARSER_SSE2)
+		uint32 count = 0;
+		while (true) {
+			__m128i chars = _mm_loadu_si128((const __m128i*)(at + count));
+			// NOTE: Signed compare. Bytes above 0x7f are negative so they never pass
+			__m128i above = _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1));
+			__m128i below = _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1));
+			uint32 mask = (uint32)_mm_movemask_epi8(_mm_and_si128(above, below));
+			if (mask != 0xffff) {
+				return count + CountTrailingZeros32(~mask);
+			}
+			count += 16;
+		}
+#else
+		uint32 count = 0;
+		while (IsDecimalDigit(at[count])) count++;
+		return count;
+#endif
+	}
+
+	// NOTE: SWAR conversion of 8 ascii digits. First digit is most significant
+	inline static uint32 ParseEightDigits(uint64 value) {
+		value -= 0x3030303030303030ull;
+		value = (value * 10) + (value >> 8);
+		value = (((value & 0x000000ff000000ffull) * (100 + (1000000ull << 32))) +
+			(((value >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >> 32;
+		return (uint32)value;
+	}
+
+	// count is in [1, 8]
+	inline static uint32 ParseShortDigits(const char* at, uint32 count) {
+		uint64 value;
+		memcpy(&value, at, sizeof(uint64));
+		if (count < 8) {
+			// NOTE: Moving digits to the end and filling the front with '0'
+			uint32 shift = 8 * (8 - count);
+			value = (value << shift) | (0x3030303030303030ull >> (64 - shift));
+		}
+		return ParseEightDigits(value);
+	}
+
+	inline static uint64 AccumulateDigits(uint64 value, const char* at, uint32 count) {
+		while (count >= 8) {
+			uint64 chunk;
+			memcpy(&chunk, at, sizeof(uint64));
+			value = value * 100000000ull + ParseEightDigits(chunk);
+			at += 8;
+			count -= 8;
+		}
+		if (count) {
+			value = value * NUMBER_PARSER_POW10_U32[count] + ParseShortDigits(at, count);
+		}
+		return value;
+	}
+
+	static float32 ParseFloat32Fallback(const char* at, char** end) {
+#if defined(AB_PLATFORM_WINDOWS)
+		static _locale_t c_locale = _create_locale(LC_NUMERIC, "C");
+		return _strtof_l(at, end, c_locale);
+#elif defined(AB_PLATFORM_LINUX)
+		static locale_t c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+		return strtof_l(at, end, c_locale);
+#else
+#error Unsupported platform.
+#endif
+	}
+
+	// Returns bits of mantissa * 10^exponent correctly rounded to float32. mantissa is not zero
+	static uint32 ComputeFloat32Bits(uint64 mantissa, int32 exponent) {
+		if (exponent < NUMBER_PARSER_MIN_POW10) {
+			return 0;
+		}
+		if (exponent > NUMBER_PARSER_MAX_POW10) {
+			return FLOAT32_INFINITE_EXPONENT << FLOAT32_MANTISSA_BITS;
+		}
+
+		uint32 leading_zeros = CountLeadingZeros64(mantissa);
+		uint64 w = mantissa << leading_zeros;
+		const uint64* pow5 = NUMBER_PARSER_POW5_128[exponent - NUMBER_PARSER_MIN_POW10];
+		uint64 low;
+		uint64 high = Multiply128(w, pow5[0], &low);
+		// NOTE: Low half of 5^q matters only if the bits below mantissa, round and guard bits are all ones
+		constexpr uint64 precision_mask = 0xffffffffffffffffull >> (FLOAT32_MANTISSA_BITS + 3);
+		if ((high & precision_mask) == precision_mask) {
+			uint64 second_low;
+			uint64 second_high = Multiply128(w, pow5[1], &second_low);
+			low += second_high;
+			if (second_high > low) {
+				high++;
+			}
+		}
+
+		uint32 upper_bit = (uint32)(high >> 63);
+		uint32 shift = upper_bit + 64 - FLOAT32_MANTISSA_BITS - 3;
+		uint64 bits = high >> shift;
+		// NOTE: floor(log2(10^q)) + 63 is exact for the table range
+		int32 power2 = (((152170 + 65536) * exponent) >> 16) + 63 + (int32)upper_bit - (int32)leading_zeros + (int32)FLOAT32_EXPONENT_BIAS;
+
+		if (power2 <= 0) {
+			// NOTE: Subnormal. Rounding up may carry into the exponent giving the smallest normal, bits are still right
+			if (-power2 + 1 >= 64) {
+				return 0;
+			}
+			bits >>= -power2 + 1;
+			bits += bits & 1;
+			bits >>= 1;
+			return (uint32)bits;
+		}
+
+		// NOTE: Product is exact only for small powers. Exact tie is rounded to even instead of up
+		if (low <= 1 && exponent >= -17 && exponent <= 10 && (bits & 3) == 1 && (bits << shift) == high) {
+			bits &= ~1ull;
+		}
+		bits += bits & 1;
+		bits >>= 1;
+		if (bits >= (2ull << FLOAT32_MANTISSA_BITS)) {
+			bits = 1ull << FLOAT32_MANTISSA_BITS;
+			power2++;
+		}
+		bits &= ~(1ull << FLOAT32_MANTISSA_BITS);
+		if (power2 >= (int32)FLOAT32_INFINITE_EXPONENT) {
+			return FLOAT32_INFINITE_EXPONENT << FLOAT32_MANTISSA_BITS;
+		}
+		return (uint32)bits | ((uint32)power2 << FLOAT32_MANTISSA_BITS);
+	}
+
+	float32 ParseFloat32(const char* at, char** end) {
+		const char* begin = at;
+		while (IsNumberSpace(*at)) at++;
+		const char* number_begin = at;
+
+		bool32 negative = false;
+		if (*at == '-' || *at == '+') {
+			negative = *at == '-';
+			at++;
+		}
+
+		const char* int_digits = at;
+		uint32 int_count = CountDigits(at);
+		at += int_count;
+
+		const char* frac_digits = at;
+		uint32 frac_count = 0;
+		if (*at == '.') {
+			frac_digits = at + 1;
+			frac_count = CountDigits(frac_digits);
+			at = frac_digits + frac_count;
+		}
+
+		if (!int_count && !frac_count) {
+			// NOTE: inf, nan or not a number at all
+			float32 result = ParseFloat32Fallback(number_begin, end);
+			if (*end == number_begin) {
+				*end = (char*)begin;
+			}
+			return result;
+		}
+
+		int32 exponent = 0;
+		if (*at == 'e' || *at == 'E') {
+			const char* exp_at = at + 1;
+			bool32 exp_negative = false;
+			if (*exp_at == '-' || *exp_at == '+') {
+				exp_negative = *exp_at == '-';
+				exp_at++;
+			}
+			if (IsDecimalDigit(*exp_at)) {
+				while (IsDecimalDigit(*exp_at)) {
+					// NOTE: Clamping. Anything that large goes to the fallback anyway
+					if (exponent < 100000) {
+						exponent = exponent * 10 + (*exp_at - '0');
+					}
+					exp_at++;
+				}
+				exponent = exp_negative ? -exponent : exponent;
+				at = exp_at;
+			}
+		}
+
+		if (int_count + frac_count > NUMBER_PARSER_MAX_DIGITS) {
+			return ParseFloat32Fallback(number_begin, end);
+		}
+
+		uint64 mantissa = AccumulateDigits(0, int_digits, int_count);
+		mantissa = AccumulateDigits(mantissa, frac_digits, frac_count);
+		exponent -= (int32)frac_count;
+
+		uint32 bits = mantissa ? ComputeFloat32Bits(mantissa, exponent) : 0;
+		if (negative) {
+			bits |= 0x80000000;
+		}
+		float32 result;
+		memcpy(&result, &bits, sizeof(float32));
+
+		*end = (char*)at;
+		return result;
+	}
+
+	uint32 ParseUInt32(const char* at, char** end) {
+		const char* begin = at;
+		while (IsNumberSpace(*at)) at++;
+		if (*at == '+') {
+			at++;
+		}
+
+		uint32 count = CountDigits(at);
+		if (!count) {
+			*end = (char*)begin;
+			return 0;
+		}
+
+		uint64 result;
+		if (count <= 8) {
+			result = ParseShortDigits(at, count);
+		} else if (count <= 10) {
+			result = AccumulateDigits(0, at, count);
+		} else {
+			// NOTE: Skipping leading zeros, the rest overflows if still longer than 10
+			const char* digits = at;
+			uint32 digits_count = count;
+			while (digits_count > 10 && *digits == '0') {
+				digits++;
+				digits_count--;
+			}
+			result = digits_count <= 10 ? AccumulateDigits(0, digits, digits_count) : 0xffffffffull + 1;
+		}
+
+		*end = (char*)(at + count);
+		return result > 0xffffffffull ? 0xffffffff : (uint32)result;
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace AB {
+	// Parsers read numbers in 16 byte blocks. Input must have that many readable bytes after the number.
+	// ReadEntireFileAsText pads file data for this
+	constexpr uint32 NUMBER_PARSER_PADDING = 16;
+
+	// Locale independent replacement for strtof. Leading whitespace is skipped.
+	// end is set to at if there is no number. Result is correctly rounded
+	float32 ParseFloat32(const char* at, char** end);
+
+	// Locale independent replacement for strtoul(at, end, 10). Leading whitespace is skipped.
+	// end is set to at if there is no number. Saturates to 0xffffffff on overflow
+	uint32 ParseUInt32(const char* at, char** end);
+}
@@ -1,12 +1,16 @@
 #include "OBJLoader.h"
 #include "Utils.cpp"
+#include "NumberParser.cpp"
+
+#include <thread>
 
 #if defined(AB_PLATFORM_LINUX)
 #include <cctype>
 #endif
 
 namespace AB {
-	
+	static_assert(TEXT_FILE_PADDING >= NUMBER_PARSER_PADDING, "File data is not padded enough for number parser");
+
 	struct ParseVertexRet {
 		hpm::Vector3 v;
 		char* next;
@@ -14,13 +18,13 @@ namespace AB {
 	
 	inline static ParseVertexRet ParseVertex(const char* at) {  // after v
 		char* next;
-		float32 x = strtof(at, &next);
+		float32 x = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 y = strtof(at, &next);
+		float32 y = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 z = strtof(at, &next);
+		float32 z = ParseFloat32(at, &next);
 		assert(at != next);
 
 		return { { x, y, z }, next };
@@ -33,13 +37,13 @@ namespace AB {
 	
 	inline static ParseNormalRet ParseNormal(const char* at) {  // after v
 		char* next;
-		float32 x = strtof(at, &next);
+		float32 x = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 y = strtof(at, &next);
+		float32 y = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 z = strtof(at, &next);
+		float32 z = ParseFloat32(at, &next);
 		assert(at != next);
 
 		auto result = hpm::Normalize(hpm::Vector3{ x, y, z });
@@ -54,10 +58,10 @@ namespace AB {
 	
 	inline static ParseUVRet ParseUV(const char* at) {
 		char* next;
-		float32 u = strtof(at, &next);
+		float32 u = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 v = strtof(at, &next);
+		float32 v = ParseFloat32(at, &next);
 		assert(at != next);
 
 		return { { u, v }, next };
@@ -79,24 +83,24 @@ namespace AB {
 		ParseFaceRet result = {};
 
 		for (uint32 i = 0; i < 3; i++) {
-			result.v[i] = strtoul(at, &next, 10) - 1;
+			result.v[i] = ParseUInt32(at, &next) - 1;
 			assert(at != next);
 			at = next;
 			if (type == FaceIndexType::VertexUV || type == FaceIndexType::VertexUVNormal) {
 				while (*at == '/') at++;
-				result.uv[i] = strtoul(at, &next, 10) - 1;
+				result.uv[i] = ParseUInt32(at, &next) - 1;
 				assert(at != next);
 				at = next;
 			}
 			if (type == FaceIndexType::VertexNormal || type == FaceIndexType::VertexUVNormal) {
 				while (*at == '/') at++;
-				result.n[i] = strtoul(at, &next, 10) - 1;
+				result.n[i] = ParseUInt32(at, &next) - 1;
 				assert(at != next);
 				at = next;
 			}
 		}
 
-		strtoul(at, &next, 10);
+		ParseUInt32(at, &next);
 		assert(at == next); // Face has more than 3 vertices
 
 		result.next = at;
@@ -184,13 +188,13 @@ namespace AB {
 	
 	inline static ParseKRet ParseK(const char* at) {  // after v
 		char* next;
-		float32 r = strtof(at, &next);
+		float32 r = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 g = strtof(at, &next);
+		float32 g = ParseFloat32(at, &next);
 		assert(at != next);
 		at = next;
-		float32 b = strtof(at, &next);
+		float32 b = ParseFloat32(at, &next);
 		assert(at != next);
 
 		return { { r, g, b }, next };
@@ -472,7 +476,7 @@ namespace AB {
 		case 'i': {
 			if (memcmp(string + 1, "llum", 4) == 0) {
 				char* next = nullptr;
-				uint32 illum = strtol(string + 5, &next, 10);
+				uint32 illum = ParseUInt32(string + 5, &next);
 				assert((string + 5) != next);
 
 				result.type = MtlTokenType::Illum;
@@ -485,7 +489,7 @@ namespace AB {
 		case 'N': {
 			if (string[1] == 's') {
 				char* next = nullptr;
-				float32 shin = strtof(string + 2, &next);
+				float32 shin = ParseFloat32(string + 2, &next);
 				assert((string + 2) != next);
 
 				result.type = MtlTokenType::Shininess;
@@ -653,6 +657,8 @@ namespace AB {
 		char* name;
 		char* material_name;
 		bool32 default_group;
+		// Optional. Receives full paths of loaded mtl libraries
+		std::vector<char*>* mtl_libs;
 	};
 
 	static void ResetObjParsingState(ObjParsingState* state) {
@@ -778,7 +784,11 @@ namespace AB {
 
 			LoadMTL(full_mtl_path, material_stack);
 
-			free(full_mtl_path);
+			if (state->mtl_libs) {
+				state->mtl_libs->push_back(full_mtl_path);
+			} else {
+				free(full_mtl_path);
+			}
 		} break;
 		case ObjTokenType::Usemtl: {
 			if (state->material_name) {
@@ -790,7 +800,7 @@ namespace AB {
 		}
 	}
 
-	void ParseOBJ(const char* file_path, std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack) {
+	void ParseOBJ(const char* file_path, std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack, std::vector<char*>* mtl_libs) {
 		auto[data, size] = ReadEntireFileAsText(file_path);
 		if (data) {
 			constexpr uint32 file_dir_sz = 512;
@@ -805,11 +815,12 @@ namespace AB {
 
 				state.default_group = true;
 				state.material_name = nullptr;
+				state.mtl_libs = mtl_libs;
 
 				char* at = data;
 				if (*at != '\n') {
 					ObjToken tok = TokenizeStringObj(at);
-					HandleObjToken(&state, file_path, &tok, mesh_stack, material_stack);
+					HandleObjToken(&state, dir, &tok, mesh_stack, material_stack);
 				}
 
 				while (*at != '\0') {
@@ -830,4 +841,177 @@ namespace AB {
 			printf("Internal error."); // failed to get directory
 		}
 	}
+
+	// NOTE: Parallel parsing. File is split at line boundaries and each chunk is tokenized
+	// on its own thread. Vertex data is stored in per chunk streams, all other tokens are
+	// stored as events with stream counts at the moment they occured. Chunks are merged
+	// in order on the calling thread, so result is identical to serial ParseOBJ
+
+	// Files smaller than that are parsed serially
+	constexpr uint64 OBJ_PARALLEL_MIN_FILE_SIZE = 1024 * 1024;
+	constexpr uint32 OBJ_MAX_PARSE_THREADS = 64;
+
+	struct ObjChunkEvent {
+		ObjToken tok;
+		uint64 num_vertices;
+		uint64 num_normals;
+		uint64 num_uvs;
+		uint64 num_faces;
+	};
+
+	// This is not POD! Do not memset it to 0
+	struct ObjChunk {
+		const char* begin;
+		const char* end;
+		std::vector<hpm::Vector3> vertices;
+		std::vector<hpm::Vector3> normals;
+		std::vector<hpm::Vector2> uvs;
+		std::vector<ObjToken> faces;
+		std::vector<ObjChunkEvent> events;
+	};
+
+	static void TokenizeObjChunk(ObjChunk* chunk) {
+		const char* at = chunk->begin;
+		while (at < chunk->end) {
+			ObjToken tok = TokenizeStringObj(at);
+			switch (tok.type) {
+			case ObjTokenType::Vertex: { chunk->vertices.push_back(tok.data.vertex); } break;
+			case ObjTokenType::Normal: { chunk->normals.push_back(tok.data.normal); } break;
+			case ObjTokenType::UV: { chunk->uvs.push_back(tok.data.uv); } break;
+			case ObjTokenType::Face: { chunk->faces.push_back(tok); } break;
+			case ObjTokenType::Object:
+			case ObjTokenType::Mtllib:
+			case ObjTokenType::Usemtl: {
+				ObjChunkEvent event = {};
+				event.tok = tok;
+				event.num_vertices = chunk->vertices.size();
+				event.num_normals = chunk->normals.size();
+				event.num_uvs = chunk->uvs.size();
+				event.num_faces = chunk->faces.size();
+				chunk->events.push_back(event);
+			} break;
+			default: {} break;
+			}
+
+			// NOTE: Tokenizer may read past chunk end but only up to the end of the line
+			// which belongs to this chunk or to the next line start
+			while (at < chunk->end && *at != '\n') at++;
+			at++;
+		}
+	}
+
+	struct ObjStreamCursor {
+		uint64 vertices;
+		uint64 normals;
+		uint64 uvs;
+		uint64 faces;
+	};
+
+	static void MergeObjChunkRange(ObjParsingState* state, ObjChunk* chunk, ObjStreamCursor* cursor,
+		uint64 vertices_end, uint64 normals_end, uint64 uvs_end, uint64 faces_end, const char* obj_dir,
+		std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack) {
+
+		state->vertices.insert(state->vertices.end(), chunk->vertices.begin() + cursor->vertices, chunk->vertices.begin() + vertices_end);
+		state->normals.insert(state->normals.end(), chunk->normals.begin() + cursor->normals, chunk->normals.begin() + normals_end);
+		state->uvs.insert(state->uvs.end(), chunk->uvs.begin() + cursor->uvs, chunk->uvs.begin() + uvs_end);
+		// NOTE: Faces only depend on global index offsets which change only on events
+		// So it's safe to push them after vertex data of the range
+		for (uint64 i = cursor->faces; i < faces_end; i++) {
+			HandleObjToken(state, obj_dir, &chunk->faces[i], mesh_stack, material_stack);
+		}
+
+		cursor->vertices = vertices_end;
+		cursor->normals = normals_end;
+		cursor->uvs = uvs_end;
+		cursor->faces = faces_end;
+	}
+
+	void ParseOBJParallel(const char* file_path, std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack, uint32 num_threads, std::vector<char*>* mtl_libs) {
+		auto[data, size] = ReadEntireFileAsText(file_path);
+		if (data) {
+			constexpr uint32 file_dir_sz = 512;
+			char dir[file_dir_sz];
+			auto[success, written] = GetDirectory(file_path, dir, file_dir_sz);
+
+			if (success) {
+				uint64 text_size = strlen(data);
+				if (num_threads > OBJ_MAX_PARSE_THREADS) {
+					num_threads = OBJ_MAX_PARSE_THREADS;
+				}
+				if (text_size < OBJ_PARALLEL_MIN_FILE_SIZE || num_threads < 2) {
+					num_threads = 1;
+				}
+
+				ObjChunk* chunks = new ObjChunk[num_threads];
+				const char* chunk_begin = data;
+				const char* text_end = data + text_size;
+				for (uint32 i = 0; i < num_threads; i++) {
+					const char* chunk_end = text_end;
+					if (i != num_threads - 1) {
+						chunk_end = chunk_begin + (text_end - chunk_begin) / (num_threads - i);
+						while (chunk_end < text_end && *(chunk_end - 1) != '\n') chunk_end++;
+					}
+					chunks[i].begin = chunk_begin;
+					chunks[i].end = chunk_end;
+					chunk_begin = chunk_end;
+				}
+
+				std::thread* threads = new std::thread[num_threads];
+				for (uint32 i = 1; i < num_threads; i++) {
+					threads[i] = std::thread(TokenizeObjChunk, &chunks[i]);
+				}
+				TokenizeObjChunk(&chunks[0]);
+				for (uint32 i = 1; i < num_threads; i++) {
+					threads[i].join();
+				}
+				delete[] threads;
+
+				ObjParsingState state = ObjParsingState();
+				state.name = (char*)malloc(strlen("unnamed") + 1);
+				memcpy(state.name, "unnamed", strlen("unnamed") + 1);
+				state.default_group = true;
+				state.material_name = nullptr;
+				state.mtl_libs = mtl_libs;
+
+				// NOTE: Reserving for the whole file so merging doesn't reallocate
+				uint64 total_vertices = 0;
+				uint64 total_normals = 0;
+				uint64 total_uvs = 0;
+				uint64 total_faces = 0;
+				for (uint32 i = 0; i < num_threads; i++) {
+					total_vertices += chunks[i].vertices.size();
+					total_normals += chunks[i].normals.size();
+					total_uvs += chunks[i].uvs.size();
+					total_faces += chunks[i].faces.size();
+				}
+				state.vertices.reserve(total_vertices);
+				state.normals.reserve(total_normals);
+				state.uvs.reserve(total_uvs);
+				state.vertex_indices.reserve(total_faces * 3);
+
+				for (uint32 i = 0; i < num_threads; i++) {
+					ObjChunk* chunk = &chunks[i];
+					ObjStreamCursor cursor = {};
+					for (uint64 e = 0; e < chunk->events.size(); e++) {
+						ObjChunkEvent* event = &chunk->events[e];
+						MergeObjChunkRange(&state, chunk, &cursor, event->num_vertices, event->num_normals,
+							event->num_uvs, event->num_faces, dir, mesh_stack, material_stack);
+						HandleObjToken(&state, dir, &event->tok, mesh_stack, material_stack);
+					}
+					MergeObjChunkRange(&state, chunk, &cursor, chunk->vertices.size(), chunk->normals.size(),
+						chunk->uvs.size(), chunk->faces.size(), dir, mesh_stack, material_stack);
+				}
+				PushMesh(&state, mesh_stack);
+
+				delete[] chunks;
+			}
+			else {
+				printf("Failed to read file: %s", file_path);
+			}
+			FreeFileMemory(data);
+		}
+		else {
+			printf("Internal error."); // failed to get directory
+		}
+	}
 }
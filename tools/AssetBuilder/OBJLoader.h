@@ -44,5 +44,8 @@ namespace AB {
 
 	void FreeMesh(Mesh* mesh);
 	void LoadMTL(const char* path, std::vector<Material>* material_stack);
-	void ParseOBJ(const char* file_path, std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack);
+	// mtl_libs is optional. Receives full paths of loaded mtl libraries, caller frees them
+	void ParseOBJ(const char* file_path, std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack, std::vector<char*>* mtl_libs = nullptr);
+	// Produces the same output as ParseOBJ. Small files are parsed on the calling thread
+	void ParseOBJParallel(const char* file_path, std::vector<Mesh>* mesh_stack, std::vector<Material>* material_stack, uint32 num_threads, std::vector<char*>* mtl_libs = nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "PackBuilder.h"
+
+namespace AB {
+	static constexpr const char* PACK_FILE_EXTENSION = ".abp";
+
+	struct PackInput {
+		char* path;
+		char* name;
+	};
+
+	static const char* GetFileName(const char* path) {
+		const char* result = path;
+		for (const char* at = path; *at; at++) {
+			if (IsPathSeparator(*at)) {
+				result = at + 1;
+			}
+		}
+		return result;
+	}
+
+	static char* CopyPackName(const char* name) {
+		uint64 size = strlen(name) + 1;
+		char* result = (char*)malloc(size);
+		assert(result); // malloc failed
+		for (uint64 i = 0; i < size; i++) {
+			result[i] = name[i] == '\\' ? '/' : name[i];
+		}
+		return result;
+	}
+
+	static void CollectPackInputs(const std::vector<const char*>* inputs, std::vector<PackInput>* pack_inputs) {
+		for (uint32 i = 0; i < inputs->size(); i++) {
+			const char* input = (*inputs)[i];
+			if (IsDirectory(input)) {
+				std::vector<char*> files;
+				ListFilesRecursive(input, "", &files);
+				uint64 root_len = strlen(input);
+				for (uint32 j = 0; j < files.size(); j++) {
+					// NOTE: Never packing packs, output may be in the same directory
+					if (HasExtension(files[j], PACK_FILE_EXTENSION)) {
+						free(files[j]);
+						continue;
+					}
+					const char* name = files[j] + root_len;
+					while (IsPathSeparator(*name)) name++;
+					pack_inputs->push_back({ files[j], CopyPackName(name) });
+				}
+			} else {
+				uint64 path_size = strlen(input) + 1;
+				char* path = (char*)malloc(path_size);
+				assert(path); // malloc failed
+				memcpy(path, input, path_size);
+				pack_inputs->push_back({ path, CopyPackName(GetFileName(input)) });
+			}
+		}
+	}
+
+	static bool32 WritePadding(FILE* file, uint64 at, uint64 aligment) {
+		static const byte zeros[ABP_ENTRY_ALIGMENT] = {};
+		uint64 padding = AlignOffset(at, aligment) - at;
+		return padding == 0 || fwrite(zeros, 1, padding, file) == padding;
+	}
+
+	bool32 BuildAssetPack(const char* pack_path, const std::vector<const char*>* inputs) {
+		std::vector<PackInput> pack_inputs;
+		CollectPackInputs(inputs, &pack_inputs);
+		std::sort(pack_inputs.begin(), pack_inputs.end(), [](const PackInput& a, const PackInput& b) { return strcmp(a.name, b.name) < 0; });
+
+		bool32 result = pack_inputs.size() != 0;
+		if (!result) {
+			printf("Nothing to pack.\n");
+		}
+		for (uint32 i = 1; i < pack_inputs.size() && result; i++) {
+			if (strcmp(pack_inputs[i - 1].name, pack_inputs[i].name) == 0) {
+				printf("Duplicate pack entry name: %s\n", pack_inputs[i].name);
+				result = false;
+			}
+		}
+
+		uint32 entry_count = (uint32)pack_inputs.size();
+		uint32 toc_capacity = 1;
+		while (toc_capacity < entry_count * 2) {
+			toc_capacity <<= 1;
+		}
+
+		FILE* file = nullptr;
+		if (result) {
+			file = fopen(pack_path, "wb");
+			if (!file) {
+				printf("Failed to open file for writing: %s\n", pack_path);
+				result = false;
+			}
+		}
+
+		ABPackEntry* toc = (ABPackEntry*)calloc(toc_capacity, sizeof(ABPackEntry));
+		assert(toc); // calloc failed
+		uint64 names_size = 0;
+		uint64 data_size = 0;
+
+		if (result) {
+			ABPackHeader header = {};
+			// NOTE: Header is rewritten when offsets are known
+			result = fwrite(&header, sizeof(ABPackHeader), 1, file) == 1;
+			uint64 at = sizeof(ABPackHeader);
+
+			for (uint32 i = 0; i < entry_count && result; i++) {
+				PackInput* input = &pack_inputs[i];
+				FILE* input_file = fopen(input->path, "rb");
+				if (!input_file) {
+					printf("Failed to read file: %s\n", input->path);
+					result = false;
+					break;
+				}
+
+				result = WritePadding(file, at, ABP_ENTRY_ALIGMENT);
+				at = AlignOffset(at, ABP_ENTRY_ALIGMENT);
+
+				ABPackEntry entry = {};
+				entry.name_hash = ABPackHashName(input->name);
+				entry.offset = at;
+				entry.compression = ABP_COMPRESSION_NONE;
+				entry.name_offset = (uint32)names_size;
+
+				byte buffer[64 * 1024];
+				uint64 read = fread(buffer, 1, sizeof(buffer), input_file);
+				while (read && result) {
+					result = fwrite(buffer, 1, read, file) == read;
+					entry.size += read;
+					read = fread(buffer, 1, sizeof(buffer), input_file);
+				}
+				fclose(input_file);
+				entry.uncompressed_size = entry.size;
+				at += entry.size;
+				data_size += entry.size;
+				names_size += strlen(input->name) + 1;
+
+				uint32 slot = (uint32)(entry.name_hash & (toc_capacity - 1));
+				while (toc[slot].name_hash) {
+					slot = (slot + 1) & (toc_capacity - 1);
+				}
+				toc[slot] = entry;
+			}
+
+			ABPackHeader* h = &header;
+			h->magic_value = ABP_FILE_MAGIC_VALUE;
+			h->version = ABP_FILE_VERSION;
+			h->entry_count = entry_count;
+			h->toc_capacity = toc_capacity;
+			h->toc_offset = AlignOffset(at, AAB_SECTION_ALIGMENT);
+			h->names_offset = h->toc_offset + toc_capacity * sizeof(ABPackEntry);
+			h->names_size = names_size;
+
+			if (result) {
+				result = WritePadding(file, at, AAB_SECTION_ALIGMENT);
+				result = result && fwrite(toc, sizeof(ABPackEntry), toc_capacity, file) == toc_capacity;
+				for (uint32 i = 0; i < entry_count && result; i++) {
+					uint64 name_size = strlen(pack_inputs[i].name) + 1;
+					result = fwrite(pack_inputs[i].name, 1, name_size, file) == name_size;
+				}
+				result = result && fseek(file, 0, SEEK_SET) == 0;
+				result = result && fwrite(h, sizeof(ABPackHeader), 1, file) == 1;
+			}
+			result = (fclose(file) == 0) && result;
+			if (!result) {
+				printf("Failed to write pack: %s\n", pack_path);
+			}
+		}
+
+		if (result) {
+			printf("Packed %u files (%.2f MB) into %s\n", entry_count, (float64)data_size / (1024.0 * 1024.0), pack_path);
+		}
+
+		free(toc);
+		for (uint32 i = 0; i < pack_inputs.size(); i++) {
+			free(pack_inputs[i].path);
+			free(pack_inputs[i].name);
+		}
+		return result;
+	}
+}
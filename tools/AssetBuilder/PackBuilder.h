@@ -0,0 +1,7 @@
+#pragma once
+
+namespace AB {
+	// Packs files into single ABP archive. Directories are added recursively with names
+	// relative to the directory, single files are added by file name. See ABPackHeader
+	bool32 BuildAssetPack(const char* pack_path, const std::vector<const char*>* inputs);
+}
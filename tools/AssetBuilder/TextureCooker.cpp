@@ -0,0 +1,474 @@
+#include "TextureCooker.h"
+#include "../../aberration/utils/ImageLoader.h"
+#include "../../aberration/utils/PixelSwizzle.h"
+#include <xmmintrin.h>
+
+namespace AB {
+	// Number of least squares refinements of BC1 endpoints
+	static constexpr uint32 BC1_REFINE_ITERATIONS = 2;
+	static constexpr uint32 BMP_COMPRESSION_RGB = 0;
+	static constexpr uint32 BMP_COMPRESSION_BITFIELDS = 3;
+
+	struct BMPLayout {
+		uint32 width;
+		uint32 height;
+		uint32 bits_per_pixel;
+		bool32 bottom_up;
+		// Row size with padding
+		uint64 stride;
+		uint64 pixels_offset;
+	};
+
+	// NOTE: RGBA8 texels. Rows go bottom to top like in BMP, same as the runtime uploads them
+	struct CookerImage {
+		uint32 width;
+		uint32 height;
+		bool32 has_alpha;
+		byte* texels;
+	};
+
+	static bool32 ParseBMPLayout(const byte* data, uint64 size, const char* path, BMPLayout* layout) {
+		*layout = {};
+		if (size < sizeof(BMPHeader) + sizeof(BMPInfoHeaderCore) || data[0] != 'B' || data[1] != 'M') {
+			printf("Not a BMP file: %s\n", path);
+			return false;
+		}
+		const BMPHeader* header = (const BMPHeader*)data;
+		const BMPInfoHeaderCore* core = (const BMPInfoHeaderCore*)(data + sizeof(BMPHeader));
+		int32 width = 0;
+		int32 height = 0;
+		uint32 bits_per_pixel = 0;
+		uint32 compression = BMP_COMPRESSION_RGB;
+		if (core->structSize == sizeof(BMPInfoHeaderCore)) {
+			width = core->width;
+			height = core->height;
+			bits_per_pixel = core->bitsPerPixel;
+		} else if (core->structSize >= sizeof(BMPInfoHeaderV3) && size >= sizeof(BMPHeader) + sizeof(BMPInfoHeaderV3)) {
+			const BMPInfoHeaderV3* v3 = (const BMPInfoHeaderV3*)core;
+			width = v3->width;
+			height = v3->height;
+			bits_per_pixel = v3->bitsPerPixel;
+			compression = v3->compression;
+		}
+
+		bool32 bottom_up = height > 0;
+		height = height < 0 ? -height : height;
+		if (width <= 0 || height <= 0 || width > 0xffff || height > 0xffff ||
+			(bits_per_pixel != 24 && bits_per_pixel != 32) ||
+			(compression != BMP_COMPRESSION_RGB && compression != BMP_COMPRESSION_BITFIELDS)) {
+			printf("Unsupported BMP format: %s\n", path);
+			return false;
+		}
+
+		// NOTE: Rows are padded to 4 bytes
+		uint64 stride = ((uint64)width * (bits_per_pixel / 8) + 3) & ~3ull;
+		if (header->offsetToBitmap + stride * height > size) {
+			printf("BMP file is truncated: %s\n", path);
+			return false;
+		}
+
+		layout->width = (uint32)width;
+		layout->height = (uint32)height;
+		layout->bits_per_pixel = bits_per_pixel;
+		layout->bottom_up = bottom_up;
+		layout->stride = stride;
+		layout->pixels_offset = header->offsetToBitmap;
+		return true;
+	}
+
+	static bool32 DecodeBMPToRGBA(const byte* data, uint64 size, const char* path, CookerImage* image) {
+		*image = {};
+		BMPLayout layout;
+		if (!ParseBMPLayout(data, size, path, &layout)) {
+			return false;
+		}
+
+		image->width = layout.width;
+		image->height = layout.height;
+		image->texels = (byte*)malloc((uint64)layout.width * layout.height * 4);
+		assert(image->texels); // malloc failed
+		PixelSwizzleKernel kernel = PixelSwizzleBestKernel();
+		for (uint32 y = 0; y < image->height; y++) {
+			uint32 src_row = layout.bottom_up ? y : image->height - 1 - y;
+			const byte* src = data + layout.pixels_offset + src_row * layout.stride;
+			byte* dst = image->texels + (uint64)y * image->width * 4;
+			if (layout.bits_per_pixel == 32) {
+				memcpy(dst, src, (uint64)image->width * 4);
+				SwapRedBlue32(dst, image->width, kernel);
+				for (uint32 x = 0; x < image->width; x++) {
+					image->has_alpha |= dst[x * 4 + 3] != 255;
+				}
+			} else {
+				ExpandBGRToRGBA(src, dst, image->width, kernel);
+			}
+		}
+		return true;
+	}
+
+	static float32 SRGBToLinear(float32 c) {
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float32 LinearToSRGB(float32 c) {
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	static byte UnitToByte(float32 value) {
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return (byte)(value * 255.0f + 0.5f);
+	}
+
+	// NOTE: Mips are filtered in float. Color is linear for sRGB textures, so the chain doesn't darken
+	static void TexelsToFloat(const byte* texels, uint64 count, bool32 srgb, float32* dest) {
+		float32 to_linear[256];
+		for (uint32 i = 0; i < 256; i++) {
+			to_linear[i] = srgb ? SRGBToLinear(i / 255.0f) : i / 255.0f;
+		}
+		for (uint64 i = 0; i < count; i++) {
+			dest[i * 4 + 0] = to_linear[texels[i * 4 + 0]];
+			dest[i * 4 + 1] = to_linear[texels[i * 4 + 1]];
+			dest[i * 4 + 2] = to_linear[texels[i * 4 + 2]];
+			dest[i * 4 + 3] = texels[i * 4 + 3] / 255.0f;
+		}
+	}
+
+	static void FloatToTexels(const float32* src, uint64 count, bool32 srgb, byte* texels) {
+		for (uint64 i = 0; i < count; i++) {
+			for (uint32 c = 0; c < 3; c++) {
+				float32 value = src[i * 4 + c];
+				texels[i * 4 + c] = UnitToByte(srgb ? LinearToSRGB(value < 0.0f ? 0.0f : value) : value);
+			}
+			texels[i * 4 + 3] = UnitToByte(src[i * 4 + 3]);
+		}
+	}
+
+	// NOTE: 2x2 box filter, one RGBA texel per SSE register. Last output row and column take all remaining
+	// source texels, which is 3 for odd sizes and 1 for size 1, so edge texels of odd sizes are not dropped
+	static void DownsampleTexels(const float32* src, uint32 src_width, uint32 src_height, float32* dest, uint32 dest_width, uint32 dest_height) {
+		for (uint32 y = 0; y < dest_height; y++) {
+			uint32 y0 = y * 2;
+			uint32 rows = y + 1 < dest_height ? 2 : src_height - y0;
+			float32* dest_row = dest + (uint64)y * dest_width * 4;
+			for (uint32 x = 0; x < dest_width; x++) {
+				uint32 x0 = x * 2;
+				uint32 columns = x + 1 < dest_width ? 2 : src_width - x0;
+				__m128 sum = _mm_setzero_ps();
+				for (uint32 r = 0; r < rows; r++) {
+					const float32* row = src + ((uint64)(y0 + r) * src_width + x0) * 4;
+					for (uint32 c = 0; c < columns; c++) {
+						sum = _mm_add_ps(sum, _mm_loadu_ps(row + c * 4));
+					}
+				}
+				_mm_storeu_ps(dest_row + x * 4, _mm_mul_ps(sum, _mm_set1_ps(1.0f / (float32)(rows * columns))));
+			}
+		}
+	}
+
+	static uint16 PackRGB565(const float32* color) {
+		uint32 r = (uint32)(color[0] * (31.0f / 255.0f) + 0.5f);
+		uint32 g = (uint32)(color[1] * (63.0f / 255.0f) + 0.5f);
+		uint32 b = (uint32)(color[2] * (31.0f / 255.0f) + 0.5f);
+		return (uint16)((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRGB565(uint16 packed, float32* color) {
+		uint32 r = (packed >> 11) & 31;
+		uint32 g = (packed >> 5) & 63;
+		uint32 b = packed & 31;
+		color[0] = (float32)((r << 3) | (r >> 2));
+		color[1] = (float32)((g << 2) | (g >> 4));
+		color[2] = (float32)((b << 3) | (b >> 2));
+	}
+
+	static void ClampColor(float32* color) {
+		for (uint32 c = 0; c < 3; c++) {
+			color[c] = color[c] < 0.0f ? 0.0f : (color[c] > 255.0f ? 255.0f : color[c]);
+		}
+	}
+
+	// NOTE: Picks nearest of 4 interpolated colors for every texel. Returns squared error
+	static float32 FitBC1Indices(const float32 (*texels)[3], uint16 c0, uint16 c1, uint32* indices) {
+		float32 palette[4][3];
+		UnpackRGB565(c0, palette[0]);
+		UnpackRGB565(c1, palette[1]);
+		for (uint32 c = 0; c < 3; c++) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+		float32 error = 0.0f;
+		*indices = 0;
+		for (uint32 i = 0; i < 16; i++) {
+			uint32 best = 0;
+			float32 best_dist = FLT_MAX;
+			for (uint32 p = 0; p < 4; p++) {
+				float32 dr = texels[i][0] - palette[p][0];
+				float32 dg = texels[i][1] - palette[p][1];
+				float32 db = texels[i][2] - palette[p][2];
+				float32 dist = dr * dr + dg * dg + db * db;
+				if (dist < best_dist) {
+					best_dist = dist;
+					best = p;
+				}
+			}
+			error += best_dist;
+			*indices |= best << (i * 2);
+		}
+		return error;
+	}
+
+	// NOTE: Endpoints are the extent of texels along their principal axis, then they are refined
+	// by least squares fit to the chosen indices. Always uses 4 color mode
+	static void EncodeBC1Block(const byte* block, byte* out) {
+		float32 texels[16][3];
+		float32 mean[3] = {};
+		for (uint32 i = 0; i < 16; i++) {
+			for (uint32 c = 0; c < 3; c++) {
+				texels[i][c] = block[i * 4 + c];
+				mean[c] += texels[i][c] / 16.0f;
+			}
+		}
+
+		float32 cov[6] = {};
+		for (uint32 i = 0; i < 16; i++) {
+			float32 r = texels[i][0] - mean[0];
+			float32 g = texels[i][1] - mean[1];
+			float32 b = texels[i][2] - mean[2];
+			cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+			cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+		}
+		// NOTE: Power iteration
+		float32 axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (uint32 iter = 0; iter < 8; iter++) {
+			float32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			float32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			float32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			float32 m = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+			if (m < 1e-6f) {
+				break;
+			}
+			axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+		}
+		float32 axis_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		float32 t_min = 0.0f;
+		float32 t_max = 0.0f;
+		for (uint32 i = 0; i < 16; i++) {
+			float32 t = ((texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2]) / axis_sq;
+			t_min = t < t_min ? t : t_min;
+			t_max = t > t_max ? t : t_max;
+		}
+		float32 e0[3];
+		float32 e1[3];
+		for (uint32 c = 0; c < 3; c++) {
+			e0[c] = mean[c] + axis[c] * t_max;
+			e1[c] = mean[c] + axis[c] * t_min;
+		}
+		ClampColor(e0);
+		ClampColor(e1);
+
+		uint16 c0 = PackRGB565(e0);
+		uint16 c1 = PackRGB565(e1);
+		uint32 indices;
+		float32 error = FitBC1Indices(texels, c0, c1, &indices);
+
+		for (uint32 iter = 0; iter < BC1_REFINE_ITERATIONS && error > 0.0f; iter++) {
+			// NOTE: Texel is w * e0 + (1 - w) * e1
+			const float32 weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+			float32 aa = 0.0f, bb = 0.0f, ab = 0.0f;
+			float32 ap[3] = {};
+			float32 bp[3] = {};
+			for (uint32 i = 0; i < 16; i++) {
+				float32 w = weights[(indices >> (i * 2)) & 3];
+				aa += w * w;
+				bb += (1.0f - w) * (1.0f - w);
+				ab += w * (1.0f - w);
+				for (uint32 c = 0; c < 3; c++) {
+					ap[c] += w * texels[i][c];
+					bp[c] += (1.0f - w) * texels[i][c];
+				}
+			}
+			float32 det = aa * bb - ab * ab;
+			if (fabsf(det) < 1e-6f) {
+				break;
+			}
+			for (uint32 c = 0; c < 3; c++) {
+				e0[c] = (ap[c] * bb - bp[c] * ab) / det;
+				e1[c] = (bp[c] * aa - ap[c] * ab) / det;
+			}
+			ClampColor(e0);
+			ClampColor(e1);
+			uint16 refined_c0 = PackRGB565(e0);
+			uint16 refined_c1 = PackRGB565(e1);
+			uint32 refined_indices;
+			float32 refined_error = FitBC1Indices(texels, refined_c0, refined_c1, &refined_indices);
+			if (refined_error >= error) {
+				break;
+			}
+			c0 = refined_c0;
+			c1 = refined_c1;
+			indices = refined_indices;
+			error = refined_error;
+		}
+
+		// NOTE: c0 > c1 selects 4 color mode. Swapping endpoints swaps indices 0 <-> 1 and 2 <-> 3
+		if (c0 < c1) {
+			uint16 tmp = c0;
+			c0 = c1;
+			c1 = tmp;
+			indices ^= 0x55555555;
+		} else if (c0 == c1) {
+			indices = 0;
+		}
+		memcpy(out + 0, &c0, sizeof(uint16));
+		memcpy(out + 2, &c1, sizeof(uint16));
+		memcpy(out + 4, &indices, sizeof(uint32));
+	}
+
+	// NOTE: 8 alpha mode with block min and max as endpoints
+	static void EncodeBC3AlphaBlock(const byte* block, byte* out) {
+		uint32 a0 = 0;
+		uint32 a1 = 255;
+		for (uint32 i = 0; i < 16; i++) {
+			uint32 a = block[i * 4 + 3];
+			a0 = a > a0 ? a : a0;
+			a1 = a < a1 ? a : a1;
+		}
+		uint64 indices = 0;
+		if (a0 != a1) {
+			float32 palette[8];
+			palette[0] = (float32)a0;
+			palette[1] = (float32)a1;
+			for (uint32 k = 2; k < 8; k++) {
+				palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7.0f;
+			}
+			for (uint32 i = 0; i < 16; i++) {
+				float32 a = block[i * 4 + 3];
+				uint64 best = 0;
+				float32 best_dist = FLT_MAX;
+				for (uint32 k = 0; k < 8; k++) {
+					float32 dist = fabsf(a - palette[k]);
+					if (dist < best_dist) {
+						best_dist = dist;
+						best = k;
+					}
+				}
+				indices |= best << (i * 3);
+			}
+		}
+		out[0] = (byte)a0;
+		out[1] = (byte)a1;
+		for (uint32 i = 0; i < 6; i++) {
+			out[2 + i] = (byte)(indices >> (i * 8));
+		}
+	}
+
+	// NOTE: Texels outside of the image are clamped to the edge
+	static void EncodeBlocks(const byte* texels, uint32 width, uint32 height, uint32 format, byte* out) {
+		uint32 block_size = ABTBlockSize(format);
+		for (uint32 by = 0; by < (height + 3) / 4; by++) {
+			for (uint32 bx = 0; bx < (width + 3) / 4; bx++) {
+				byte block[16 * 4];
+				for (uint32 y = 0; y < 4; y++) {
+					uint32 ty = by * 4 + y < height ? by * 4 + y : height - 1;
+					for (uint32 x = 0; x < 4; x++) {
+						uint32 tx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+						memcpy(block + (y * 4 + x) * 4, texels + ((uint64)ty * width + tx) * 4, 4);
+					}
+				}
+				if (format == ABT_FORMAT_BC3) {
+					EncodeBC3AlphaBlock(block, out);
+					EncodeBC1Block(block, out + 8);
+				} else {
+					EncodeBC1Block(block, out);
+				}
+				out += block_size;
+			}
+		}
+	}
+
+	bool32 CookTexture(const char* bmp_path, const char* out_path, bool32 srgb, bool32 compress) {
+		auto[data, size] = ReadEntireFile(bmp_path);
+		if (!data) {
+			printf("Failed to read texture: %s\n", bmp_path);
+			return false;
+		}
+		CookerImage image;
+		bool32 decoded = DecodeBMPToRGBA((const byte*)data, size, bmp_path, &image);
+		FreeFileMemory(data);
+		if (!decoded) {
+			return false;
+		}
+
+		uint32 format = image.has_alpha ? ABT_FORMAT_BC3 : ABT_FORMAT_BC1;
+		uint32 mip_count = ABTFullMipCount(image.width, image.height);
+		uint64 data_size = 0;
+		for (uint32 level = 0; level < mip_count; level++) {
+			data_size += ABTMipSize(format, image.width, image.height, level);
+		}
+		uint64 file_size = ABT_DATA_ALIGMENT + data_size;
+		byte* file_buffer = (byte*)calloc(file_size, 1);
+		assert(file_buffer); // malloc failed
+
+		ABTHeader* header = (ABTHeader*)file_buffer;
+		header->magic_value = ABT_FILE_MAGIC_VALUE;
+		header->version = ABT_FILE_VERSION;
+		header->format = format;
+		header->flags = srgb ? (uint32)ABT_FLAG_SRGB : 0;
+		header->width = image.width;
+		header->height = image.height;
+		header->mip_count = mip_count;
+		header->data_offset = ABT_DATA_ALIGMENT;
+		header->data_size = data_size;
+
+		uint64 texel_count = (uint64)image.width * image.height;
+		float32* level_texels = (float32*)malloc(texel_count * 4 * sizeof(float32));
+		float32* next_texels = (float32*)malloc(texel_count * 4 * sizeof(float32));
+		byte* level_bytes = (byte*)malloc(texel_count * 4);
+		assert(level_texels && next_texels && level_bytes); // malloc failed
+		TexelsToFloat(image.texels, texel_count, srgb, level_texels);
+
+		byte* at = file_buffer + ABT_DATA_ALIGMENT;
+		for (uint32 level = 0; level < mip_count; level++) {
+			uint32 width = ABTMipDimension(image.width, level);
+			uint32 height = ABTMipDimension(image.height, level);
+			if (level) {
+				uint32 prev_width = ABTMipDimension(image.width, level - 1);
+				uint32 prev_height = ABTMipDimension(image.height, level - 1);
+				DownsampleTexels(level_texels, prev_width, prev_height, next_texels, width, height);
+				float32* tmp = level_texels;
+				level_texels = next_texels;
+				next_texels = tmp;
+				FloatToTexels(level_texels, (uint64)width * height, srgb, level_bytes);
+			}
+			// NOTE: Top level is encoded from source texels so it doesn't get conversion error
+			EncodeBlocks(level ? level_bytes : image.texels, width, height, format, at);
+			at += ABTMipSize(format, image.width, image.height, level);
+		}
+
+		free(level_texels);
+		free(next_texels);
+		free(level_bytes);
+		free(image.texels);
+
+		printf("Cooked texture %s: %ux%u, %u mips, %s, %llu -> %llu bytes\n", out_path, image.width, image.height, mip_count,
+			format == ABT_FORMAT_BC3 ? "BC3" : "BC1", (unsigned long long)(texel_count * 4), (unsigned long long)data_size);
+
+		if (compress) {
+			uint64 compressed_capacity = ABZCompressBound(file_size);
+			byte* compressed = (byte*)malloc(compressed_capacity);
+			assert(compressed); // malloc failed
+			uint64 compressed_size = ABZCompress(file_buffer, file_size, compressed, compressed_capacity);
+			assert(compressed_size); // Compression failed
+			free(file_buffer);
+			file_buffer = compressed;
+			file_size = compressed_size;
+		}
+
+		assert(file_size < 0xffffffff); // Can`t write bigger than 4gb
+		bool32 result = WriteFile(out_path, file_buffer, (uint32)file_size);
+		if (!result) {
+			printf("Failed to write texture: %s\n", out_path);
+		}
+		free(file_buffer);
+		return result;
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace AB {
+	// Cooks 24 or 32 bit BMP into ABT texture (see FileFormats.h) with full mip chain.
+	// Mips of sRGB textures are filtered in linear space. Images with any non opaque texel are encoded to BC3,
+	// others to BC1. Output is ABZ compressed if compress is true. Returns false if bitmap can't be read
+	bool32 CookTexture(const char* bmp_path, const char* out_path, bool32 srgb, bool32 compress);
+}
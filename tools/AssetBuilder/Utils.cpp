@@ -2,6 +2,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <vector>
+
+// NOTE: Text files are padded with zeros after the terminator so parsers can read them in blocks
+constexpr uint32 TEXT_FILE_PADDING = 16;
 
 inline uint32 SafeTruncateU64U32(uint64 val) {
 	assert(val <= 0xffffffff);
@@ -54,6 +58,61 @@ GetDirectoryRet GetDirectory(const char* file_path, char* buffer, uint32 buffer_
 }
 
 
+static bool32 IsPathSeparator(char c) {
+	return c == '/' || c == '\\';
+}
+
+// NOTE: Case insensitive. extension includes the dot
+static bool32 HasExtension(const char* file_name, const char* extension) {
+	uint64 name_len = strlen(file_name);
+	uint64 ext_len = strlen(extension);
+	if (name_len < ext_len) {
+		return false;
+	}
+	const char* at = file_name + name_len - ext_len;
+	for (uint64 i = 0; i < ext_len; i++) {
+		char a = at[i] >= 'A' && at[i] <= 'Z' ? at[i] - 'A' + 'a' : at[i];
+		char b = extension[i] >= 'A' && extension[i] <= 'Z' ? extension[i] - 'A' + 'a' : extension[i];
+		if (a != b) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// NOTE: Returns malloc'ed dir + separator + name
+static char* JoinPath(const char* dir, const char* name, char separator) {
+	uint64 dir_len = strlen(dir);
+	uint64 name_len = strlen(name);
+	char* path = (char*)malloc(dir_len + name_len + 2);
+	assert(path); // malloc failed
+	memcpy(path, dir, dir_len);
+	if (dir_len && !IsPathSeparator(dir[dir_len - 1])) {
+		path[dir_len] = separator;
+		dir_len++;
+	}
+	memcpy(path + dir_len, name, name_len + 1);
+	return path;
+}
+
+// NOTE: Returns malloc'ed path with extension after the last dot of file name replaced. extension includes the dot
+static char* ReplaceExtension(const char* path, const char* extension) {
+	uint64 path_len = strlen(path);
+	uint64 stem_len = path_len;
+	for (uint64 i = path_len; i > 0 && !IsPathSeparator(path[i - 1]); i--) {
+		if (path[i - 1] == '.') {
+			stem_len = i - 1;
+			break;
+		}
+	}
+	uint64 ext_len = strlen(extension);
+	char* result = (char*)malloc(stem_len + ext_len + 1);
+	assert(result); // malloc failed
+	memcpy(result, path, stem_len);
+	memcpy(result + stem_len, extension, ext_len + 1);
+	return result;
+}
+
 #if defined(AB_PLATFORM_WINDOWS)
 #include <windows.h>
 
@@ -115,7 +174,7 @@ ReadFileAsTextRet ReadEntireFileAsText(const char* filename) {
 				CloseHandle(fileHandle);
 				return { nullptr, 0 };
 			}
-			void* bitmap = malloc(fileSize.QuadPart + 1);
+			void* bitmap = malloc(fileSize.QuadPart + 1 + TEXT_FILE_PADDING);
 			if (bitmap) {
 				DWORD read;
 				if (!ReadFile(fileHandle, bitmap, (DWORD)fileSize.QuadPart, &read, 0) && !(read == (DWORD)fileSize.QuadPart)) {
@@ -125,7 +184,7 @@ ReadFileAsTextRet ReadEntireFileAsText(const char* filename) {
 				}
 				else {
 					string = (char*)bitmap;
-					string[fileSize.QuadPart] = '\0';
+					memset(string + fileSize.QuadPart, 0, 1 + TEXT_FILE_PADDING);
 					bytesRead = (uint32)fileSize.QuadPart + 1;
 				}
 			}
@@ -148,10 +207,43 @@ bool32 WriteFile(const char* filename, void* data, uint32 dataSize) {
 	return false;
 }
 
+bool32 IsDirectory(const char* path) {
+	DWORD attributes = GetFileAttributesA(path);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// NOTE: Appends malloc'ed paths of all files with given extension. Caller frees them
+void ListFilesRecursive(const char* dir, const char* extension, std::vector<char*>* files) {
+	char* pattern = JoinPath(dir, "*", '\\');
+	WIN32_FIND_DATAA find_data;
+	HANDLE find_handle = FindFirstFileA(pattern, &find_data);
+	free(pattern);
+	if (find_handle != INVALID_HANDLE_VALUE) {
+		do {
+			const char* name = find_data.cFileName;
+			if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+				continue;
+			}
+			char* path = JoinPath(dir, name, '\\');
+			if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+				ListFilesRecursive(path, extension, files);
+				free(path);
+			} else if (HasExtension(name, extension)) {
+				files->push_back(path);
+			} else {
+				free(path);
+			}
+		} while (FindNextFileA(find_handle, &find_data));
+		FindClose(find_handle);
+	}
+}
+
 #elif defined(AB_PLATFORM_LINUX)
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 void FreeFileMemory(void* memory) {
 	if (memory) {
@@ -230,16 +322,16 @@ ReadFileAsTextRet ReadEntireFileAsText(const char* filename) {
 	char* ptr = nullptr;
 	uint32 bytesRead = 0;
 	int fileHandle = open(filename, O_RDONLY);
-	if (fileHandle) {
+	if (fileHandle != -1) {
 		off_t fileEnd = lseek(fileHandle, 0, SEEK_END);
-		if (fileEnd) {
+		if (fileEnd > 0) {
 			lseek(fileHandle, 0, SEEK_SET);
-			void* data = std::malloc(fileEnd + 1);
+			void* data = std::malloc(fileEnd + 1 + TEXT_FILE_PADDING);
 			if (data) {
 				ssize_t result = read(fileHandle, data, fileEnd);
 				if (result == fileEnd) {
 					ptr = (char*)data;
-					ptr[fileEnd + 1] = '\0';
+					memset(ptr + fileEnd, 0, 1 + TEXT_FILE_PADDING);
 					// NOTE: read can read less than fileEnd bytes
 					bytesRead = (uint32)(fileEnd + 1);
 				}
@@ -264,6 +356,35 @@ ReadFileAsTextRet ReadEntireFileAsText(const char* filename) {
 	return {ptr, bytesRead};
 }
 
+bool32 IsDirectory(const char* path) {
+	struct stat path_stat;
+	return stat(path, &path_stat) == 0 && S_ISDIR(path_stat.st_mode);
+}
+
+// NOTE: Appends malloc'ed paths of all files with given extension. Caller frees them
+void ListFilesRecursive(const char* dir, const char* extension, std::vector<char*>* files) {
+	DIR* dir_handle = opendir(dir);
+	if (dir_handle) {
+		struct dirent* entry = readdir(dir_handle);
+		while (entry) {
+			const char* name = entry->d_name;
+			if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+				char* path = JoinPath(dir, name, '/');
+				if (IsDirectory(path)) {
+					ListFilesRecursive(path, extension, files);
+					free(path);
+				} else if (HasExtension(name, extension)) {
+					files->push_back(path);
+				} else {
+					free(path);
+				}
+			}
+			entry = readdir(dir_handle);
+		}
+		closedir(dir_handle);
+	}
+}
+
 #else
 #error Unsupported platform.
 #endif
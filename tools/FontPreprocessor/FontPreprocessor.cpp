@@ -22,6 +22,8 @@ typedef float           float32;
 typedef double          float64;
 typedef uintptr_t       uintptr;
 
+#include "../../aberration/Compression.h"
+
 #if defined(AB_PLATFORM_WINDOWS)
 #include <windows.h>
 
@@ -154,6 +156,7 @@ Flags:
 -b : number of the first char (ASCII code)
 -c : number of chars to handle
 -o : output file name.
+-z : compress output file.
 )";
 
 #define MAX_BITMAP_WIDTH 4096
@@ -177,6 +180,7 @@ struct CommandLineArgs {
     int32 numChars;
     const char* filepath;
 	const char* filename;
+	bool32 compress;
 };
 
 enum class ArgType {
@@ -258,6 +262,9 @@ static CommandLineArgs ParseCommandLineArgs(int argc, char** argv) {
 						const char* str = &arg[2];
 						parameters.filename = str;
 					} break;
+					case 'z': { // compress output
+						parameters.compress = true;
+					} break;
 					default: {
 					    printf("Unknown argument: %s\n", arg);
 					} break;
@@ -470,6 +477,17 @@ int main(int argc, char** argv) {
 		}
 		assert((byte*)kernTableFileAt == (byte*)(out + bitmapOffset));
 
+		if (args.compress) {
+			uint64 compressedCapacity = AB::ABZCompressBound(fileSize);
+			byte* compressed = (byte*)malloc(compressedCapacity);
+			uint64 compressedSize = AB::ABZCompress(out, fileSize, compressed, compressedCapacity);
+			assert(compressedSize); // Compression failed
+			printf("Compressed font bitmap: %u -> %u bytes\n", fileSize, (uint32)compressedSize);
+			free(out);
+			out = compressed;
+			fileSize = (uint32)compressedSize;
+		}
+
 		DebugWriteFile("arial.abf", out, (uint32)fileSize);
 	}
 }